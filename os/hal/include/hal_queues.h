@@ -353,6 +353,10 @@ extern "C" {
   msg_t iqGetTimeout(input_queue_t *iqp, systime_t time);
   size_t iqReadTimeout(input_queue_t *iqp, uint8_t *bp,
                        size_t n, systime_t time);
+  size_t iqGetReadSpanI(input_queue_t *iqp, uint8_t **bpp);
+  void iqConsumeI(input_queue_t *iqp, size_t n);
+  size_t iqGetWriteSpanI(input_queue_t *iqp, uint8_t **bpp);
+  void iqCommitI(input_queue_t *iqp, size_t n);
 
   void oqObjectInit(output_queue_t *oqp, uint8_t *bp, size_t size,
                     qnotify_t onfy, void *link);
@@ -361,6 +365,10 @@ extern "C" {
   msg_t oqGetI(output_queue_t *oqp);
   size_t oqWriteTimeout(output_queue_t *oqp, const uint8_t *bp,
                         size_t n, systime_t time);
+  size_t oqGetWriteSpanI(output_queue_t *oqp, uint8_t **bpp);
+  void oqCommitI(output_queue_t *oqp, size_t n);
+  size_t oqGetReadSpanI(output_queue_t *oqp, uint8_t **bpp);
+  void oqConsumeI(output_queue_t *oqp, size_t n);
 #ifdef __cplusplus
 }
 #endif
@@ -388,15 +396,139 @@ extern "C" {
 #define iqPutI(iqp, b)                      chIQPutI(iqp, b)
 #define iqGetTimeout(iqp, time)             chIQGetTimeout(iqp, time)
 #define iqReadTimeout(iqp, bp, n, time)     chIQReadTimeout(iqp, bp, n, time)
+#define iqGetReadSpanI(iqp, bpp)            chIQGetReadSpanI(iqp, bpp)
+#define iqConsumeI(iqp, n)                  chIQConsumeI(iqp, n)
+#define iqGetWriteSpanI(iqp, bpp)           chIQGetWriteSpanI(iqp, bpp)
+#define iqCommitI(iqp, n)                   chIQCommitI(iqp, n)
 #define oqObjectInit(oqp, bp, size, onfy, link)                             \
   chOQObjectInit(oqp, bp, size, onfy, link)
 #define oqResetI(oqp)                       chOQResetI(oqp)
 #define oqPutTimeout(oqp, b, time)          chOQPutTimeout(oqp, b, time)
 #define oqGetI(oqp)                         chOQGetI(oqp)
 #define oqWriteTimeout(oqp, bp, n, time)    chOQWriteTimeout(oqp, bp, n, time)
+#define oqGetWriteSpanI(oqp, bpp)           chOQGetWriteSpanI(oqp, bpp)
+#define oqCommitI(oqp, n)                   chOQCommitI(oqp, n)
+#define oqGetReadSpanI(oqp, bpp)            chOQGetReadSpanI(oqp, bpp)
+#define oqConsumeI(oqp, n)                  chOQConsumeI(oqp, n)
 
 #endif /* defined(_CHIBIOS_RT_) && CH_CFG_USE_QUEUES */
 
+/**
+ * @brief   Type of a single producer, single consumer byte ring.
+ * @details The producer is an ISR and the consumer is a thread, each side
+ *          only writes its own index so that neither side needs to lock
+ *          the kernel in order to move data. The consumer is woken only
+ *          when the amount of data reaches the watermark.
+ */
+typedef struct {
+  volatile uint8_t      *br_buffer; /**< @brief Pointer to the ring buffer.*/
+  size_t                br_size;    /**< @brief Size of the buffer, it is
+                                         a power of two.                    */
+  size_t                br_watermark;
+                                    /**< @brief Consumer wakeup threshold.  */
+  volatile size_t       br_head;    /**< @brief Write index, free running,
+                                         written by the producer only.      */
+  volatile size_t       br_tail;    /**< @brief Read index, free running,
+                                         written by the consumer only.      */
+  volatile size_t       br_dropped; /**< @brief Bytes lost on ring full.    */
+  thread_reference_t    br_thread;  /**< @brief Waiting consumer.           */
+} byte_ring_t;
+
+/**
+ * @name    Byte ring macro functions
+ * @{
+ */
+/**
+ * @brief   Returns the size of a byte ring.
+ *
+ * @param[in] brp       pointer to a @p byte_ring_t structure
+ * @return              The size of the ring buffer.
+ *
+ * @xclass
+ */
+#define brGetSizeX(brp) ((brp)->br_size)
+
+/**
+ * @brief   Returns the filled space of a byte ring.
+ * @note    The value can only grow while the consumer examines it and can
+ *          only shrink while the producer examines it.
+ *
+ * @param[in] brp       pointer to a @p byte_ring_t structure
+ * @return              The number of bytes in the ring.
+ *
+ * @xclass
+ */
+#define brGetFullX(brp) ((size_t)((brp)->br_head - (brp)->br_tail))
+
+/**
+ * @brief   Evaluates to @p TRUE if the specified byte ring is empty.
+ *
+ * @param[in] brp       pointer to a @p byte_ring_t structure
+ * @return              The ring status.
+ * @retval FALSE        if the ring is not empty.
+ * @retval TRUE         if the ring is empty.
+ *
+ * @xclass
+ */
+#define brIsEmptyX(brp) ((bool)(brGetFullX(brp) == 0U))
+
+/**
+ * @brief   Returns the number of bytes dropped because the ring was full.
+ *
+ * @param[in] brp       pointer to a @p byte_ring_t structure
+ * @return              The number of dropped bytes.
+ *
+ * @xclass
+ */
+#define brGetDroppedX(brp) ((brp)->br_dropped)
+/** @} */
+
+/**
+ * @brief   Data part of a static byte ring initializer.
+ * @details This macro should be used when statically initializing a
+ *          byte ring that is part of a bigger structure.
+ *
+ * @param[in] name      the name of the byte ring variable
+ * @param[in] buffer    pointer to the ring buffer area
+ * @param[in] size      size of the ring buffer area, a power of two
+ * @param[in] watermark consumer wakeup threshold
+ */
+#define _BYTERING_DATA(name, buffer, size, watermark) {                     \
+  (uint8_t *)(buffer),                                                      \
+  (size),                                                                   \
+  (watermark),                                                              \
+  0,                                                                        \
+  0,                                                                        \
+  0,                                                                        \
+  NULL                                                                      \
+}
+
+/**
+ * @brief   Static byte ring initializer.
+ * @details Statically initialized byte rings require no explicit
+ *          initialization using @p brObjectInit().
+ *
+ * @param[in] name      the name of the byte ring variable
+ * @param[in] buffer    pointer to the ring buffer area
+ * @param[in] size      size of the ring buffer area, a power of two
+ * @param[in] watermark consumer wakeup threshold
+ */
+#define BYTERING_DECL(name, buffer, size, watermark)                        \
+  byte_ring_t name = _BYTERING_DATA(name, buffer, size, watermark)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void brObjectInit(byte_ring_t *brp, uint8_t *bp, size_t size,
+                    size_t watermark);
+  msg_t brPutX(byte_ring_t *brp, uint8_t b);
+  size_t brWriteX(byte_ring_t *brp, const uint8_t *bp, size_t n);
+  size_t brReadTimeout(byte_ring_t *brp, uint8_t *bp,
+                       size_t n, systime_t time);
+#ifdef __cplusplus
+}
+#endif
+
 #endif /* _HAL_QUEUES_H_ */
 
 /** @} */
@@ -171,6 +171,7 @@ extern "C" {
   size_t i2cSlaveGetTxOffset(I2CDriver *i2cp);
   void i2cSlaveSetTxOffset(I2CDriver *i2cp, size_t offset);
   size_t i2cSlaveGetRxOffset(I2CDriver *i2cp);
+  void i2cSlaveSetErrorCallback(I2CDriver *i2cp, TI2cSlaveErrorCb errcb);
 
 #endif /* I2C_ISE_SLAVE_MODE */
 
@@ -452,7 +452,7 @@ static void i2c_lld_serve_error_interrupt(I2CDriver *i2cp, uint16_t sr) {
   }
 #if I2C_USE_SLAVE_MODE
   }
-  else {
+  else if (sr & I2C_SR1_AF) {
     /* In slave mode it is not an error it is end of slave transfer.
        Just clear AF flag.*/
     i2cp->i2c->SR1 &= ~I2C_SR1_AF;
@@ -478,8 +478,14 @@ static void i2c_lld_serve_error_interrupt(I2CDriver *i2cp, uint16_t sr) {
     i2cp->errors |= I2C_SMB_ALERT;
 
   /* If some error has been identified then sends wakes the waiting thread.*/
-  if (i2cp->errors != I2C_NO_ERROR)
+  if (i2cp->errors != I2C_NO_ERROR) {
+#if I2C_USE_SLAVE_MODE
+    /* Nobody waits on a slave, so tell the user the bus needs attention.*/
+    if (i2cp->slave_mode && i2cp->errcb)
+      i2cp->errcb(i2cp, i2cp->errors);
+#endif
     _i2c_wakeup_error_isr(i2cp);
+  }
 }
 
 /*===========================================================================*/
@@ -1116,6 +1122,10 @@ void i2c_lld_slave_set_tx_offset(I2CDriver *i2cp, size_t offset) {
 size_t i2c_lld_slave_get_rx_offset(I2CDriver *i2cp) {
   return i2cp->rxind;
 }
+
+void i2c_lld_slave_set_error_cb(I2CDriver *i2cp, TI2cSlaveErrorCb errcb) {
+  i2cp->errcb = errcb;
+}
 #endif
 
 #endif /* HAL_USE_I2C */
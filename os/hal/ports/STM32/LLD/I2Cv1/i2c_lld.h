@@ -404,6 +404,7 @@ typedef struct I2CDriver I2CDriver;
 #if I2C_USE_SLAVE_MODE
     typedef void (* TI2cSlaveCb)(I2CDriver * i2cp, size_t bytes);
     typedef void (* TI2cSlaveStartCb)(I2CDriver * i2cp);
+    typedef void (* TI2cSlaveErrorCb)(I2CDriver * i2cp, i2cflags_t errors);
 #endif
 
 /**
@@ -475,6 +476,8 @@ struct I2CDriver {
   TI2cSlaveCb               txcb;
 
   TI2cSlaveStartCb          startcb;
+
+  TI2cSlaveErrorCb          errcb;
 #endif
 };
 
@@ -533,6 +536,7 @@ extern "C" {
   size_t i2c_lld_slave_get_tx_offset(I2CDriver *i2cp);
   void i2c_lld_slave_set_tx_offset(I2CDriver *i2cp, size_t offset);
   size_t i2c_lld_slave_get_rx_offset(I2CDriver *i2cp);
+  void i2c_lld_slave_set_error_cb(I2CDriver *i2cp, TI2cSlaveErrorCb errcb);
 #endif
 #ifdef __cplusplus
 }
@@ -35,14 +35,85 @@
  *          - <b>Full duplex queue</b>, bidirectional queue. Full duplex queues
  *            are implemented by pairing an input queue and an output queue
  *            together.
+ *          - <b>Byte ring</b>, unidirectional ring where the writer is an
+ *            ISR and the reader is a single thread. Writing does not lock
+ *            the kernel, the reader is woken only when the data reaches a
+ *            watermark. Byte rings are meant for high rate streams where
+ *            the per byte cost of an input queue matters.
  *          .
  * @{
  */
 
+#include <string.h>
+
 #include "hal.h"
 
 #if !defined(_CHIBIOS_RT_) || !CH_CFG_USE_QUEUES || defined(__DOXYGEN__)
 
+/**
+ * @brief   Non-blocking input queue read.
+ * @details The data is copied with at most two block copies, the second
+ *          one is needed when the data wraps around the buffer end.
+ *
+ * @param[in] iqp       pointer to an @p input_queue_t structure
+ * @param[out] bp       pointer to the data buffer
+ * @param[in] n         the maximum amount of data to be transferred
+ * @return              The number of bytes effectively transferred.
+ *
+ * @notapi
+ */
+static size_t iq_read(input_queue_t *iqp, uint8_t *bp, size_t n) {
+  size_t s1;
+
+  if (n > iqp->q_counter)
+    n = iqp->q_counter;
+
+  s1 = (size_t)(iqp->q_top - iqp->q_rdptr);
+  if (n < s1) {
+    memcpy(bp, iqp->q_rdptr, n);
+    iqp->q_rdptr += n;
+  }
+  else {
+    memcpy(bp, iqp->q_rdptr, s1);
+    memcpy(bp + s1, iqp->q_buffer, n - s1);
+    iqp->q_rdptr = iqp->q_buffer + (n - s1);
+  }
+  iqp->q_counter -= n;
+  return n;
+}
+
+/**
+ * @brief   Non-blocking output queue write.
+ * @details The data is copied with at most two block copies, the second
+ *          one is needed when the data wraps around the buffer end.
+ *
+ * @param[in] oqp       pointer to an @p output_queue_t structure
+ * @param[in] bp        pointer to the data buffer
+ * @param[in] n         the maximum amount of data to be transferred
+ * @return              The number of bytes effectively transferred.
+ *
+ * @notapi
+ */
+static size_t oq_write(output_queue_t *oqp, const uint8_t *bp, size_t n) {
+  size_t s1;
+
+  if (n > oqp->q_counter)
+    n = oqp->q_counter;
+
+  s1 = (size_t)(oqp->q_top - oqp->q_wrptr);
+  if (n < s1) {
+    memcpy(oqp->q_wrptr, bp, n);
+    oqp->q_wrptr += n;
+  }
+  else {
+    memcpy(oqp->q_wrptr, bp, s1);
+    memcpy(oqp->q_buffer, bp + s1, n - s1);
+    oqp->q_wrptr = oqp->q_buffer + (n - s1);
+  }
+  oqp->q_counter -= n;
+  return n;
+}
+
 /**
  * @brief   Initializes an input queue.
  * @details A Semaphore is internally initialized and works as a counter of
@@ -172,8 +243,10 @@ msg_t iqGetTimeout(input_queue_t *iqp, systime_t time) {
  *          been reset.
  * @note    The function is not atomic, if you need atomicity it is suggested
  *          to use a semaphore or a mutex for mutual exclusion.
- * @note    The callback is invoked before reading each character from the
- *          buffer or before entering the state @p THD_STATE_WTQUEUE.
+ * @note    The data available in the queue is copied in blocks, the system
+ *          lock is held for at most the copy of a full queue buffer.
+ * @note    The callback is invoked before reading each block of data from
+ *          the buffer or before entering the state @p THD_STATE_WTQUEUE.
  *
  * @param[in] iqp       pointer to an @p input_queue_t structure
  * @param[out] bp       pointer to the data buffer
@@ -197,6 +270,8 @@ size_t iqReadTimeout(input_queue_t *iqp, uint8_t *bp,
 
   osalSysLock();
   while (TRUE) {
+    size_t done;
+
     if (nfy)
       nfy(iqp);
 
@@ -207,20 +282,120 @@ size_t iqReadTimeout(input_queue_t *iqp, uint8_t *bp,
       }
     }
 
-    iqp->q_counter--;
-    *bp++ = *iqp->q_rdptr++;
-    if (iqp->q_rdptr >= iqp->q_top)
-      iqp->q_rdptr = iqp->q_buffer;
+    done = iq_read(iqp, bp, n);
 
     osalSysUnlock(); /* Gives a preemption chance in a controlled point.*/
-    r++;
-    if (--n == 0)
+    r += done;
+    bp += done;
+    n -= done;
+    if (n == 0)
       return r;
 
     osalSysLock();
   }
 }
 
+/**
+ * @brief   Returns the contiguous data at the read end of an input queue.
+ * @details The data can be read in place, for example by @p memcpy() or a
+ *          DMA transfer, and then removed from the queue using
+ *          @p iqConsumeI(). The data wrapping around the buffer end is
+ *          returned by a second call after the consume.
+ *
+ * @param[in] iqp       pointer to an @p input_queue_t structure
+ * @param[out] bpp      pointer to the start of the span
+ * @return              The size of the span.
+ * @retval 0            if the queue is empty.
+ *
+ * @iclass
+ */
+size_t iqGetReadSpanI(input_queue_t *iqp, uint8_t **bpp) {
+  size_t n;
+
+  osalDbgCheckClassI();
+
+  n = (size_t)(iqp->q_top - iqp->q_rdptr);
+  *bpp = iqp->q_rdptr;
+  return iqp->q_counter < n ? iqp->q_counter : n;
+}
+
+/**
+ * @brief   Removes data read in place from an input queue.
+ * @note    The callback is invoked after the data has been removed.
+ *
+ * @param[in] iqp       pointer to an @p input_queue_t structure
+ * @param[in] n         number of bytes to remove, it must not exceed the
+ *                      size returned by @p iqGetReadSpanI()
+ *
+ * @iclass
+ */
+void iqConsumeI(input_queue_t *iqp, size_t n) {
+
+  osalDbgCheckClassI();
+  osalDbgCheck((n <= iqp->q_counter) &&
+             (n <= (size_t)(iqp->q_top - iqp->q_rdptr)));
+
+  iqp->q_counter -= n;
+  iqp->q_rdptr += n;
+  if (iqp->q_rdptr >= iqp->q_top)
+    iqp->q_rdptr = iqp->q_buffer;
+
+  if (iqp->q_notify)
+    iqp->q_notify(iqp);
+}
+
+/**
+ * @brief   Returns the contiguous free space at the write end of an input
+ *          queue.
+ * @details The space can be filled in place by a driver, for example by a
+ *          DMA transfer, and then appended to the queue using
+ *          @p iqCommitI().
+ *
+ * @param[in] iqp       pointer to an @p input_queue_t structure
+ * @param[out] bpp      pointer to the start of the span
+ * @return              The size of the span.
+ * @retval 0            if the queue is full.
+ *
+ * @iclass
+ */
+size_t iqGetWriteSpanI(input_queue_t *iqp, uint8_t **bpp) {
+  size_t n, empty;
+
+  osalDbgCheckClassI();
+
+  n = (size_t)(iqp->q_top - iqp->q_wrptr);
+  empty = qSizeI(iqp) - iqp->q_counter;
+  *bpp = iqp->q_wrptr;
+  return empty < n ? empty : n;
+}
+
+/**
+ * @brief   Appends data written in place to an input queue.
+ * @details The threads waiting for data are resumed.
+ *
+ * @param[in] iqp       pointer to an @p input_queue_t structure
+ * @param[in] n         number of bytes to append, it must not exceed the
+ *                      size returned by @p iqGetWriteSpanI()
+ *
+ * @iclass
+ */
+void iqCommitI(input_queue_t *iqp, size_t n) {
+
+  osalDbgCheckClassI();
+  osalDbgCheck((n <= qSizeI(iqp) - iqp->q_counter) &&
+             (n <= (size_t)(iqp->q_top - iqp->q_wrptr)));
+
+  if (n == 0)
+    return;
+
+  iqp->q_counter += n;
+  iqp->q_wrptr += n;
+  if (iqp->q_wrptr >= iqp->q_top)
+    iqp->q_wrptr = iqp->q_buffer;
+
+  osalThreadDequeueAllI(&iqp->q_waiting, Q_OK);
+}
+
 /**
  * @brief   Initializes an output queue.
  * @details A Semaphore is internally initialized and works as a counter of
@@ -350,8 +525,11 @@ msg_t oqGetI(output_queue_t *oqp) {
  *          been reset.
  * @note    The function is not atomic, if you need atomicity it is suggested
  *          to use a semaphore or a mutex for mutual exclusion.
- * @note    The callback is invoked after writing each character into the
- *          buffer.
+ * @note    The data is copied in blocks as long as there is space in the
+ *          queue, the system lock is held for at most the copy of a full
+ *          queue buffer.
+ * @note    The callback is invoked after writing each block of data into
+ *          the buffer.
  *
  * @param[in] oqp       pointer to an @p output_queue_t structure
  * @param[out] bp       pointer to the data buffer
@@ -375,28 +553,299 @@ size_t oqWriteTimeout(output_queue_t *oqp, const uint8_t *bp,
 
   osalSysLock();
   while (TRUE) {
+    size_t done;
+
     while (oqIsFullI(oqp)) {
       if (osalThreadEnqueueTimeoutS(&oqp->q_waiting, time) != Q_OK) {
         osalSysUnlock();
         return w;
       }
     }
-    oqp->q_counter--;
-    *oqp->q_wrptr++ = *bp++;
-    if (oqp->q_wrptr >= oqp->q_top)
-      oqp->q_wrptr = oqp->q_buffer;
+    done = oq_write(oqp, bp, n);
 
     if (nfy)
       nfy(oqp);
 
     osalSysUnlock(); /* Gives a preemption chance in a controlled point.*/
-    w++;
-    if (--n == 0)
+    w += done;
+    bp += done;
+    n -= done;
+    if (n == 0)
       return w;
     osalSysLock();
   }
 }
 
+/**
+ * @brief   Returns the contiguous free space at the write end of an output
+ *          queue.
+ * @details The space can be filled in place and then appended to the queue
+ *          using @p oqCommitI(). The space wrapping around the buffer end
+ *          is returned by a second call after the commit.
+ *
+ * @param[in] oqp       pointer to an @p output_queue_t structure
+ * @param[out] bpp      pointer to the start of the span
+ * @return              The size of the span.
+ * @retval 0            if the queue is full.
+ *
+ * @iclass
+ */
+size_t oqGetWriteSpanI(output_queue_t *oqp, uint8_t **bpp) {
+  size_t n;
+
+  osalDbgCheckClassI();
+
+  n = (size_t)(oqp->q_top - oqp->q_wrptr);
+  *bpp = oqp->q_wrptr;
+  return oqp->q_counter < n ? oqp->q_counter : n;
+}
+
+/**
+ * @brief   Appends data written in place to an output queue.
+ * @note    The callback is invoked after the data has been appended.
+ *
+ * @param[in] oqp       pointer to an @p output_queue_t structure
+ * @param[in] n         number of bytes to append, it must not exceed the
+ *                      size returned by @p oqGetWriteSpanI()
+ *
+ * @iclass
+ */
+void oqCommitI(output_queue_t *oqp, size_t n) {
+
+  osalDbgCheckClassI();
+  osalDbgCheck((n <= oqp->q_counter) &&
+             (n <= (size_t)(oqp->q_top - oqp->q_wrptr)));
+
+  oqp->q_counter -= n;
+  oqp->q_wrptr += n;
+  if (oqp->q_wrptr >= oqp->q_top)
+    oqp->q_wrptr = oqp->q_buffer;
+
+  if (oqp->q_notify)
+    oqp->q_notify(oqp);
+}
+
+/**
+ * @brief   Returns the contiguous data at the read end of an output queue.
+ * @details The data can be transmitted in place by a driver, for example
+ *          by a DMA transfer, and then removed from the queue using
+ *          @p oqConsumeI().
+ *
+ * @param[in] oqp       pointer to an @p output_queue_t structure
+ * @param[out] bpp      pointer to the start of the span
+ * @return              The size of the span.
+ * @retval 0            if the queue is empty.
+ *
+ * @iclass
+ */
+size_t oqGetReadSpanI(output_queue_t *oqp, uint8_t **bpp) {
+  size_t n, full;
+
+  osalDbgCheckClassI();
+
+  n = (size_t)(oqp->q_top - oqp->q_rdptr);
+  full = qSizeI(oqp) - oqp->q_counter;
+  *bpp = oqp->q_rdptr;
+  return full < n ? full : n;
+}
+
+/**
+ * @brief   Removes data transmitted in place from an output queue.
+ * @details The threads waiting for space are resumed.
+ *
+ * @param[in] oqp       pointer to an @p output_queue_t structure
+ * @param[in] n         number of bytes to remove, it must not exceed the
+ *                      size returned by @p oqGetReadSpanI()
+ *
+ * @iclass
+ */
+void oqConsumeI(output_queue_t *oqp, size_t n) {
+
+  osalDbgCheckClassI();
+  osalDbgCheck((n <= qSizeI(oqp) - oqp->q_counter) &&
+             (n <= (size_t)(oqp->q_top - oqp->q_rdptr)));
+
+  if (n == 0)
+    return;
+
+  oqp->q_counter += n;
+  oqp->q_rdptr += n;
+  if (oqp->q_rdptr >= oqp->q_top)
+    oqp->q_rdptr = oqp->q_buffer;
+
+  osalThreadDequeueAllI(&oqp->q_waiting, Q_OK);
+}
+
 #endif /* !defined(_CHIBIOS_RT_) || !CH_USE_QUEUES */
 
+/**
+ * @brief   Wakes up the byte ring consumer, if waiting.
+ * @note    The consumer registers itself while the kernel is locked and
+ *          after checking the ring, the producer cannot run in between so
+ *          testing the reference without locking is safe.
+ *
+ * @param[in] brp       pointer to a @p byte_ring_t structure
+ *
+ * @notapi
+ */
+static void br_wakeup(byte_ring_t *brp) {
+  syssts_t sts;
+
+  if (brp->br_thread == NULL)
+    return;
+
+  sts = osalSysGetStatusAndLockX();
+  osalThreadResumeI(&brp->br_thread, MSG_OK);
+  osalSysRestoreStatusX(sts);
+}
+
+/**
+ * @brief   Initializes a byte ring.
+ * @note    The ring must not be in use by either side while initialized.
+ *
+ * @param[out] brp      pointer to a @p byte_ring_t structure
+ * @param[in] bp        pointer to a memory area allocated as ring buffer
+ * @param[in] size      size of the ring buffer, it must be a power of two
+ * @param[in] watermark number of bytes that wakes up the consumer, a value
+ *                      of one wakes it up on each byte
+ *
+ * @init
+ */
+void brObjectInit(byte_ring_t *brp, uint8_t *bp, size_t size,
+                  size_t watermark) {
+
+  osalDbgCheck((brp != NULL) && (bp != NULL) &&
+               (size > 0U) && ((size & (size - 1U)) == 0U) &&
+               (watermark > 0U) && (watermark <= size));
+
+  brp->br_buffer = bp;
+  brp->br_size = size;
+  brp->br_watermark = watermark;
+  brp->br_head = 0;
+  brp->br_tail = 0;
+  brp->br_dropped = 0;
+  brp->br_thread = NULL;
+}
+
+/**
+ * @brief   Byte ring write.
+ * @details This function is meant to be called by the producer ISR, it
+ *          costs a store and an index update, the kernel is locked only
+ *          when the consumer is waiting and the watermark is reached.
+ * @note    If the ring is full the byte is dropped and counted.
+ * @note    When invoked from thread context the consumer, if woken and of
+ *          higher priority, preempts the caller before the function
+ *          returns.
+ *
+ * @param[in] brp       pointer to a @p byte_ring_t structure
+ * @param[in] b         the byte value to be written in the ring
+ * @return              The operation status.
+ * @retval Q_OK         if the operation has been completed with success.
+ * @retval Q_FULL       if the ring is full and the byte has been dropped.
+ *
+ * @special
+ */
+msg_t brPutX(byte_ring_t *brp, uint8_t b) {
+  size_t head = brp->br_head;
+  size_t full = head - brp->br_tail;
+
+  if (full >= brp->br_size) {
+    brp->br_dropped++;
+    return Q_FULL;
+  }
+
+  brp->br_buffer[head & (brp->br_size - 1U)] = b;
+  brp->br_head = head + 1U;
+  if (full + 1U == brp->br_watermark)
+    br_wakeup(brp);
+
+  return Q_OK;
+}
+
+/**
+ * @brief   Byte ring block write.
+ * @details Same as @p brPutX() for a block of data, for producers that
+ *          receive more than a byte per interrupt (FIFOs, DMA).
+ * @note    The bytes that do not fit in the ring are dropped and counted.
+ *
+ * @param[in] brp       pointer to a @p byte_ring_t structure
+ * @param[in] bp        pointer to the data buffer
+ * @param[in] n         the number of bytes to be written
+ * @return              The number of bytes effectively written.
+ *
+ * @special
+ */
+size_t brWriteX(byte_ring_t *brp, const uint8_t *bp, size_t n) {
+  size_t head = brp->br_head;
+  size_t full = head - brp->br_tail;
+  size_t mask = brp->br_size - 1U;
+  size_t i;
+
+  if (n > brp->br_size - full) {
+    brp->br_dropped += n - (brp->br_size - full);
+    n = brp->br_size - full;
+  }
+
+  for (i = 0; i < n; i++)
+    brp->br_buffer[(head + i) & mask] = bp[i];
+  brp->br_head = head + n;
+  if ((full < brp->br_watermark) && (full + n >= brp->br_watermark))
+    br_wakeup(brp);
+
+  return n;
+}
+
+/**
+ * @brief   Byte ring read with timeout.
+ * @details The function reads up to @p n bytes from the ring. If fewer
+ *          than @p n bytes are available and the watermark has not been
+ *          reached then the caller sleeps until the watermark is reached
+ *          or the timeout expires, whatever is then available is read.
+ * @note    Only one thread can read from a byte ring.
+ *
+ * @param[in] brp       pointer to a @p byte_ring_t structure
+ * @param[out] bp       pointer to the data buffer
+ * @param[in] n         the maximum amount of data to be transferred
+ * @param[in] time      the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The number of bytes effectively transferred.
+ *
+ * @api
+ */
+size_t brReadTimeout(byte_ring_t *brp, uint8_t *bp,
+                     size_t n, systime_t time) {
+  size_t tail, full, mask, i;
+
+  osalDbgCheck((brp != NULL) && (bp != NULL) && (n > 0U));
+
+  if (time != TIME_IMMEDIATE) {
+    osalSysLock();
+    full = brGetFullX(brp);
+    if ((full < n) && (full < brp->br_watermark)) {
+      (void) osalThreadSuspendTimeoutS(&brp->br_thread, time);
+
+      /* On timeout the reference is not guaranteed to be cleared.*/
+      brp->br_thread = NULL;
+    }
+    osalSysUnlock();
+  }
+
+  /* The producer may add data while it is being copied, the indexes are
+     sampled once and the buffer is accessed as volatile so that the
+     compiler cannot move the copy across the index updates.*/
+  tail = brp->br_tail;
+  full = brp->br_head - tail;
+  mask = brp->br_size - 1U;
+  if (n > full)
+    n = full;
+  for (i = 0; i < n; i++)
+    bp[i] = brp->br_buffer[(tail + i) & mask];
+  brp->br_tail = tail + n;
+
+  return n;
+}
+
 /** @} */
@@ -321,6 +321,23 @@ size_t i2cSlaveGetRxOffset(I2CDriver *i2cp) {
   return i2c_lld_slave_get_rx_offset(i2cp);
 }
 
+/**
+ * @brief   Sets the callback invoked on bus errors while in slave mode.
+ * @details The callback runs from the error ISR, it is the only way to
+ *          learn about a misbehaving bus since no thread waits on a slave.
+ *
+ * @param[in] i2cp      pointer to the @p I2CDriver object
+ * @param[in] errcb     error callback, @p NULL to disable it
+ *
+ * @api
+ */
+void i2cSlaveSetErrorCallback(I2CDriver *i2cp, TI2cSlaveErrorCb errcb) {
+
+  osalSysLock();
+  i2c_lld_slave_set_error_cb(i2cp, errcb);
+  osalSysUnlock();
+}
+
 #endif /* I2C_ISE_SLAVE_MODE */
 
 #endif /* HAL_USE_I2C */
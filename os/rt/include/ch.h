@@ -90,6 +90,7 @@ typedef struct thread thread_t;
 #include "chmemcore.h"
 #include "chheap.h"
 #include "chmempools.h"
+#include "chslab.h"
 #include "chdynamic.h"
 #include "chqueues.h"
 #include "chstreams.h"
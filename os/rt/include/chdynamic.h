@@ -81,6 +81,10 @@ extern "C" {
   thread_t *chThdCreateFromMemoryPool(memory_pool_t *mp, tprio_t prio,
                                       tfunc_t pf, void *arg);
 #endif
+#if CH_CFG_USE_SLABS
+  thread_t *chThdCreateFromSlab(slab_cache_t *scp, tprio_t prio,
+                                tfunc_t pf, void *arg);
+#endif
 #ifdef __cplusplus
 }
 #endif
@@ -39,6 +39,59 @@
 /* Module pre-compile time settings.                                         */
 /*===========================================================================*/
 
+/**
+ * @brief   Segregated fit heap allocator.
+ * @details If enabled the heap keeps its free blocks into size classes
+ *          lists and coalesces them on release, allocation and release
+ *          take a constant time instead of walking the free list.
+ * @note    The default is @p FALSE.
+ */
+#ifndef CH_CFG_USE_HEAP_TLSF
+#define CH_CFG_USE_HEAP_TLSF                FALSE
+#endif
+
+/**
+ * @brief   Number of first level size classes.
+ * @details Each first level class covers a power of two, blocks must be
+ *          smaller than @p CH_HEAP_TLSF_MAX_SIZE.
+ */
+#ifndef CH_CFG_HEAP_TLSF_FL_COUNT
+#define CH_CFG_HEAP_TLSF_FL_COUNT           12
+#endif
+
+/**
+ * @brief   Number of second level size classes, as a power of two.
+ * @details Each power of two range is split in this number of linear
+ *          classes, the size wasted by the allocation rounding is at most
+ *          1/2^CH_CFG_HEAP_TLSF_SL_BITS of the block.
+ */
+#ifndef CH_CFG_HEAP_TLSF_SL_BITS
+#define CH_CFG_HEAP_TLSF_SL_BITS            2
+#endif
+
+/**
+ * @brief   Heap statistics.
+ * @details If enabled each heap keeps running counters of its allocated
+ *          bytes, peak, allocations, failures and largest free block, see
+ *          @p chHeapGetStats().
+ * @note    The default is @p FALSE.
+ */
+#ifndef CH_CFG_HEAP_STATS
+#define CH_CFG_HEAP_STATS                   FALSE
+#endif
+
+/**
+ * @brief   Number of heap owner tags.
+ * @details If not zero each allocated block records the owner tag of the
+ *          allocating thread, see @p chHeapSetTagX(), and each heap counts
+ *          the bytes allocated under each tag. Zero disables the feature.
+ * @note    The block header grows by the tag field.
+ * @note    Requires @p CH_CFG_HEAP_STATS.
+ */
+#ifndef CH_CFG_HEAP_TAGS
+#define CH_CFG_HEAP_TAGS                    0
+#endif
+
 /*===========================================================================*/
 /* Derived constants and error checks.                                       */
 /*===========================================================================*/
@@ -51,6 +104,51 @@
 #error "CH_CFG_USE_HEAP requires CH_CFG_USE_MUTEXES and/or CH_CFG_USE_SEMAPHORES"
 #endif
 
+#if (CH_CFG_HEAP_TAGS > 0) && !CH_CFG_HEAP_STATS
+#error "CH_CFG_HEAP_TAGS requires CH_CFG_HEAP_STATS"
+#endif
+
+#if (CH_CFG_HEAP_TAGS < 0) || (CH_CFG_HEAP_TAGS > 256)
+#error "invalid CH_CFG_HEAP_TAGS value specified"
+#endif
+
+/**
+ * @brief   Number of bins of the free blocks histogram.
+ * @details The first bin counts the blocks below 32 bytes, each following
+ *          bin doubles the size and the last one has no upper bound.
+ */
+#define CH_HEAP_FRAG_BINS       8
+
+#if CH_CFG_USE_HEAP_TLSF || defined(__DOXYGEN__)
+#if (CH_CFG_HEAP_TLSF_SL_BITS < 1) || (CH_CFG_HEAP_TLSF_SL_BITS > 5)
+#error "invalid CH_CFG_HEAP_TLSF_SL_BITS value specified"
+#endif
+
+#if (CH_CFG_HEAP_TLSF_FL_COUNT < 2) ||                                      \
+    (CH_CFG_HEAP_TLSF_FL_COUNT + CH_CFG_HEAP_TLSF_SL_BITS > 30)
+#error "invalid CH_CFG_HEAP_TLSF_FL_COUNT value specified"
+#endif
+
+/**
+ * @brief   Number of second level classes for each first level class.
+ */
+#define CH_HEAP_TLSF_SL_COUNT   (1U << CH_CFG_HEAP_TLSF_SL_BITS)
+
+/**
+ * @brief   Size limit of a heap block, exclusive.
+ */
+#define CH_HEAP_TLSF_MAX_SIZE                                               \
+  ((size_t)MEM_ALIGN_SIZE <<                                                \
+   (CH_CFG_HEAP_TLSF_FL_COUNT + CH_CFG_HEAP_TLSF_SL_BITS - 1))
+
+/**
+ * @brief   Counts the leading zeros of a non-zero 32 bits word.
+ */
+#if !defined(port_clz) || defined(__DOXYGEN__)
+#define port_clz(w)         ((unsigned)__builtin_clz(w))
+#endif
+#endif /* CH_CFG_USE_HEAP_TLSF */
+
 /*===========================================================================*/
 /* Module data structures and types.                                         */
 /*===========================================================================*/
@@ -62,6 +160,8 @@ typedef struct memory_heap memory_heap_t;
 
 /**
  * @brief   Memory heap block header.
+ * @note    With @p CH_CFG_USE_HEAP_TLSF the two low bits of the size mark
+ *          a free block and a block following a free block.
  */
 union heap_header {
   stkalign_t align;
@@ -71,16 +171,66 @@ union heap_header {
       memory_heap_t     *heap;      /**< @brief Block owner heap.           */
     } u;                            /**< @brief Overlapped fields.          */
     size_t              size;       /**< @brief Size of the memory block.   */
+#if (CH_CFG_HEAP_TAGS > 0) || defined(__DOXYGEN__)
+    uint8_t             tag;        /**< @brief Owner tag of an allocated
+                                                block.                      */
+#endif
   } h;
 };
 
+#if CH_CFG_HEAP_STATS || defined(__DOXYGEN__)
+/**
+ * @brief   Heap statistics.
+ */
+typedef struct {
+  size_t                hs_used;    /**< @brief Bytes in allocated blocks,
+                                                headers included.           */
+  size_t                hs_peak;    /**< @brief Highest @p hs_used.         */
+  uint32_t              hs_allocs;  /**< @brief Successful allocations.     */
+  uint32_t              hs_frees;   /**< @brief Released blocks.            */
+  uint32_t              hs_fails;   /**< @brief Failed allocations.         */
+  size_t                hs_free;    /**< @brief Bytes in free blocks.       */
+  size_t                hs_largest; /**< @brief Largest free block.         */
+  uint16_t              hs_frags[CH_HEAP_FRAG_BINS];
+                                    /**< @brief Free blocks by size.        */
+} heap_stats_t;
+#endif
+
 /**
  * @brief   Structure describing a memory heap.
  */
 struct memory_heap {
   memgetfunc_t          h_provider; /**< @brief Memory blocks provider for
                                                 this heap.                  */
+#if CH_CFG_USE_HEAP_TLSF || defined(__DOXYGEN__)
+  uint32_t              h_flmap;    /**< @brief Non empty first level
+                                                classes mask.               */
+  uint32_t              h_slmap[CH_CFG_HEAP_TLSF_FL_COUNT];
+                                    /**< @brief Non empty second level
+                                                classes masks.              */
+  union heap_header     *h_lists[CH_CFG_HEAP_TLSF_FL_COUNT]
+                                [CH_HEAP_TLSF_SL_COUNT];
+                                    /**< @brief Free blocks lists.          */
+  union heap_header     *h_top;     /**< @brief End marker of the last
+                                                block from the provider.    */
+#else
   union heap_header     h_free;     /**< @brief Free blocks list header.    */
+#endif
+#if CH_CFG_HEAP_STATS || defined(__DOXYGEN__)
+  size_t                h_used;     /**< @brief Bytes in allocated blocks.  */
+  size_t                h_peak;     /**< @brief Highest @p h_used.          */
+  uint32_t              h_allocs;   /**< @brief Successful allocations.     */
+  uint32_t              h_frees;    /**< @brief Released blocks.            */
+  uint32_t              h_fails;    /**< @brief Failed allocations.         */
+#if !CH_CFG_USE_HEAP_TLSF || defined(__DOXYGEN__)
+  size_t                h_largest;  /**< @brief Largest free block.         */
+#endif
+#endif
+#if (CH_CFG_HEAP_TAGS > 0) || defined(__DOXYGEN__)
+  size_t                h_tagused[CH_CFG_HEAP_TAGS];
+                                    /**< @brief Bytes allocated under each
+                                                owner tag.                  */
+#endif
 #if CH_CFG_USE_MUTEXES
   mutex_t               h_mtx;      /**< @brief Heap access mutex.          */
 #else
@@ -104,6 +254,13 @@ extern "C" {
   void *chHeapAlloc(memory_heap_t *heapp, size_t size);
   void chHeapFree(void *p);
   size_t chHeapStatus(memory_heap_t *heapp, size_t *sizep);
+#if CH_CFG_HEAP_STATS
+  void chHeapGetStats(memory_heap_t *heapp, heap_stats_t *hsp);
+  void chHeapGetFreeStats(memory_heap_t *heapp, heap_stats_t *hsp);
+#endif
+#if CH_CFG_HEAP_TAGS > 0
+  size_t chHeapGetTagUsage(memory_heap_t *heapp, unsigned tag);
+#endif
 #ifdef __cplusplus
 }
 #endif
@@ -112,6 +269,23 @@ extern "C" {
 /* Module inline functions.                                                  */
 /*===========================================================================*/
 
+#if (CH_CFG_HEAP_TAGS > 0) || defined(__DOXYGEN__)
+/**
+ * @brief   Sets the owner tag of the blocks allocated by the current thread.
+ * @details New threads start with the tag zero.
+ *
+ * @param[in] tag       the owner tag, below @p CH_CFG_HEAP_TAGS
+ *
+ * @xclass
+ */
+static inline void chHeapSetTagX(unsigned tag) {
+
+  chDbgCheck(tag < CH_CFG_HEAP_TAGS);
+
+  currp->p_heaptag = (uint8_t)tag;
+}
+#endif
+
 #endif /* CH_CFG_USE_HEAP */
 
 #endif /* _CHHEAP_H_ */
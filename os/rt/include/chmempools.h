@@ -39,10 +39,25 @@
 /* Module pre-compile time settings.                                         */
 /*===========================================================================*/
 
+/**
+ * @brief   Lock-free memory pools.
+ * @details If enabled the pool free list is handled using the port
+ *          exclusive load/store primitives instead of the system lock,
+ *          the X-class functions @p chPoolAllocX() and @p chPoolFreeX()
+ *          are also made available.
+ */
+#if !defined(CH_CFG_USE_MEMPOOLS_LOCKFREE) || defined(__DOXYGEN__)
+#define CH_CFG_USE_MEMPOOLS_LOCKFREE        FALSE
+#endif
+
 #if !CH_CFG_USE_MEMCORE
 #error "CH_CFG_USE_MEMPOOLS requires CH_CFG_USE_MEMCORE"
 #endif
 
+#if CH_CFG_USE_MEMPOOLS_LOCKFREE && !PORT_SUPPORTS_EXCLUSIVE
+#error "CH_CFG_USE_MEMPOOLS_LOCKFREE requires PORT_SUPPORTS_EXCLUSIVE"
+#endif
+
 /*===========================================================================*/
 /* Derived constants and error checks.                                       */
 /*===========================================================================*/
@@ -112,6 +127,10 @@ extern "C" {
   void *chPoolAlloc(memory_pool_t *mp);
   void chPoolFreeI(memory_pool_t *mp, void *objp);
   void chPoolFree(memory_pool_t *mp, void *objp);
+#if CH_CFG_USE_MEMPOOLS_LOCKFREE
+  void *chPoolAllocX(memory_pool_t *mp);
+  void chPoolFreeX(memory_pool_t *mp, void *objp);
+#endif
 #ifdef __cplusplus
 }
 #endif
@@ -240,6 +240,10 @@ extern "C" {
   msg_t chIQGetTimeout(input_queue_t *iqp, systime_t time);
   size_t chIQReadTimeout(input_queue_t *iqp, uint8_t *bp,
                          size_t n, systime_t time);
+  size_t chIQGetReadSpanI(input_queue_t *iqp, uint8_t **bpp);
+  void chIQConsumeI(input_queue_t *iqp, size_t n);
+  size_t chIQGetWriteSpanI(input_queue_t *iqp, uint8_t **bpp);
+  void chIQCommitI(input_queue_t *iqp, size_t n);
 
   void chOQObjectInit(output_queue_t *oqp, uint8_t *bp, size_t size,
                       qnotify_t onfy, void *link);
@@ -248,6 +252,10 @@ extern "C" {
   msg_t chOQGetI(output_queue_t *oqp);
   size_t chOQWriteTimeout(output_queue_t *oqp, const uint8_t *bp,
                           size_t n, systime_t time);
+  size_t chOQGetWriteSpanI(output_queue_t *oqp, uint8_t **bpp);
+  void chOQCommitI(output_queue_t *oqp, size_t n);
+  size_t chOQGetReadSpanI(output_queue_t *oqp, uint8_t **bpp);
+  void chOQConsumeI(output_queue_t *oqp, size_t n);
 #ifdef __cplusplus
 }
 #endif
@@ -60,10 +60,146 @@
 /* Module pre-compile time settings.                                         */
 /*===========================================================================*/
 
+/**
+ * @name    Ready list settings
+ * @{
+ */
+/**
+ * @brief   Priority bitmap ready list.
+ * @details If enabled the ready list is kept as one FIFO queue per priority
+ *          level plus a bitmap of the non-empty levels, the highest ready
+ *          priority is found with a count leading zeros and threads are
+ *          made ready in constant time. If disabled a single priority
+ *          ordered queue is used, it is smaller but it is scanned on each
+ *          insertion so its cost grows with the number of ready threads.
+ * @note    The default is @p FALSE.
+ */
+#ifndef CH_CFG_USE_READY_BITMAP
+#define CH_CFG_USE_READY_BITMAP             FALSE
+#endif
+
+/**
+ * @brief   Ready list levels reduction, as a power of two.
+ * @details With zero each of the 256 priorities has its own queue, this
+ *          costs 8 bytes of RAM per priority on 32 bits architectures.
+ *          Each increment halves the number of queues, priorities sharing
+ *          a level are kept ordered and threads are inserted scanning from
+ *          the tail so equal priority threads are still inserted in
+ *          constant time.
+ * @note    The default is zero.
+ */
+#ifndef CH_CFG_READY_BITMAP_SHIFT
+#define CH_CFG_READY_BITMAP_SHIFT           0
+#endif
+/** @} */
+
+/**
+ * @name    Virtual timers settings
+ * @{
+ */
+/**
+ * @brief   Hierarchical timer wheel.
+ * @details If enabled the virtual timers are kept in a hierarchical timing
+ *          wheel instead of a delta list, arming and disarming a timer take
+ *          constant time regardless of the number of armed timers. Timers
+ *          far in the future are moved toward the lower levels of the wheel
+ *          as their deadline approaches.
+ * @note    The default is @p FALSE.
+ */
+#ifndef CH_CFG_USE_TIMER_WHEEL
+#define CH_CFG_USE_TIMER_WHEEL              FALSE
+#endif
+
+/**
+ * @brief   Timer wheel slots per level, as a power of two.
+ * @details Each level covers this many bits of the system time, wider
+ *          levels cost more RAM but move timers between levels less often.
+ * @note    The default is 4, 16 slots per level, valid values are 2..5.
+ */
+#ifndef CH_CFG_TIMER_WHEEL_BITS
+#define CH_CFG_TIMER_WHEEL_BITS             4
+#endif
+
+/**
+ * @brief   Per-thread timeout timer with lazy cancel.
+ * @details If enabled each thread embeds the virtual timer used by its
+ *          timed waits. A thread woken before the timeout leaves the timer
+ *          armed, a later timed wait keeps it if it expires no later than
+ *          the new deadline and the timer is re-armed for the remaining
+ *          time when it expires during that wait. A thread repeatedly woken
+ *          before its timeouts touches the virtual timers about once per
+ *          timeout instead of twice per wait.
+ * @note    The default is @p FALSE.
+ */
+#ifndef CH_CFG_USE_LAZY_TIMEOUTS
+#define CH_CFG_USE_LAZY_TIMEOUTS            FALSE
+#endif
+/** @} */
+
 /*===========================================================================*/
 /* Derived constants and error checks.                                       */
 /*===========================================================================*/
 
+#if CH_CFG_USE_READY_BITMAP || defined(__DOXYGEN__)
+#if (CH_CFG_READY_BITMAP_SHIFT < 0) || (CH_CFG_READY_BITMAP_SHIFT > 7)
+#error "invalid CH_CFG_READY_BITMAP_SHIFT value"
+#endif
+
+/**
+ * @brief   Number of ready list levels.
+ */
+#define CH_RLIST_LEVELS     (256U >> CH_CFG_READY_BITMAP_SHIFT)
+
+/**
+ * @brief   Number of 32 bits words in the ready list bitmap.
+ */
+#define CH_RLIST_WORDS      ((CH_RLIST_LEVELS + 31U) / 32U)
+
+#endif /* CH_CFG_USE_READY_BITMAP */
+
+#if CH_CFG_USE_TIMER_WHEEL || defined(__DOXYGEN__)
+#if (CH_CFG_TIMER_WHEEL_BITS < 2) || (CH_CFG_TIMER_WHEEL_BITS > 5)
+#error "invalid CH_CFG_TIMER_WHEEL_BITS value"
+#endif
+
+/**
+ * @brief   Number of slots in each timer wheel level.
+ */
+#define CH_VT_WHEEL_SLOTS   (1U << CH_CFG_TIMER_WHEEL_BITS)
+
+/**
+ * @brief   Number of timer wheel levels, enough to cover the system time.
+ */
+#define CH_VT_WHEEL_LEVELS                                                  \
+  ((CH_CFG_ST_RESOLUTION + CH_CFG_TIMER_WHEEL_BITS - 1) /                   \
+   CH_CFG_TIMER_WHEEL_BITS)
+
+/**
+ * @brief   Number of slots in the top level, which covers the remaining
+ *          bits of the system time.
+ */
+#define CH_VT_WHEEL_TOPSLOTS                                                \
+  (1U << (CH_CFG_ST_RESOLUTION -                                            \
+          CH_CFG_TIMER_WHEEL_BITS * (CH_VT_WHEEL_LEVELS - 1)))
+
+/**
+ * @brief   Total number of timer wheel slots.
+ */
+#define CH_VT_WHEEL_SIZE                                                    \
+  ((CH_VT_WHEEL_LEVELS - 1) * CH_VT_WHEEL_SLOTS + CH_VT_WHEEL_TOPSLOTS)
+#endif /* CH_CFG_USE_TIMER_WHEEL */
+
+#if CH_CFG_USE_READY_BITMAP || CH_CFG_USE_TIMER_WHEEL || defined(__DOXYGEN__)
+/**
+ * @brief   Counts the leading zeros of a non-zero 32 bits word.
+ * @note    Ports can override this, the default is the compiler builtin
+ *          which is a single instruction on ARMv7-M.
+ */
+#if !defined(port_clz) || defined(__DOXYGEN__)
+#define port_clz(w)         ((unsigned)__builtin_clz(w))
+#endif
+#endif
+
 /*===========================================================================*/
 /* Module data structures and types.                                         */
 /*===========================================================================*/
@@ -110,8 +246,51 @@ typedef struct {
   /* End of the fields shared with the thread_t structure.*/
   thread_t              *r_current; /**< @brief The currently running
                                                 thread.                     */
+#if CH_CFG_USE_READY_BITMAP || defined(__DOXYGEN__)
+#if (CH_RLIST_WORDS > 1) || defined(__DOXYGEN__)
+  uint32_t              r_summary;  /**< @brief Non-empty bitmap words.     */
+#endif
+  uint32_t              r_map[CH_RLIST_WORDS];
+                                    /**< @brief Non-empty levels.           */
+  threads_queue_t       r_queues[CH_RLIST_LEVELS];
+                                    /**< @brief Threads queue per level, the
+                                                @p r_queue field is unused. */
+#endif
 } ready_list_t;
 
+/**
+ * @brief   Type of a Virtual Timer callback function.
+ */
+typedef void (*vtfunc_t)(void *);
+
+/**
+ * @brief   Type of a Virtual Timer structure.
+ */
+typedef struct virtual_timer virtual_timer_t;
+
+/**
+ * @extends virtual_timers_list_t
+ *
+ * @brief   Virtual Timer descriptor structure.
+ */
+struct virtual_timer {
+  virtual_timer_t       *vt_next;   /**< @brief Next timer in the list.     */
+  virtual_timer_t       *vt_prev;   /**< @brief Previous timer in the list. */
+#if !CH_CFG_USE_TIMER_WHEEL || defined(__DOXYGEN__)
+  systime_t             vt_delta;   /**< @brief Time delta before timeout.  */
+#endif
+#if CH_CFG_USE_TIMER_WHEEL || defined(__DOXYGEN__)
+  systime_t             vt_time;    /**< @brief System time of the timeout,
+                                                timer wheel only.           */
+#endif
+  systime_t             vt_period;  /**< @brief Reload period, zero for
+                                                one-shot timers.            */
+  vtfunc_t              vt_func;    /**< @brief Timer callback function
+                                                pointer.                    */
+  void                  *vt_par;    /**< @brief Timer callback function
+                                                parameter.                  */
+};
+
 /**
  * @brief   Structure representing a thread.
  * @note    Not all the listed fields are always needed, by switching off some
@@ -240,56 +419,79 @@ struct thread {
 #endif
 #if (CH_CFG_USE_DYNAMIC && CH_CFG_USE_MEMPOOLS) || defined(__DOXYGEN__)
   /**
-   * @brief Memory Pool where the thread workspace is returned.
+   * @brief Memory Pool or Slab Cache where the thread workspace is
+   *        returned.
    */
   void                  *p_mpool;
 #endif
 #if CH_DBG_STATISTICS || defined(__DOXYGEN__)
   time_measurement_t    p_stats;
 #endif
+#if CH_CFG_USE_LAZY_TIMEOUTS || defined(__DOXYGEN__)
+  /**
+   * @brief Timeout timer, left armed when the thread is woken early.
+   */
+  virtual_timer_t       p_timer;
+  /**
+   * @brief Expiry time of @p p_timer while armed.
+   */
+  systime_t             p_timerexp;
+  /**
+   * @brief Deadline of the timed wait in progress.
+   * @note  Only valid while the @p CH_FLAG_TIMEOUT flag is set.
+   */
+  systime_t             p_timeout;
+#endif
+#if (CH_CFG_HEAP_TAGS > 0) || defined(__DOXYGEN__)
+  /**
+   * @brief Owner tag given to the heap blocks allocated by this thread.
+   */
+  uint8_t               p_heaptag;
+#endif
 #if defined(CH_CFG_THREAD_EXTRA_FIELDS)
   /* Extra fields defined in chconf.h.*/
   CH_CFG_THREAD_EXTRA_FIELDS
 #endif
 };
 
+#if CH_CFG_USE_TIMER_WHEEL || defined(__DOXYGEN__)
 /**
- * @brief   Type of a Virtual Timer callback function.
- */
-typedef void (*vtfunc_t)(void *);
-
-/**
- * @brief   Type of a Virtual Timer structure.
- */
-typedef struct virtual_timer virtual_timer_t;
-
-/**
- * @extends virtual_timers_list_t
- *
- * @brief   Virtual Timer descriptor structure.
+ * @brief   Timer wheel slot header.
+ * @details Timers expiring in the same slot are kept in a double link
+ *          bidirectional list.
  */
-struct virtual_timer {
-  virtual_timer_t       *vt_next;   /**< @brief Next timer in the list.     */
-  virtual_timer_t       *vt_prev;   /**< @brief Previous timer in the list. */
-  systime_t             vt_delta;   /**< @brief Time delta before timeout.  */
-  vtfunc_t              vt_func;    /**< @brief Timer callback function
-                                                pointer.                    */
-  void                  *vt_par;    /**< @brief Timer callback function
-                                                parameter.                  */
-};
+typedef struct {
+  virtual_timer_t       *vt_next;   /**< @brief First timer in the slot.    */
+  virtual_timer_t       *vt_prev;   /**< @brief Last timer in the slot.     */
+} virtual_timers_slot_t;
+#endif
 
 /**
  * @brief   Virtual timers list header.
  * @note    The timers list is implemented as a double link bidirectional list
  *          in order to make the unlink time constant, the reset of a virtual
  *          timer is often used in the code.
+ * @note    With @p CH_CFG_USE_TIMER_WHEEL the list is replaced by the slots
+ *          of the timer wheel.
  */
 typedef struct {
+#if !CH_CFG_USE_TIMER_WHEEL || defined(__DOXYGEN__)
   virtual_timer_t       *vt_next;   /**< @brief Next timer in the delta
                                                 list.                       */
   virtual_timer_t       *vt_prev;   /**< @brief Last timer in the delta
                                                 list.                       */
   systime_t             vt_delta;   /**< @brief Must be initialized to -1.  */
+#endif
+#if CH_CFG_USE_TIMER_WHEEL || defined(__DOXYGEN__)
+  /**
+   * @brief   Timer wheel slots, level by level.
+   */
+  virtual_timers_slot_t vt_wheel[CH_VT_WHEEL_SIZE];
+  /**
+   * @brief   Non-empty slots, one word per level.
+   */
+  uint32_t              vt_map[CH_VT_WHEEL_LEVELS];
+#endif
 #if CH_CFG_ST_TIMEDELTA == 0 || defined(__DOXYGEN__)
   volatile systime_t    vt_systime; /**< @brief System Time counter.        */
 #endif
@@ -542,6 +744,137 @@ extern "C" {
  }
 #endif /* CH_CFG_OPTIMIZE_SPEED */
 
+#if CH_CFG_USE_READY_BITMAP || defined(__DOXYGEN__)
+/**
+ * @brief   Returns the ready list level of a priority.
+ *
+ * @notapi
+ */
+static inline unsigned rlist_level(tprio_t prio) {
+
+  return (unsigned)prio >> CH_CFG_READY_BITMAP_SHIFT;
+}
+
+/**
+ * @brief   Marks a ready list level as non-empty.
+ *
+ * @notapi
+ */
+static inline void rlist_mark(unsigned level) {
+
+#if CH_RLIST_WORDS > 1
+  ch.rlist.r_summary |= 1U << (level >> 5);
+#endif
+  ch.rlist.r_map[level >> 5] |= 1U << (level & 31U);
+}
+
+/**
+ * @brief   Marks a ready list level as empty.
+ *
+ * @notapi
+ */
+static inline void rlist_unmark(unsigned level) {
+
+  ch.rlist.r_map[level >> 5] &= ~(1U << (level & 31U));
+#if CH_RLIST_WORDS > 1
+  if (ch.rlist.r_map[level >> 5] == 0U)
+    ch.rlist.r_summary &= ~(1U << (level >> 5));
+#endif
+}
+
+/**
+ * @brief   Evaluates to @p true if no thread is in the ready list.
+ *
+ * @notapi
+ */
+static inline bool rlist_isempty(void) {
+
+#if CH_RLIST_WORDS > 1
+  return (bool)(ch.rlist.r_summary == 0U);
+#else
+  return (bool)(ch.rlist.r_map[0] == 0U);
+#endif
+}
+
+/**
+ * @brief   Returns the highest non-empty ready list level.
+ * @pre     The ready list must not be empty.
+ *
+ * @notapi
+ */
+static inline unsigned rlist_toplevel(void) {
+#if CH_RLIST_WORDS > 1
+  unsigned w = 31U - port_clz(ch.rlist.r_summary);
+#else
+  unsigned w = 0U;
+#endif
+
+  return (w << 5) + 31U - port_clz(ch.rlist.r_map[w]);
+}
+#endif /* CH_CFG_USE_READY_BITMAP */
+
+/**
+ * @brief   Returns the priority of the first thread in the ready list.
+ * @details If the ready list is empty then @p NOPRIO is returned.
+ *
+ * @notapi
+ */
+static inline tprio_t rlist_firstprio(void) {
+
+#if CH_CFG_USE_READY_BITMAP
+  if (rlist_isempty())
+    return NOPRIO;
+  return ch.rlist.r_queues[rlist_toplevel()].p_next->p_prio;
+#else
+  return firstprio(&ch.rlist.r_queue);
+#endif
+}
+
+/**
+ * @brief   Removes the first thread from the ready list and returns it.
+ * @pre     The ready list must not be empty.
+ *
+ * @notapi
+ */
+static inline thread_t *rlist_fifo_remove(void) {
+#if CH_CFG_USE_READY_BITMAP
+  unsigned level = rlist_toplevel();
+  threads_queue_t *tqp = &ch.rlist.r_queues[level];
+  thread_t *tp = queue_fifo_remove(tqp);
+
+  if (queue_isempty(tqp))
+    rlist_unmark(level);
+  return tp;
+#else
+  return queue_fifo_remove(&ch.rlist.r_queue);
+#endif
+}
+
+/**
+ * @brief   Removes a thread from the ready list and returns it.
+ * @details The thread is removed regardless of its position, its priority
+ *          may have been changed since it was inserted.
+ *
+ * @param[in] tp        the pointer to the thread to be removed
+ * @return              The removed thread pointer.
+ *
+ * @notapi
+ */
+static inline thread_t *rlist_dequeue(thread_t *tp) {
+
+#if CH_CFG_USE_READY_BITMAP
+  queue_dequeue(tp);
+  /* If both neighbours are the same node then it is the level header and
+     the level is now empty.*/
+  if (tp->p_next == tp->p_prev)
+    rlist_unmark((unsigned)((threads_queue_t *)tp->p_next -
+                            ch.rlist.r_queues));
+  return tp;
+#else
+  return queue_dequeue(tp);
+#endif
+}
+
 /**
  * @brief   Determines if the current thread must reschedule.
  * @details This function returns @p true if there is a ready thread with
@@ -553,7 +886,7 @@ static inline bool chSchIsRescRequiredI(void) {
 
   chDbgCheckClassI();
 
-  return firstprio(&ch.rlist.r_queue) > currp->p_prio;
+  return rlist_firstprio() > currp->p_prio;
 }
 
 /**
@@ -567,7 +900,7 @@ static inline bool chSchCanYieldS(void) {
 
   chDbgCheckClassI();
 
-  return firstprio(&ch.rlist.r_queue) >= currp->p_prio;
+  return rlist_firstprio() >= currp->p_prio;
 }
 
 /**
@@ -593,7 +926,7 @@ static inline void chSchDoYieldS(void) {
  * @special
  */
 static inline void chSchPreemption(void) {
-  tprio_t p1 = firstprio(&ch.rlist.r_queue);
+  tprio_t p1 = rlist_firstprio();
   tprio_t p2 = currp->p_prio;
 
 #if CH_CFG_TIME_QUANTUM > 0
@@ -0,0 +1,166 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006,2007,2008,2009,2010,
+                 2011,2012,2013,2014 Giovanni Di Sirio.
+
+    This file is part of ChibiOS/RT.
+
+    ChibiOS/RT is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    ChibiOS/RT is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file    chslab.h
+ * @brief   Slab caches macros and structures.
+ *
+ * @addtogroup slabs
+ * @{
+ */
+
+#ifndef _CHSLAB_H_
+#define _CHSLAB_H_
+
+/**
+ * @brief   Slab caches.
+ * @details If enabled the slab caches APIs are included in the kernel.
+ * @note    The default is @p FALSE.
+ */
+#if !defined(CH_CFG_USE_SLABS) || defined(__DOXYGEN__)
+#define CH_CFG_USE_SLABS                    FALSE
+#endif
+
+#if CH_CFG_USE_SLABS || defined(__DOXYGEN__)
+
+/*===========================================================================*/
+/* Module constants.                                                         */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module pre-compile time settings.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Size of a slab.
+ * @details All the slabs have this size regardless of the cache using
+ *          them, this allows an empty slab released by a cache to be
+ *          reused by any other cache. The largest object a cache can
+ *          hold is a bit smaller than a slab.
+ */
+#if !defined(CH_CFG_SLAB_SIZE) || defined(__DOXYGEN__)
+#define CH_CFG_SLAB_SIZE                    512
+#endif
+
+/*===========================================================================*/
+/* Derived constants and error checks.                                       */
+/*===========================================================================*/
+
+#if !CH_CFG_USE_MEMPOOLS
+#error "CH_CFG_USE_SLABS requires CH_CFG_USE_MEMPOOLS"
+#endif
+
+#if !CH_CFG_USE_MUTEXES && !CH_CFG_USE_SEMAPHORES
+#error "CH_CFG_USE_SLABS requires CH_CFG_USE_MUTEXES and/or CH_CFG_USE_SEMAPHORES"
+#endif
+
+#if CH_CFG_SLAB_SIZE < 64
+#error "invalid CH_CFG_SLAB_SIZE value specified"
+#endif
+
+/*===========================================================================*/
+/* Module data structures and types.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Type of a slab header.
+ * @details The header is at the start of the slab, the objects follow.
+ */
+typedef struct slab slab_t;
+
+/**
+ * @brief   Structure describing a slab.
+ */
+struct slab {
+  slab_t                *s_next;    /**< @brief Next slab of the cache.     */
+  memory_pool_t         s_pool;     /**< @brief Free objects of the slab.   */
+  size_t                s_used;     /**< @brief Objects in use.             */
+};
+
+/**
+ * @brief   Type of a slab cache.
+ */
+typedef struct slab_cache slab_cache_t;
+
+/**
+ * @brief   Structure describing a slab cache.
+ */
+struct slab_cache {
+  slab_cache_t          *sc_next;   /**< @brief Next registered cache.      */
+  const char            *sc_name;   /**< @brief Cache name.                 */
+  slab_t                *sc_slabs;  /**< @brief Slabs owned by the cache.   */
+  size_t                sc_object_size;
+                                    /**< @brief Objects size, aligned.      */
+  size_t                sc_objects; /**< @brief Objects in each slab.       */
+  size_t                sc_nslabs;  /**< @brief Number of slabs owned.      */
+  size_t                sc_used;    /**< @brief Objects in use.             */
+  size_t                sc_peak;    /**< @brief Highest @p sc_used.         */
+  uint32_t              sc_fails;   /**< @brief Failed allocations.         */
+#if CH_CFG_USE_MUTEXES
+  mutex_t               sc_mtx;     /**< @brief Cache access mutex.         */
+#else
+  semaphore_t           sc_sem;     /**< @brief Cache access semaphore.     */
+#endif
+};
+
+/**
+ * @brief   Slab cache occupancy.
+ */
+typedef struct {
+  size_t                ss_object_size;
+                                    /**< @brief Objects size.               */
+  size_t                ss_slabs;   /**< @brief Slabs owned by the cache.   */
+  size_t                ss_capacity;/**< @brief Objects in the owned slabs. */
+  size_t                ss_used;    /**< @brief Objects in use.             */
+  size_t                ss_peak;    /**< @brief Highest @p ss_used.         */
+  uint32_t              ss_fails;   /**< @brief Failed allocations.         */
+} slab_stats_t;
+
+/*===========================================================================*/
+/* Module macros.                                                            */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void chSlabCacheObjectInit(slab_cache_t *scp, const char *name, size_t size);
+  void *chSlabAlloc(slab_cache_t *scp);
+  void chSlabFree(slab_cache_t *scp, void *objp);
+  void chSlabCacheShrink(slab_cache_t *scp);
+  void chSlabCacheGetStats(slab_cache_t *scp, slab_stats_t *ssp);
+  slab_cache_t *chSlabCacheNext(slab_cache_t *scp);
+  size_t chSlabStatus(void);
+#ifdef __cplusplus
+}
+#endif
+
+/*===========================================================================*/
+/* Module inline functions.                                                  */
+/*===========================================================================*/
+
+#endif /* CH_CFG_USE_SLABS */
+
+#endif /* _CHSLAB_H_ */
+
+/** @} */
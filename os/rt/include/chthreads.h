@@ -78,7 +78,11 @@
                                          Memory Heap.                       */
 #define CH_FLAG_MODE_MEMPOOL    2   /**< @brief Thread allocated from a
                                          Memory Pool.                       */
+#define CH_FLAG_MODE_SLAB       3   /**< @brief Thread allocated from a
+                                         Slab Cache.                        */
 #define CH_FLAG_TERMINATE       4   /**< @brief Termination requested flag. */
+#define CH_FLAG_TIMEOUT         8   /**< @brief Timed wait in progress,
+                                         lazy timeouts only.                */
 /** @} */
 
 /*===========================================================================*/
@@ -364,6 +368,25 @@ static inline void chThdSleepS(systime_t time) {
   chSchGoSleepTimeoutS(CH_STATE_SLEEPING, time);
 }
 
+/**
+ * @brief   Suspends the invoking thread until its next period.
+ * @details The deadline is advanced by one period and the thread sleeps
+ *          until it, a loop calling this function runs every @p period
+ *          ticks without drifting. If the new deadline has already passed
+ *          then no sleep is performed and the loop catches up.
+ * @see     chThdSleepUntilWindowed()
+ *
+ * @param[in,out] deadlinep pointer to the previous deadline, updated to
+ *                      the new one
+ * @param[in] period    the period in system ticks
+ *
+ * @api
+ */
+static inline void chThdSleepPeriod(systime_t *deadlinep, systime_t period) {
+
+  *deadlinep = chThdSleepUntilWindowed(*deadlinep, *deadlinep + period);
+}
+
 /**
  * @brief   Initializes a threads queue object.
  *
@@ -187,6 +187,11 @@ extern "C" {
   void chVTDoSetI(virtual_timer_t *vtp, systime_t delay,
                   vtfunc_t vtfunc, void *par);
   void chVTDoResetI(virtual_timer_t *vtp);
+#if CH_CFG_USE_TIMER_WHEEL
+  void _vt_wheel_tick(void);
+#else
+  void _vt_reload(virtual_timer_t *vtp);
+#endif
 #ifdef __cplusplus
 }
 #endif
@@ -283,7 +288,7 @@ static inline bool chVTIsTimeWithinX(systime_t time,
                                      systime_t start,
                                      systime_t end) {
 
-  return (bool)(time - start < end - start);
+  return (bool)((systime_t)(time - start) < (systime_t)(end - start));
 }
 
 /**
@@ -433,6 +438,78 @@ static inline void chVTSet(virtual_timer_t *vtp, systime_t delay,
   chSysUnlock();
 }
 
+/**
+ * @brief   Enables a periodic virtual timer.
+ * @details The timer is triggered every @p period ticks until disabled.
+ *          Each deadline is one period after the previous deadline, not
+ *          after the time the callback actually ran, so the timer does
+ *          not drift. If the virtual timer was already enabled then it is
+ *          re-enabled using the new parameters.
+ * @pre     The timer must have been initialized using @p chVTObjectInit()
+ *          or @p chVTDoSetI().
+ * @note    The callback is invoked with the timer already armed for the
+ *          next period, it can stop the timer using @p chVTResetI().
+ *
+ * @param[in] vtp       the @p virtual_timer_t structure pointer
+ * @param[in] period    the period in system ticks, @a TIME_IMMEDIATE is
+ *                      not allowed. In tick-less mode a period shorter
+ *                      than @p CH_CFG_ST_TIMEDELTA is an error, caught by
+ *                      an assertion, and is raised to it when assertions
+ *                      are disabled
+ * @param[in] vtfunc    the timer callback function
+ * @param[in] par       a parameter that will be passed to the callback
+ *                      function
+ *
+ * @iclass
+ */
+static inline void chVTSetPeriodicI(virtual_timer_t *vtp, systime_t period,
+                                    vtfunc_t vtfunc, void *par) {
+
+#if CH_CFG_ST_TIMEDELTA > 0
+  /* A shorter period would re-arm the timer closer than the alarm can
+     be programmed, so the deadlines would fall behind the counter.*/
+  chDbgAssert(period >= (systime_t)CH_CFG_ST_TIMEDELTA,
+              "period below the minimum delta");
+  if ((period != TIME_IMMEDIATE) &&
+      (period < (systime_t)CH_CFG_ST_TIMEDELTA))
+    period = (systime_t)CH_CFG_ST_TIMEDELTA;
+#endif
+  chVTSetI(vtp, period, vtfunc, par);
+  vtp->vt_period = period;
+}
+
+/**
+ * @brief   Enables a periodic virtual timer.
+ * @details The timer is triggered every @p period ticks until disabled.
+ *          Each deadline is one period after the previous deadline, not
+ *          after the time the callback actually ran, so the timer does
+ *          not drift. If the virtual timer was already enabled then it is
+ *          re-enabled using the new parameters.
+ * @pre     The timer must have been initialized using @p chVTObjectInit()
+ *          or @p chVTDoSetI().
+ * @note    The callback is invoked with the timer already armed for the
+ *          next period, it can stop the timer using @p chVTResetI().
+ *
+ * @param[in] vtp       the @p virtual_timer_t structure pointer
+ * @param[in] period    the period in system ticks, @a TIME_IMMEDIATE is
+ *                      not allowed. In tick-less mode a period shorter
+ *                      than @p CH_CFG_ST_TIMEDELTA is an error, caught by
+ *                      an assertion, and is raised to it when assertions
+ *                      are disabled
+ * @param[in] vtfunc    the timer callback function
+ * @param[in] par       a parameter that will be passed to the callback
+ *                      function
+ *
+ * @api
+ */
+static inline void chVTSetPeriodic(virtual_timer_t *vtp, systime_t period,
+                                   vtfunc_t vtfunc, void *par) {
+
+  chSysLock();
+  chVTSetPeriodicI(vtp, period, vtfunc, par);
+  chSysUnlock();
+}
+
 /**
  * @brief   Virtual timers ticker.
  * @note    The system lock is released before entering the callback and
@@ -446,7 +523,9 @@ static inline void chVTDoTickI(void) {
 
   chDbgCheckClassI();
 
-#if CH_CFG_ST_TIMEDELTA == 0
+#if CH_CFG_USE_TIMER_WHEEL
+  _vt_wheel_tick();
+#elif CH_CFG_ST_TIMEDELTA == 0
   ch.vtlist.vt_systime++;
   if (&ch.vtlist != (virtual_timers_list_t *)ch.vtlist.vt_next) {
     virtual_timer_t *vtp;
@@ -454,9 +533,12 @@ static inline void chVTDoTickI(void) {
     --ch.vtlist.vt_next->vt_delta;
     while (!(vtp = ch.vtlist.vt_next)->vt_delta) {
       vtfunc_t fn = vtp->vt_func;
-      vtp->vt_func = (vtfunc_t)NULL;
       vtp->vt_next->vt_prev = (virtual_timer_t *)&ch.vtlist;
       ch.vtlist.vt_next = vtp->vt_next;
+      if (vtp->vt_period > (systime_t)0)
+        _vt_reload(vtp);
+      else
+        vtp->vt_func = (vtfunc_t)NULL;
       chSysUnlockFromISR();
       fn(vtp->vt_par);
       chSysLockFromISR();
@@ -471,9 +553,12 @@ static inline void chVTDoTickI(void) {
     delta -= vtp->vt_delta;
     ch.vtlist.vt_lasttime += vtp->vt_delta;
     vtfunc_t fn = vtp->vt_func;
-    vtp->vt_func = (vtfunc_t)NULL;
     vtp->vt_next->vt_prev = (virtual_timer_t *)&ch.vtlist;
     ch.vtlist.vt_next = vtp->vt_next;
+    if (vtp->vt_period > (systime_t)0)
+      _vt_reload(vtp);
+    else
+      vtp->vt_func = (vtfunc_t)NULL;
     chSysUnlockFromISR();
     fn(vtp->vt_par);
     chSysLockFromISR();
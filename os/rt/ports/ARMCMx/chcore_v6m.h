@@ -74,6 +74,11 @@
  */
 #define PORT_SUPPORTS_RT                FALSE
 
+/**
+ * @brief   This port does not support exclusive load/store primitives.
+ */
+#define PORT_SUPPORTS_EXCLUSIVE         FALSE
+
 /**
  * @brief   PendSV priority level.
  * @note    This priority is enforced to be equal to @p 0,
@@ -78,6 +78,11 @@
  */
 #define PORT_SUPPORTS_RT                TRUE
 
+/**
+ * @brief   This port supports exclusive load/store primitives.
+ */
+#define PORT_SUPPORTS_EXCLUSIVE         TRUE
+
 /**
  * @brief   Disabled value for BASEPRI register.
  */
@@ -548,6 +553,47 @@ static inline rtcnt_t port_rt_get_counter_value(void) {
   return DWT->CYCCNT;
 }
 
+/**
+ * @brief   Exclusive load of a pointer.
+ * @details Reads the pointer and tags its address in the local exclusive
+ *          monitor, a following @p port_store_exclusive() on the same
+ *          address only succeeds if the monitor is still set.
+ *
+ * @param[in] p         address of the pointer
+ * @return              The pointer value.
+ */
+static inline void *port_load_exclusive(void * volatile *p) {
+
+  return (void *)__LDREXW((volatile uint32_t *)p);
+}
+
+/**
+ * @brief   Exclusive store of a pointer.
+ * @note    The local monitor is cleared on any exception entry or return
+ *          so the store fails if an interrupt, or a context switch, was
+ *          taken after the matching @p port_load_exclusive().
+ *
+ * @param[in] p         address of the pointer
+ * @param[in] v         the new pointer value
+ * @return              The operation result.
+ * @retval true         if the value has been stored.
+ * @retval false        if the exclusive access has been lost.
+ */
+static inline bool port_store_exclusive(void * volatile *p, void *v) {
+
+  return (bool)(__STREXW((uint32_t)v, (volatile uint32_t *)p) == 0U);
+}
+
+/**
+ * @brief   Clears a pending exclusive access.
+ * @details Must be used when abandoning a @p port_load_exclusive() without
+ *          a matching @p port_store_exclusive().
+ */
+static inline void port_clear_exclusive(void) {
+
+  __CLREX();
+}
+
 #endif /* !defined(_FROM_ASM_) */
 
 #endif /* _CHCORE_V7M_H_ */
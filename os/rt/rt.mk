@@ -18,7 +18,8 @@ KERNSRC = ${CHIBIOS}/os/rt/src/chsys.c \
           ${CHIBIOS}/os/rt/src/chqueues.c \
           ${CHIBIOS}/os/rt/src/chmemcore.c \
           ${CHIBIOS}/os/rt/src/chheap.c \
-          ${CHIBIOS}/os/rt/src/chmempools.c
+          ${CHIBIOS}/os/rt/src/chmempools.c \
+          ${CHIBIOS}/os/rt/src/chslab.c
 
 # Required include directories
 KERNINC = ${CHIBIOS}/os/rt/include
@@ -116,6 +116,14 @@ void chThdRelease(thread_t *tp) {
 #endif
       chPoolFree(tp->p_mpool, tp);
       break;
+#endif
+#if CH_CFG_USE_SLABS
+    case CH_FLAG_MODE_SLAB:
+#if CH_CFG_USE_REGISTRY
+      REG_REMOVE(tp);
+#endif
+      chSlabFree(tp->p_mpool, tp);
+      break;
 #endif
     }
   }
@@ -224,6 +232,60 @@ thread_t *chThdCreateFromMemoryPool(memory_pool_t *mp, tprio_t prio,
 }
 #endif /* CH_CFG_USE_MEMPOOLS */
 
+#if CH_CFG_USE_SLABS || defined(__DOXYGEN__)
+/**
+ * @brief   Creates a new thread allocating the memory from the specified
+ *          slab cache.
+ * @details The working area size is the objects size of the cache.
+ * @pre     The configuration options @p CH_CFG_USE_DYNAMIC and
+ *          @p CH_CFG_USE_SLABS must be enabled in order to use this
+ *          function.
+ * @note    A thread can terminate by calling @p chThdExit() or by simply
+ *          returning from its main function.
+ * @note    The memory allocated for the thread is not released when the thread
+ *          terminates but when a @p chThdWait() is performed.
+ *
+ * @param[in] scp       pointer to the slab cache object
+ * @param[in] prio      the priority level for the new thread
+ * @param[in] pf        the thread function
+ * @param[in] arg       an argument passed to the thread function. It can be
+ *                      @p NULL.
+ * @return              The pointer to the @p thread_t structure allocated for
+ *                      the thread into the working space area.
+ * @retval  NULL        if the memory cannot be allocated.
+ *
+ * @api
+ */
+thread_t *chThdCreateFromSlab(slab_cache_t *scp, tprio_t prio,
+                              tfunc_t pf, void *arg) {
+  void *wsp;
+  thread_t *tp;
+
+  chDbgCheck(scp != NULL);
+
+  wsp = chSlabAlloc(scp);
+  if (wsp == NULL)
+    return NULL;
+
+#if CH_DBG_FILL_THREADS
+  _thread_memfill((uint8_t *)wsp,
+                  (uint8_t *)wsp + sizeof(thread_t),
+                  CH_DBG_THREAD_FILL_VALUE);
+  _thread_memfill((uint8_t *)wsp + sizeof(thread_t),
+                  (uint8_t *)wsp + scp->sc_object_size,
+                  CH_DBG_STACK_FILL_VALUE);
+#endif
+
+  chSysLock();
+  tp = chThdCreateI(wsp, scp->sc_object_size, prio, pf, arg);
+  tp->p_flags = CH_FLAG_MODE_SLAB;
+  tp->p_mpool = scp;
+  chSchWakeupS(tp, MSG_OK);
+  chSysUnlock();
+  return tp;
+}
+#endif /* CH_CFG_USE_SLABS */
+
 #endif /* CH_CFG_USE_DYNAMIC */
 
 /** @} */
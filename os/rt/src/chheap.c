@@ -29,6 +29,10 @@
  *          are functionally equivalent to the usual @p malloc() and @p free()
  *          library functions. The main difference is that the OS heap APIs
  *          are guaranteed to be thread safe.<br>
+ *          If @p CH_CFG_USE_HEAP_TLSF is enabled the allocator instead keeps
+ *          the free blocks into two levels of size classes, a good-fit
+ *          block is found through the classes bitmaps and a released block
+ *          is coalesced with its physical neighbours in constant time.<br>
  * @pre     In order to use the heap APIs the @p CH_CFG_USE_HEAP option must
  *          be enabled in @p chconf.h.
  * @{
@@ -53,6 +57,38 @@
 #define H_UNLOCK(h)     chSemSignal(&(h)->h_sem)
 #endif
 
+#if CH_CFG_USE_HEAP_TLSF || defined(__DOXYGEN__)
+/*
+ * Flags in the low bits of the block size, free because sizes are
+ * multiple of MEM_ALIGN_SIZE which is at least 4 on all ports.
+ */
+#define H_FREE          ((size_t)1)
+#define H_PREV_FREE     ((size_t)2)
+#define H_FLAGS         (H_FREE | H_PREV_FREE)
+
+/*
+ * Size of a block and its physical successor.
+ */
+#define H_SIZE(hp)      ((hp)->h.size & ~H_FLAGS)
+#define H_NEXT(hp)      ((union heap_header *)((uint8_t *)((hp) + 1) +      \
+                                               H_SIZE(hp)))
+
+/*
+ * A free block keeps the previous free block of its list at the start of
+ * its payload and a pointer to itself at the end of its payload, where the
+ * following block finds it when coalescing.
+ */
+#define H_PREV(hp)      (*(union heap_header **)((hp) + 1))
+#define H_FOOTER(hp)    (((union heap_header **)H_NEXT(hp))[-1])
+
+/*
+ * Smallest payload, a free block must hold its links.
+ */
+#define H_MIN_SIZE      MEM_ALIGN_NEXT(2 * sizeof(union heap_header *))
+#else /* !CH_CFG_USE_HEAP_TLSF */
+#define H_SIZE(hp)      ((hp)->h.size)
+#endif /* !CH_CFG_USE_HEAP_TLSF */
+
 /*===========================================================================*/
 /* Module exported variables.                                                */
 /*===========================================================================*/
@@ -74,6 +110,284 @@ static memory_heap_t default_heap;
 /* Module local functions.                                                   */
 /*===========================================================================*/
 
+#if CH_CFG_USE_HEAP_TLSF || defined(__DOXYGEN__)
+static inline unsigned tlsf_ffs(uint32_t map) {
+
+  return 31U - port_clz(map & (0U - map));
+}
+
+static void tlsf_init(memory_heap_t *heapp) {
+  unsigned fl, sl;
+
+  heapp->h_flmap = 0;
+  for (fl = 0; fl < CH_CFG_HEAP_TLSF_FL_COUNT; fl++) {
+    heapp->h_slmap[fl] = 0;
+    for (sl = 0; sl < CH_HEAP_TLSF_SL_COUNT; sl++)
+      heapp->h_lists[fl][sl] = NULL;
+  }
+  heapp->h_top = NULL;
+}
+
+/*
+ * Size class of a block, sizes below CH_HEAP_TLSF_SL_COUNT alignment units
+ * have one class each, larger sizes are split in CH_HEAP_TLSF_SL_COUNT
+ * classes for each power of two.
+ */
+static void tlsf_mapping(size_t size, unsigned *flp, unsigned *slp) {
+  uint32_t u = (uint32_t)(size / MEM_ALIGN_SIZE);
+  unsigned m;
+
+  if (u < CH_HEAP_TLSF_SL_COUNT) {
+    *flp = 0;
+    *slp = (unsigned)u;
+    return;
+  }
+  m = 31U - port_clz(u);
+  *flp = m - CH_CFG_HEAP_TLSF_SL_BITS + 1U;
+  *slp = (unsigned)(u >> (m - CH_CFG_HEAP_TLSF_SL_BITS)) -
+         CH_HEAP_TLSF_SL_COUNT;
+}
+
+static void tlsf_insert(memory_heap_t *heapp, union heap_header *hp) {
+  unsigned fl, sl;
+
+  tlsf_mapping(H_SIZE(hp), &fl, &sl);
+  hp->h.u.next = heapp->h_lists[fl][sl];
+  H_PREV(hp) = NULL;
+  if (hp->h.u.next != NULL)
+    H_PREV(hp->h.u.next) = hp;
+  heapp->h_lists[fl][sl] = hp;
+  heapp->h_flmap |= 1U << fl;
+  heapp->h_slmap[fl] |= 1U << sl;
+  hp->h.size |= H_FREE;
+  H_FOOTER(hp) = hp;
+  H_NEXT(hp)->h.size |= H_PREV_FREE;
+}
+
+static void tlsf_remove(memory_heap_t *heapp, union heap_header *hp) {
+  unsigned fl, sl;
+
+  tlsf_mapping(H_SIZE(hp), &fl, &sl);
+  if (H_PREV(hp) != NULL)
+    H_PREV(hp)->h.u.next = hp->h.u.next;
+  else {
+    heapp->h_lists[fl][sl] = hp->h.u.next;
+    if (hp->h.u.next == NULL) {
+      heapp->h_slmap[fl] &= ~(1U << sl);
+      if (heapp->h_slmap[fl] == 0U)
+        heapp->h_flmap &= ~(1U << fl);
+    }
+  }
+  if (hp->h.u.next != NULL)
+    H_PREV(hp->h.u.next) = H_PREV(hp);
+  hp->h.size &= ~H_FREE;
+  H_NEXT(hp)->h.size &= ~H_PREV_FREE;
+}
+
+/*
+ * First block of the first non empty class starting from the specified
+ * one, in size order.
+ */
+static union heap_header *tlsf_from(memory_heap_t *heapp,
+                                    unsigned fl, unsigned sl) {
+  uint32_t map = 0U;
+
+  if (sl < CH_HEAP_TLSF_SL_COUNT)
+    map = heapp->h_slmap[fl] & (~0U << sl);
+  if (map == 0U) {
+    map = heapp->h_flmap & (~0U << (fl + 1U));
+    if (map == 0U)
+      return NULL;
+    fl = tlsf_ffs(map);
+    map = heapp->h_slmap[fl];
+  }
+  return heapp->h_lists[fl][tlsf_ffs(map)];
+}
+
+/*
+ * Finds a free block of at least size bytes. The size is rounded up to the
+ * next class so that any block of the first non empty class above fits,
+ * failing that the first block of the size own class is tried.
+ */
+static union heap_header *tlsf_search(memory_heap_t *heapp, size_t size) {
+  union heap_header *hp;
+  size_t rsize = size;
+  unsigned fl, sl;
+
+  if (size / MEM_ALIGN_SIZE >= CH_HEAP_TLSF_SL_COUNT) {
+    unsigned m = 31U - port_clz((uint32_t)(size / MEM_ALIGN_SIZE));
+
+    rsize += (((size_t)1 << (m - CH_CFG_HEAP_TLSF_SL_BITS)) - 1U) *
+             MEM_ALIGN_SIZE;
+  }
+  if (rsize < CH_HEAP_TLSF_MAX_SIZE) {
+    tlsf_mapping(rsize, &fl, &sl);
+    hp = tlsf_from(heapp, fl, sl);
+    if (hp != NULL)
+      return hp;
+  }
+  tlsf_mapping(size, &fl, &sl);
+  hp = heapp->h_lists[fl][sl];
+  if ((hp != NULL) && (H_SIZE(hp) >= size))
+    return hp;
+  return NULL;
+}
+
+#if CH_CFG_HEAP_STATS || defined(__DOXYGEN__)
+/*
+ * Largest free block, only the list of the highest non empty class is
+ * walked.
+ */
+static size_t tlsf_largest(memory_heap_t *heapp) {
+  union heap_header *qp;
+  size_t largest = 0;
+  unsigned fl, sl;
+
+  if (heapp->h_flmap == 0U)
+    return 0;
+  fl = 31U - port_clz(heapp->h_flmap);
+  sl = 31U - port_clz(heapp->h_slmap[fl]);
+  for (qp = heapp->h_lists[fl][sl]; qp != NULL; qp = qp->h.u.next) {
+    if (H_SIZE(qp) > largest)
+      largest = H_SIZE(qp);
+  }
+  return largest;
+}
+#endif /* CH_CFG_HEAP_STATS */
+#endif /* CH_CFG_USE_HEAP_TLSF */
+
+/*
+ * Free blocks iteration, in address order or in size classes order.
+ */
+static union heap_header *free_first(memory_heap_t *heapp) {
+
+#if CH_CFG_USE_HEAP_TLSF
+  return tlsf_from(heapp, 0, 0);
+#else
+  return heapp->h_free.h.u.next;
+#endif
+}
+
+static union heap_header *free_next(memory_heap_t *heapp,
+                                    union heap_header *qp) {
+#if CH_CFG_USE_HEAP_TLSF
+  unsigned fl, sl;
+
+  if (qp->h.u.next != NULL)
+    return qp->h.u.next;
+  tlsf_mapping(H_SIZE(qp), &fl, &sl);
+  return tlsf_from(heapp, fl, sl + 1U);
+#else
+  (void)heapp;
+  return qp->h.u.next;
+#endif
+}
+
+#if CH_CFG_HEAP_STATS || defined(__DOXYGEN__)
+static void stats_init(memory_heap_t *heapp) {
+#if CH_CFG_HEAP_TAGS > 0
+  unsigned i;
+
+  for (i = 0; i < CH_CFG_HEAP_TAGS; i++)
+    heapp->h_tagused[i] = 0;
+#endif
+  heapp->h_used = 0;
+  heapp->h_peak = 0;
+  heapp->h_allocs = 0;
+  heapp->h_frees = 0;
+  heapp->h_fails = 0;
+#if !CH_CFG_USE_HEAP_TLSF
+  heapp->h_largest = 0;
+#endif
+}
+
+static void stats_alloc(memory_heap_t *heapp, union heap_header *hp) {
+  size_t size = sizeof(union heap_header) + H_SIZE(hp);
+
+  chSysLock();
+  heapp->h_used += size;
+  if (heapp->h_used > heapp->h_peak)
+    heapp->h_peak = heapp->h_used;
+  heapp->h_allocs++;
+#if CH_CFG_HEAP_TAGS > 0
+  hp->h.tag = currp->p_heaptag;
+  heapp->h_tagused[hp->h.tag] += size;
+#endif
+  chSysUnlock();
+}
+
+static void stats_free(memory_heap_t *heapp, union heap_header *hp) {
+  size_t size = sizeof(union heap_header) + H_SIZE(hp);
+
+  chSysLock();
+  heapp->h_used -= size;
+  heapp->h_frees++;
+#if CH_CFG_HEAP_TAGS > 0
+  heapp->h_tagused[hp->h.tag] -= size;
+#endif
+  chSysUnlock();
+}
+
+static void stats_fail(memory_heap_t *heapp) {
+
+  chSysLock();
+  heapp->h_fails++;
+  chSysUnlock();
+}
+
+static void stats_get(memory_heap_t *heapp, heap_stats_t *hsp) {
+
+  chSysLock();
+  hsp->hs_used = heapp->h_used;
+  hsp->hs_peak = heapp->h_peak;
+  hsp->hs_allocs = heapp->h_allocs;
+  hsp->hs_frees = heapp->h_frees;
+  hsp->hs_fails = heapp->h_fails;
+  chSysUnlock();
+}
+#else /* !CH_CFG_HEAP_STATS */
+#define stats_init(heapp)
+#define stats_alloc(heapp, hp)
+#define stats_free(heapp, hp)
+#define stats_fail(heapp)
+#endif /* !CH_CFG_HEAP_STATS */
+
+#if (CH_CFG_HEAP_STATS && !CH_CFG_USE_HEAP_TLSF) || defined(__DOXYGEN__)
+/*
+ * The largest free block is kept under the heap lock. A released block can
+ * only make it grow, an allocation can only make it shrink when it takes
+ * the largest block and only then the free list is walked again.
+ */
+static void largest_free(memory_heap_t *heapp, union heap_header *hp) {
+
+  if (hp->h.size > heapp->h_largest)
+    heapp->h_largest = hp->h.size;
+}
+
+/*
+ * Called before size bytes are taken from the free block hp, what is left
+ * of it is split away if large enough.
+ */
+static void largest_alloc(memory_heap_t *heapp, union heap_header *hp,
+                          size_t size) {
+  union heap_header *qp;
+  size_t largest = 0;
+
+  if (hp->h.size < heapp->h_largest)
+    return;
+  if (hp->h.size >= size + sizeof(union heap_header))
+    largest = hp->h.size - sizeof(union heap_header) - size;
+  for (qp = heapp->h_free.h.u.next; qp != NULL; qp = qp->h.u.next) {
+    if ((qp != hp) && (qp->h.size > largest))
+      largest = qp->h.size;
+  }
+  heapp->h_largest = largest;
+}
+#else
+#define largest_free(heapp, hp)
+#define largest_alloc(heapp, hp, size)
+#endif
+
 /*===========================================================================*/
 /* Module exported functions.                                                */
 /*===========================================================================*/
@@ -85,8 +399,13 @@ static memory_heap_t default_heap;
  */
 void _heap_init(void) {
   default_heap.h_provider = chCoreAlloc;
+#if CH_CFG_USE_HEAP_TLSF
+  tlsf_init(&default_heap);
+#else
   default_heap.h_free.h.u.next = (union heap_header *)NULL;
   default_heap.h_free.h.size = 0;
+#endif
+  stats_init(&default_heap);
 #if CH_CFG_USE_MUTEXES || defined(__DOXYGEN__)
   chMtxObjectInit(&default_heap.h_mtx);
 #else
@@ -111,10 +430,25 @@ void chHeapObjectInit(memory_heap_t *heapp, void *buf, size_t size) {
   chDbgCheck(MEM_IS_ALIGNED(buf) && MEM_IS_ALIGNED(size));
 
   heapp->h_provider = (memgetfunc_t)NULL;
+#if CH_CFG_USE_HEAP_TLSF
+  chDbgCheck((size >= 2 * sizeof(union heap_header) + H_MIN_SIZE) &&
+             (size - 2 * sizeof(union heap_header) < CH_HEAP_TLSF_MAX_SIZE));
+
+  /* The area ends with an empty allocated block so that the last free
+     block is never merged past it.*/
+  tlsf_init(heapp);
+  hp = buf;
+  hp->h.size = size - 2 * sizeof(union heap_header);
+  H_NEXT(hp)->h.size = 0;
+  tlsf_insert(heapp, hp);
+#else
   heapp->h_free.h.u.next = hp = buf;
   heapp->h_free.h.size = 0;
   hp->h.u.next = NULL;
   hp->h.size = size - sizeof(union heap_header);
+#endif
+  stats_init(heapp);
+  largest_free(heapp, hp);
 #if CH_CFG_USE_MUTEXES || defined(__DOXYGEN__)
   chMtxObjectInit(&heapp->h_mtx);
 #else
@@ -124,7 +458,7 @@ void chHeapObjectInit(memory_heap_t *heapp, void *buf, size_t size) {
 
 /**
  * @brief   Allocates a block of memory from the heap by using the first-fit
- *          algorithm.
+ *          algorithm, or the good-fit one with @p CH_CFG_USE_HEAP_TLSF.
  * @details The allocated block is guaranteed to be properly aligned for a
  *          pointer data type (@p stkalign_t).
  *
@@ -145,12 +479,68 @@ void *chHeapAlloc(memory_heap_t *heapp, size_t size) {
     heapp = &default_heap;
 
   size = MEM_ALIGN_NEXT(size);
+#if CH_CFG_USE_HEAP_TLSF
+  (void)qp;
+  if (size < H_MIN_SIZE)
+    size = H_MIN_SIZE;
+  if (size >= CH_HEAP_TLSF_MAX_SIZE) {
+    stats_fail(heapp);
+    return NULL;
+  }
+  H_LOCK(heapp);
+
+  hp = tlsf_search(heapp, size);
+  if (hp != NULL) {
+    tlsf_remove(heapp, hp);
+    if (H_SIZE(hp) >= size + sizeof(union heap_header) + H_MIN_SIZE) {
+      /* Block bigger enough, must split it.*/
+      fp = (union heap_header *)((uint8_t *)(hp + 1) + size);
+      fp->h.size = H_SIZE(hp) - sizeof(union heap_header) - size;
+      hp->h.size = size;
+      tlsf_insert(heapp, fp);
+    }
+    hp->h.u.heap = heapp;
+    stats_alloc(heapp, hp);
+
+    H_UNLOCK(heapp);
+    return (void *)(hp + 1);
+  }
+
+  /* More memory is required, tries to get it from the associated provider
+     else fails. The new block is followed by an end marker, if it is
+     contiguous to the previous one then the previous end marker becomes
+     its header.*/
+  if (heapp->h_provider) {
+    hp = heapp->h_provider(size + 2 * sizeof(union heap_header));
+    if (hp != NULL) {
+      if ((heapp->h_top != NULL) && (hp == heapp->h_top + 1)) {
+        hp = heapp->h_top;
+        hp->h.size = (hp->h.size & H_PREV_FREE) |
+                     (size + sizeof(union heap_header));
+      }
+      else
+        hp->h.size = size;
+      hp->h.u.heap = heapp;
+      heapp->h_top = H_NEXT(hp);
+      heapp->h_top->h.size = 0;
+      stats_alloc(heapp, hp);
+
+      H_UNLOCK(heapp);
+      return (void *)(hp + 1);
+    }
+  }
+
+  H_UNLOCK(heapp);
+  stats_fail(heapp);
+  return NULL;
+#else /* !CH_CFG_USE_HEAP_TLSF */
   qp = &heapp->h_free;
   H_LOCK(heapp);
 
   while (qp->h.u.next != NULL) {
     hp = qp->h.u.next;
     if (hp->h.size >= size) {
+      largest_alloc(heapp, hp, size);
       if (hp->h.size < size + sizeof(union heap_header)) {
         /* Gets the whole block even if it is slightly bigger than the
            requested size because the fragment would be too small to be
@@ -166,6 +556,7 @@ void *chHeapAlloc(memory_heap_t *heapp, size_t size) {
         hp->h.size = size;
       }
       hp->h.u.heap = heapp;
+      stats_alloc(heapp, hp);
 
       H_UNLOCK(heapp);
       return (void *)(hp + 1);
@@ -182,11 +573,14 @@ void *chHeapAlloc(memory_heap_t *heapp, size_t size) {
     if (hp != NULL) {
       hp->h.u.heap = heapp;
       hp->h.size = size;
+      stats_alloc(heapp, hp);
       hp++;
       return (void *)hp;
     }
   }
+  stats_fail(heapp);
   return NULL;
+#endif /* !CH_CFG_USE_HEAP_TLSF */
 }
 
 #define LIMIT(p) (union heap_header *)((uint8_t *)(p) + \
@@ -208,6 +602,26 @@ void chHeapFree(void *p) {
 
   hp = (union heap_header *)p - 1;
   heapp = hp->h.u.heap;
+#if CH_CFG_USE_HEAP_TLSF
+  H_LOCK(heapp);
+  chDbgAssert((hp->h.size & H_FREE) == 0U, "already free");
+  stats_free(heapp, hp);
+
+  /* Merges with the next block then with the previous one, if free.*/
+  qp = H_NEXT(hp);
+  if ((qp->h.size & H_FREE) != 0U) {
+    tlsf_remove(heapp, qp);
+    hp->h.size += sizeof(union heap_header) + H_SIZE(qp);
+  }
+  if ((hp->h.size & H_PREV_FREE) != 0U) {
+    qp = ((union heap_header **)hp)[-1];
+    tlsf_remove(heapp, qp);
+    qp->h.size += sizeof(union heap_header) + H_SIZE(hp);
+    hp = qp;
+  }
+  tlsf_insert(heapp, hp);
+#else /* !CH_CFG_USE_HEAP_TLSF */
+  stats_free(heapp, hp);
   qp = &heapp->h_free;
   H_LOCK(heapp);
 
@@ -229,11 +643,14 @@ void chHeapFree(void *p) {
         /* Merge with the previous block.*/
         qp->h.size += hp->h.size + sizeof(union heap_header);
         qp->h.u.next = hp->h.u.next;
+        hp = qp;
       }
+      largest_free(heapp, hp);
       break;
     }
     qp = qp->h.u.next;
   }
+#endif /* !CH_CFG_USE_HEAP_TLSF */
 
   H_UNLOCK(heapp);
   return;
@@ -262,8 +679,9 @@ size_t chHeapStatus(memory_heap_t *heapp, size_t *sizep) {
   H_LOCK(heapp);
 
   sz = 0;
-  for (n = 0, qp = &heapp->h_free; qp->h.u.next; n++, qp = qp->h.u.next)
-    sz += qp->h.u.next->h.size;
+  for (n = 0, qp = free_first(heapp); qp != NULL;
+       n++, qp = free_next(heapp, qp))
+    sz += H_SIZE(qp);
   if (sizep)
     *sizep = sz;
 
@@ -271,6 +689,116 @@ size_t chHeapStatus(memory_heap_t *heapp, size_t *sizep) {
   return n;
 }
 
+#if CH_CFG_HEAP_STATS || defined(__DOXYGEN__)
+/**
+ * @brief   Reports the heap statistics.
+ * @details The counters are kept while allocating and releasing, reading
+ *          them does not depend on the number of free blocks. With
+ *          @p CH_CFG_USE_HEAP_TLSF the largest free block is found from the
+ *          classes bitmaps, otherwise it is a counter too. The free space
+ *          and the free blocks histogram are left to zero, see
+ *          @p chHeapGetFreeStats().
+ *
+ * @param[in] heapp     pointer to a heap descriptor or @p NULL in order to
+ *                      access the default heap.
+ * @param[out] hsp      pointer to a @p heap_stats_t structure
+ *
+ * @api
+ */
+void chHeapGetStats(memory_heap_t *heapp, heap_stats_t *hsp) {
+  unsigned i;
+
+  if (heapp == NULL)
+    heapp = &default_heap;
+
+  for (i = 0; i < CH_HEAP_FRAG_BINS; i++)
+    hsp->hs_frags[i] = 0;
+  hsp->hs_free = 0;
+
+  H_LOCK(heapp);
+
+  stats_get(heapp, hsp);
+
+#if CH_CFG_USE_HEAP_TLSF
+  hsp->hs_largest = tlsf_largest(heapp);
+#else
+  hsp->hs_largest = heapp->h_largest;
+#endif
+
+  H_UNLOCK(heapp);
+}
+
+/**
+ * @brief   Reports the heap statistics, free blocks included.
+ * @details As @p chHeapGetStats() but the free space, the largest free
+ *          block and the free blocks histogram are gathered from every
+ *          free block, the heap stays locked for the whole walk.
+ *
+ * @param[in] heapp     pointer to a heap descriptor or @p NULL in order to
+ *                      access the default heap.
+ * @param[out] hsp      pointer to a @p heap_stats_t structure
+ *
+ * @api
+ */
+void chHeapGetFreeStats(memory_heap_t *heapp, heap_stats_t *hsp) {
+  union heap_header *qp;
+  unsigned i;
+
+  if (heapp == NULL)
+    heapp = &default_heap;
+
+  for (i = 0; i < CH_HEAP_FRAG_BINS; i++)
+    hsp->hs_frags[i] = 0;
+  hsp->hs_free = 0;
+  hsp->hs_largest = 0;
+
+  H_LOCK(heapp);
+
+  stats_get(heapp, hsp);
+
+  for (qp = free_first(heapp); qp != NULL; qp = free_next(heapp, qp)) {
+    size_t size = H_SIZE(qp);
+
+    hsp->hs_free += size;
+    if (size > hsp->hs_largest)
+      hsp->hs_largest = size;
+    i = 0;
+    while ((i < CH_HEAP_FRAG_BINS - 1U) && ((size >> (i + 5U)) != 0U))
+      i++;
+    hsp->hs_frags[i]++;
+  }
+
+  H_UNLOCK(heapp);
+}
+#endif /* CH_CFG_HEAP_STATS */
+
+#if (CH_CFG_HEAP_TAGS > 0) || defined(__DOXYGEN__)
+/**
+ * @brief   Reports the bytes allocated under an owner tag.
+ *
+ * @param[in] heapp     pointer to a heap descriptor or @p NULL in order to
+ *                      access the default heap.
+ * @param[in] tag       the owner tag, below @p CH_CFG_HEAP_TAGS
+ * @return              The bytes in the blocks allocated under the tag,
+ *                      headers included.
+ *
+ * @api
+ */
+size_t chHeapGetTagUsage(memory_heap_t *heapp, unsigned tag) {
+  size_t size;
+
+  chDbgCheck(tag < CH_CFG_HEAP_TAGS);
+
+  if (heapp == NULL)
+    heapp = &default_heap;
+
+  chSysLock();
+  size = heapp->h_tagused[tag];
+  chSysUnlock();
+  return size;
+}
+#endif /* CH_CFG_HEAP_TAGS > 0 */
+
 #endif /* CH_CFG_USE_HEAP */
 
 /** @} */
@@ -56,6 +56,54 @@
 /* Module local functions.                                                   */
 /*===========================================================================*/
 
+#if CH_CFG_USE_MEMPOOLS_LOCKFREE || defined(__DOXYGEN__)
+/**
+ * @brief   Pops an object from the free list without locking.
+ * @details The head is replaced only if no other pop or push happened
+ *          between the exclusive load and the exclusive store, the monitor
+ *          is cleared by any exception so an object popped and pushed back
+ *          by a preempting context cannot be mistaken for an unchanged head.
+ *
+ * @param[in] mp        pointer to a @p memory_pool_t structure
+ * @return              The pointer to the object.
+ * @retval NULL         if the free list is empty.
+ *
+ * @notapi
+ */
+static void *pool_pop(memory_pool_t *mp) {
+  void * volatile *headp = (void * volatile *)&mp->mp_next;
+  struct pool_header *php;
+
+  do {
+    php = port_load_exclusive(headp);
+    if (php == NULL) {
+      port_clear_exclusive();
+      return NULL;
+    }
+  } while (!port_store_exclusive(headp, php->ph_next));
+  return php;
+}
+
+/**
+ * @brief   Pushes an object on the free list without locking.
+ *
+ * @param[in] mp        pointer to a @p memory_pool_t structure
+ * @param[in] objp      the pointer to the object
+ *
+ * @notapi
+ */
+static void pool_push(memory_pool_t *mp, void *objp) {
+  void * volatile *headp = (void * volatile *)&mp->mp_next;
+  struct pool_header * volatile *nextp = &((struct pool_header *)objp)->ph_next;
+
+  /* The link is written through a volatile pointer so that it cannot be
+     moved after the exclusive store that publishes the object.*/
+  do {
+    *nextp = port_load_exclusive(headp);
+  } while (!port_store_exclusive(headp, objp));
+}
+#endif /* CH_CFG_USE_MEMPOOLS_LOCKFREE */
+
 /*===========================================================================*/
 /* Module exported functions.                                                */
 /*===========================================================================*/
@@ -122,10 +170,15 @@ void *chPoolAllocI(memory_pool_t *mp) {
   chDbgCheckClassI();
   chDbgCheck(mp != NULL);
 
+#if CH_CFG_USE_MEMPOOLS_LOCKFREE
+  if ((objp = pool_pop(mp)) == NULL && mp->mp_provider != NULL)
+    objp = mp->mp_provider(mp->mp_object_size);
+#else
   if ((objp = mp->mp_next) != NULL)
     mp->mp_next = mp->mp_next->ph_next;
   else if (mp->mp_provider != NULL)
     objp = mp->mp_provider(mp->mp_object_size);
+#endif
   return objp;
 }
 
@@ -142,9 +195,18 @@ void *chPoolAllocI(memory_pool_t *mp) {
 void *chPoolAlloc(memory_pool_t *mp) {
   void *objp;
 
+#if CH_CFG_USE_MEMPOOLS_LOCKFREE
+  /* The system lock is only required by the memory provider.*/
+  if ((objp = chPoolAllocX(mp)) == NULL && mp->mp_provider != NULL) {
+    chSysLock();
+    objp = mp->mp_provider(mp->mp_object_size);
+    chSysUnlock();
+  }
+#else
   chSysLock();
   objp = chPoolAllocI(mp);
   chSysUnlock();
+#endif
   return objp;
 }
 
@@ -166,8 +228,12 @@ void chPoolFreeI(memory_pool_t *mp, void *objp) {
   chDbgCheckClassI();
   chDbgCheck((mp != NULL) && (objp != NULL));
 
+#if CH_CFG_USE_MEMPOOLS_LOCKFREE
+  pool_push(mp, php);
+#else
   php->ph_next = mp->mp_next;
   mp->mp_next = php;
+#endif
 }
 
 /**
@@ -184,10 +250,55 @@ void chPoolFreeI(memory_pool_t *mp, void *objp) {
  */
 void chPoolFree(memory_pool_t *mp, void *objp) {
 
+#if CH_CFG_USE_MEMPOOLS_LOCKFREE
+  chPoolFreeX(mp, objp);
+#else
   chSysLock();
   chPoolFreeI(mp, objp);
   chSysUnlock();
+#endif
+}
+
+#if CH_CFG_USE_MEMPOOLS_LOCKFREE || defined(__DOXYGEN__)
+/**
+ * @brief   Allocates an object from a memory pool.
+ * @details The free list is accessed without entering a critical zone,
+ *          the memory provider is never invoked.
+ * @pre     The memory pool must be already been initialized.
+ *
+ * @param[in] mp        pointer to a @p memory_pool_t structure
+ * @return              The pointer to the allocated object.
+ * @retval NULL         if pool is empty.
+ *
+ * @xclass
+ */
+void *chPoolAllocX(memory_pool_t *mp) {
+
+  chDbgCheck(mp != NULL);
+
+  return pool_pop(mp);
+}
+
+/**
+ * @brief   Releases an object into a memory pool.
+ * @details The free list is accessed without entering a critical zone.
+ * @pre     The memory pool must be already been initialized.
+ * @pre     The freed object must be of the right size for the specified
+ *          memory pool.
+ * @pre     The object must be properly aligned to contain a pointer to void.
+ *
+ * @param[in] mp        pointer to a @p memory_pool_t structure
+ * @param[in] objp      the pointer to the object to be released
+ *
+ * @xclass
+ */
+void chPoolFreeX(memory_pool_t *mp, void *objp) {
+
+  chDbgCheck((mp != NULL) && (objp != NULL));
+
+  pool_push(mp, objp);
 }
+#endif /* CH_CFG_USE_MEMPOOLS_LOCKFREE */
 
 #endif /* CH_CFG_USE_MEMPOOLS */
 
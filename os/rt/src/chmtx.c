@@ -200,7 +200,7 @@ void chMtxLockS(mutex_t *mp) {
           tp->p_state = CH_STATE_CURRENT;
   #endif
           /* Re-enqueues tp with its new priority on the ready list.*/
-          chSchReadyI(queue_dequeue(tp));
+          chSchReadyI(rlist_dequeue(tp));
           break;
         }
         break;
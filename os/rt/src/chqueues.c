@@ -41,6 +41,8 @@
  * @{
  */
 
+#include <string.h>
+
 #include "ch.h"
 
 #if CH_CFG_USE_QUEUES || defined(__DOXYGEN__)
@@ -65,6 +67,70 @@
 /* Module local functions.                                                   */
 /*===========================================================================*/
 
+/**
+ * @brief   Non-blocking input queue read.
+ * @details The data is copied with at most two block copies, the second
+ *          one is needed when the data wraps around the buffer end.
+ *
+ * @param[in] iqp       pointer to an @p input_queue_t structure
+ * @param[out] bp       pointer to the data buffer
+ * @param[in] n         the maximum amount of data to be transferred
+ * @return              The number of bytes effectively transferred.
+ *
+ * @notapi
+ */
+static size_t iq_read(input_queue_t *iqp, uint8_t *bp, size_t n) {
+  size_t s1;
+
+  if (n > iqp->q_counter)
+    n = iqp->q_counter;
+
+  s1 = (size_t)(iqp->q_top - iqp->q_rdptr);
+  if (n < s1) {
+    memcpy(bp, iqp->q_rdptr, n);
+    iqp->q_rdptr += n;
+  }
+  else {
+    memcpy(bp, iqp->q_rdptr, s1);
+    memcpy(bp + s1, iqp->q_buffer, n - s1);
+    iqp->q_rdptr = iqp->q_buffer + (n - s1);
+  }
+  iqp->q_counter -= n;
+  return n;
+}
+
+/**
+ * @brief   Non-blocking output queue write.
+ * @details The data is copied with at most two block copies, the second
+ *          one is needed when the data wraps around the buffer end.
+ *
+ * @param[in] oqp       pointer to an @p output_queue_t structure
+ * @param[in] bp        pointer to the data buffer
+ * @param[in] n         the maximum amount of data to be transferred
+ * @return              The number of bytes effectively transferred.
+ *
+ * @notapi
+ */
+static size_t oq_write(output_queue_t *oqp, const uint8_t *bp, size_t n) {
+  size_t s1;
+
+  if (n > oqp->q_counter)
+    n = oqp->q_counter;
+
+  s1 = (size_t)(oqp->q_top - oqp->q_wrptr);
+  if (n < s1) {
+    memcpy(oqp->q_wrptr, bp, n);
+    oqp->q_wrptr += n;
+  }
+  else {
+    memcpy(oqp->q_wrptr, bp, s1);
+    memcpy(oqp->q_buffer, bp + s1, n - s1);
+    oqp->q_wrptr = oqp->q_buffer + (n - s1);
+  }
+  oqp->q_counter -= n;
+  return n;
+}
+
 /*===========================================================================*/
 /* Module exported functions.                                                */
 /*===========================================================================*/
@@ -198,8 +264,10 @@ msg_t chIQGetTimeout(input_queue_t *iqp, systime_t time) {
  *          been reset.
  * @note    The function is not atomic, if you need atomicity it is suggested
  *          to use a semaphore or a mutex for mutual exclusion.
- * @note    The callback is invoked before reading each character from the
- *          buffer or before entering the state @p CH_STATE_WTQUEUE.
+ * @note    The data available in the queue is copied in blocks, the system
+ *          lock is held for at most the copy of a full queue buffer.
+ * @note    The callback is invoked before reading each block of data from
+ *          the buffer or before entering the state @p CH_STATE_WTQUEUE.
  *
  * @param[in] iqp       pointer to an @p input_queue_t structure
  * @param[out] bp       pointer to the data buffer
@@ -223,6 +291,8 @@ size_t chIQReadTimeout(input_queue_t *iqp, uint8_t *bp,
 
   chSysLock();
   while (true) {
+    size_t done;
+
     if (nfy)
       nfy(iqp);
 
@@ -233,20 +303,120 @@ size_t chIQReadTimeout(input_queue_t *iqp, uint8_t *bp,
       }
     }
 
-    iqp->q_counter--;
-    *bp++ = *iqp->q_rdptr++;
-    if (iqp->q_rdptr >= iqp->q_top)
-      iqp->q_rdptr = iqp->q_buffer;
+    done = iq_read(iqp, bp, n);
 
     chSysUnlock(); /* Gives a preemption chance in a controlled point.*/
-    r++;
-    if (--n == 0)
+    r += done;
+    bp += done;
+    n -= done;
+    if (n == 0)
       return r;
 
     chSysLock();
   }
 }
 
+/**
+ * @brief   Returns the contiguous data at the read end of an input queue.
+ * @details The data can be read in place, for example by @p memcpy() or a
+ *          DMA transfer, and then removed from the queue using
+ *          @p chIQConsumeI(). The data wrapping around the buffer end is
+ *          returned by a second call after the consume.
+ *
+ * @param[in] iqp       pointer to an @p input_queue_t structure
+ * @param[out] bpp      pointer to the start of the span
+ * @return              The size of the span.
+ * @retval 0            if the queue is empty.
+ *
+ * @iclass
+ */
+size_t chIQGetReadSpanI(input_queue_t *iqp, uint8_t **bpp) {
+  size_t n;
+
+  chDbgCheckClassI();
+
+  n = (size_t)(iqp->q_top - iqp->q_rdptr);
+  *bpp = iqp->q_rdptr;
+  return iqp->q_counter < n ? iqp->q_counter : n;
+}
+
+/**
+ * @brief   Removes data read in place from an input queue.
+ * @note    The callback is invoked after the data has been removed.
+ *
+ * @param[in] iqp       pointer to an @p input_queue_t structure
+ * @param[in] n         number of bytes to remove, it must not exceed the
+ *                      size returned by @p chIQGetReadSpanI()
+ *
+ * @iclass
+ */
+void chIQConsumeI(input_queue_t *iqp, size_t n) {
+
+  chDbgCheckClassI();
+  chDbgCheck((n <= iqp->q_counter) &&
+             (n <= (size_t)(iqp->q_top - iqp->q_rdptr)));
+
+  iqp->q_counter -= n;
+  iqp->q_rdptr += n;
+  if (iqp->q_rdptr >= iqp->q_top)
+    iqp->q_rdptr = iqp->q_buffer;
+
+  if (iqp->q_notify)
+    iqp->q_notify(iqp);
+}
+
+/**
+ * @brief   Returns the contiguous free space at the write end of an input
+ *          queue.
+ * @details The space can be filled in place by a driver, for example by a
+ *          DMA transfer, and then appended to the queue using
+ *          @p chIQCommitI().
+ *
+ * @param[in] iqp       pointer to an @p input_queue_t structure
+ * @param[out] bpp      pointer to the start of the span
+ * @return              The size of the span.
+ * @retval 0            if the queue is full.
+ *
+ * @iclass
+ */
+size_t chIQGetWriteSpanI(input_queue_t *iqp, uint8_t **bpp) {
+  size_t n, empty;
+
+  chDbgCheckClassI();
+
+  n = (size_t)(iqp->q_top - iqp->q_wrptr);
+  empty = chQSizeI(iqp) - iqp->q_counter;
+  *bpp = iqp->q_wrptr;
+  return empty < n ? empty : n;
+}
+
+/**
+ * @brief   Appends data written in place to an input queue.
+ * @details The threads waiting for data are resumed.
+ *
+ * @param[in] iqp       pointer to an @p input_queue_t structure
+ * @param[in] n         number of bytes to append, it must not exceed the
+ *                      size returned by @p chIQGetWriteSpanI()
+ *
+ * @iclass
+ */
+void chIQCommitI(input_queue_t *iqp, size_t n) {
+
+  chDbgCheckClassI();
+  chDbgCheck((n <= chQSizeI(iqp) - iqp->q_counter) &&
+             (n <= (size_t)(iqp->q_top - iqp->q_wrptr)));
+
+  if (n == 0)
+    return;
+
+  iqp->q_counter += n;
+  iqp->q_wrptr += n;
+  if (iqp->q_wrptr >= iqp->q_top)
+    iqp->q_wrptr = iqp->q_buffer;
+
+  chThdDequeueAllI(&iqp->q_waiting, Q_OK);
+}
+
 /**
  * @brief   Initializes an output queue.
  * @details A Semaphore is internally initialized and works as a counter of
@@ -376,8 +546,11 @@ msg_t chOQGetI(output_queue_t *oqp) {
  *          been reset.
  * @note    The function is not atomic, if you need atomicity it is suggested
  *          to use a semaphore or a mutex for mutual exclusion.
- * @note    The callback is invoked after writing each character into the
- *          buffer.
+ * @note    The data is copied in blocks as long as there is space in the
+ *          queue, the system lock is held for at most the copy of a full
+ *          queue buffer.
+ * @note    The callback is invoked after writing each block of data into
+ *          the buffer.
  *
  * @param[in] oqp       pointer to an @p output_queue_t structure
  * @param[out] bp       pointer to the data buffer
@@ -401,27 +574,128 @@ size_t chOQWriteTimeout(output_queue_t *oqp, const uint8_t *bp,
 
   chSysLock();
   while (true) {
+    size_t done;
+
     while (chOQIsFullI(oqp)) {
       if (chThdEnqueueTimeoutS(&oqp->q_waiting, time) != Q_OK) {
         chSysUnlock();
         return w;
       }
     }
-    oqp->q_counter--;
-    *oqp->q_wrptr++ = *bp++;
-    if (oqp->q_wrptr >= oqp->q_top)
-      oqp->q_wrptr = oqp->q_buffer;
+    done = oq_write(oqp, bp, n);
 
     if (nfy)
       nfy(oqp);
 
     chSysUnlock(); /* Gives a preemption chance in a controlled point.*/
-    w++;
-    if (--n == 0)
+    w += done;
+    bp += done;
+    n -= done;
+    if (n == 0)
       return w;
     chSysLock();
   }
 }
+
+/**
+ * @brief   Returns the contiguous free space at the write end of an output
+ *          queue.
+ * @details The space can be filled in place and then appended to the queue
+ *          using @p chOQCommitI(). The space wrapping around the buffer end
+ *          is returned by a second call after the commit.
+ *
+ * @param[in] oqp       pointer to an @p output_queue_t structure
+ * @param[out] bpp      pointer to the start of the span
+ * @return              The size of the span.
+ * @retval 0            if the queue is full.
+ *
+ * @iclass
+ */
+size_t chOQGetWriteSpanI(output_queue_t *oqp, uint8_t **bpp) {
+  size_t n;
+
+  chDbgCheckClassI();
+
+  n = (size_t)(oqp->q_top - oqp->q_wrptr);
+  *bpp = oqp->q_wrptr;
+  return oqp->q_counter < n ? oqp->q_counter : n;
+}
+
+/**
+ * @brief   Appends data written in place to an output queue.
+ * @note    The callback is invoked after the data has been appended.
+ *
+ * @param[in] oqp       pointer to an @p output_queue_t structure
+ * @param[in] n         number of bytes to append, it must not exceed the
+ *                      size returned by @p chOQGetWriteSpanI()
+ *
+ * @iclass
+ */
+void chOQCommitI(output_queue_t *oqp, size_t n) {
+
+  chDbgCheckClassI();
+  chDbgCheck((n <= oqp->q_counter) &&
+             (n <= (size_t)(oqp->q_top - oqp->q_wrptr)));
+
+  oqp->q_counter -= n;
+  oqp->q_wrptr += n;
+  if (oqp->q_wrptr >= oqp->q_top)
+    oqp->q_wrptr = oqp->q_buffer;
+
+  if (oqp->q_notify)
+    oqp->q_notify(oqp);
+}
+
+/**
+ * @brief   Returns the contiguous data at the read end of an output queue.
+ * @details The data can be transmitted in place by a driver, for example
+ *          by a DMA transfer, and then removed from the queue using
+ *          @p chOQConsumeI().
+ *
+ * @param[in] oqp       pointer to an @p output_queue_t structure
+ * @param[out] bpp      pointer to the start of the span
+ * @return              The size of the span.
+ * @retval 0            if the queue is empty.
+ *
+ * @iclass
+ */
+size_t chOQGetReadSpanI(output_queue_t *oqp, uint8_t **bpp) {
+  size_t n, full;
+
+  chDbgCheckClassI();
+
+  n = (size_t)(oqp->q_top - oqp->q_rdptr);
+  full = chQSizeI(oqp) - oqp->q_counter;
+  *bpp = oqp->q_rdptr;
+  return full < n ? full : n;
+}
+
+/**
+ * @brief   Removes data transmitted in place from an output queue.
+ * @details The threads waiting for space are resumed.
+ *
+ * @param[in] oqp       pointer to an @p output_queue_t structure
+ * @param[in] n         number of bytes to remove, it must not exceed the
+ *                      size returned by @p chOQGetReadSpanI()
+ *
+ * @iclass
+ */
+void chOQConsumeI(output_queue_t *oqp, size_t n) {
+
+  chDbgCheckClassI();
+  chDbgCheck((n <= chQSizeI(oqp) - oqp->q_counter) &&
+             (n <= (size_t)(oqp->q_top - oqp->q_rdptr)));
+
+  if (n == 0)
+    return;
+
+  oqp->q_counter += n;
+  oqp->q_rdptr += n;
+  if (oqp->q_rdptr >= oqp->q_top)
+    oqp->q_rdptr = oqp->q_buffer;
+
+  chThdDequeueAllI(&oqp->q_waiting, Q_OK);
+}
 #endif  /* CH_CFG_USE_QUEUES */
 
 /** @} */
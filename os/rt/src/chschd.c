@@ -54,6 +54,47 @@ ch_system_t ch;
 /* Module local functions.                                                   */
 /*===========================================================================*/
 
+#if CH_CFG_USE_READY_BITMAP || defined(__DOXYGEN__)
+/**
+ * @brief   Inserts a thread in its ready list level.
+ * @details The thread is positioned behind all threads with higher or equal
+ *          priority or, if @p ahead is @p true, ahead of the threads with
+ *          equal priority.
+ *
+ * @param[in] tp        the thread to be inserted
+ * @param[in] ahead     insertion ahead of equal priority threads
+ */
+static inline void rlist_insert(thread_t *tp, bool ahead) {
+  unsigned level = rlist_level(tp->p_prio);
+  thread_t *hp = (thread_t *)&ch.rlist.r_queues[level];
+  thread_t *cp;
+
+#if CH_CFG_READY_BITMAP_SHIFT == 0
+  cp = ahead ? hp->p_next : hp;
+#else
+  /* The level holds more than one priority, its queue is priority ordered.
+     Scanning from the tail when inserting behind keeps the insertion
+     constant time among threads of equal priority.*/
+  if (ahead) {
+    cp = hp->p_next;
+    while ((cp != hp) && (cp->p_prio > tp->p_prio))
+      cp = cp->p_next;
+  }
+  else {
+    cp = hp->p_prev;
+    while ((cp != hp) && (cp->p_prio < tp->p_prio))
+      cp = cp->p_prev;
+    cp = cp->p_next;
+  }
+#endif
+  /* Insertion on p_prev.*/
+  tp->p_next = cp;
+  tp->p_prev = cp->p_prev;
+  tp->p_prev->p_next = cp->p_prev = tp;
+  rlist_mark(level);
+}
+#endif /* CH_CFG_USE_READY_BITMAP */
+
 /*===========================================================================*/
 /* Module exported functions.                                                */
 /*===========================================================================*/
@@ -67,6 +108,19 @@ void _scheduler_init(void) {
 
   queue_init(&ch.rlist.r_queue);
   ch.rlist.r_prio = NOPRIO;
+#if CH_CFG_USE_READY_BITMAP
+  {
+    unsigned i;
+
+#if CH_RLIST_WORDS > 1
+    ch.rlist.r_summary = 0U;
+#endif
+    for (i = 0U; i < CH_RLIST_WORDS; i++)
+      ch.rlist.r_map[i] = 0U;
+    for (i = 0U; i < CH_RLIST_LEVELS; i++)
+      queue_init(&ch.rlist.r_queues[i]);
+  }
+#endif
 #if CH_CFG_USE_REGISTRY
   ch.rlist.r_newer = ch.rlist.r_older = (thread_t *)&ch.rlist;
 #endif
@@ -212,7 +266,9 @@ thread_t *list_remove(threads_list_t *tlp) {
  * @iclass
  */
 thread_t *chSchReadyI(thread_t *tp) {
+#if !CH_CFG_USE_READY_BITMAP
   thread_t *cp;
+#endif
 
   chDbgCheckClassI();
   chDbgCheck(tp != NULL);
@@ -221,6 +277,9 @@ thread_t *chSchReadyI(thread_t *tp) {
               "invalid state");
 
   tp->p_state = CH_STATE_READY;
+#if CH_CFG_USE_READY_BITMAP
+  rlist_insert(tp, false);
+#else
   cp = (thread_t *)&ch.rlist.r_queue;
   do {
     cp = cp->p_next;
@@ -229,6 +288,7 @@ thread_t *chSchReadyI(thread_t *tp) {
   tp->p_next = cp;
   tp->p_prev = cp->p_prev;
   tp->p_prev->p_next = cp->p_prev = tp;
+#endif
   return tp;
 }
 
@@ -252,7 +312,7 @@ void chSchGoSleepS(tstate_t newstate) {
      time quantum when it will wakeup.*/
   otp->p_preempt = CH_CFG_TIME_QUANTUM;
 #endif
-  setcurrp(queue_fifo_remove(&ch.rlist.r_queue));
+  setcurrp(rlist_fifo_remove());
 #if defined(CH_CFG_IDLE_ENTER_HOOK)
   if (currp->p_prio == IDLEPRIO) {
     CH_CFG_IDLE_ENTER_HOOK();
@@ -262,6 +322,58 @@ void chSchGoSleepS(tstate_t newstate) {
   chSysSwitch(currp, otp);
 }
 
+static void wakeup(void *p);
+
+#if CH_CFG_USE_LAZY_TIMEOUTS || defined(__DOXYGEN__)
+/*
+ * Arms the thread timeout timer, the delay is raised like chVTDoSetI()
+ * does so that the recorded expiry time is exact.
+ */
+static void timeout_arm(thread_t *tp, systime_t now, systime_t delay) {
+
+#if CH_CFG_ST_TIMEDELTA > 0
+  if (delay < CH_CFG_ST_TIMEDELTA)
+    delay = CH_CFG_ST_TIMEDELTA;
+#endif
+  chVTDoSetI(&tp->p_timer, delay, wakeup, tp);
+  tp->p_timerexp = now + delay;
+}
+
+/*
+ * Checks if the timer left armed by an earlier wait can serve a wait ending
+ * in time ticks, it must expire no later than the new deadline and, in
+ * tickless mode, its expiry must not be within CH_CFG_ST_TIMEDELTA ticks of
+ * the deadline on either side, see timeout_overshot().
+ */
+static bool timeout_reusable(thread_t *tp, systime_t now, systime_t time) {
+
+  if (!chVTIsArmedI(&tp->p_timer) ||
+      ((systime_t)(tp->p_timerexp - now) > time))
+    return false;
+#if CH_CFG_ST_TIMEDELTA > 0
+  if ((tp->p_timerexp != tp->p_timeout) &&
+      (((systime_t)(tp->p_timeout - tp->p_timerexp) < CH_CFG_ST_TIMEDELTA) ||
+       ((systime_t)(tp->p_timerexp - tp->p_timeout) < CH_CFG_ST_TIMEDELTA)))
+    return false;
+#endif
+  return true;
+}
+
+/*
+ * Checks if the timer has been armed past the deadline, this happens in
+ * tickless mode when less than CH_CFG_ST_TIMEDELTA ticks were left.
+ */
+static bool timeout_overshot(thread_t *tp) {
+
+#if CH_CFG_ST_TIMEDELTA > 0
+  return (systime_t)(tp->p_timerexp - tp->p_timeout) < CH_CFG_ST_TIMEDELTA;
+#else
+  (void)tp;
+  return false;
+#endif
+}
+#endif /* CH_CFG_USE_LAZY_TIMEOUTS */
+
 /*
  * Timeout wakeup callback.
  */
@@ -269,6 +381,26 @@ static void wakeup(void *p) {
   thread_t *tp = (thread_t *)p;
 
   chSysLockFromISR();
+#if CH_CFG_USE_LAZY_TIMEOUTS
+  if (((tp->p_flags & CH_FLAG_TIMEOUT) == 0) ||
+      (tp->p_state == CH_STATE_READY)) {
+    /* The thread has been woken before this timeout, the timer is simply
+       left to expire.*/
+    chSysUnlockFromISR();
+    return;
+  }
+  if ((tp->p_timerexp != tp->p_timeout) && !timeout_overshot(tp)) {
+    systime_t now = chVTGetSystemTimeX();
+
+    if (chVTIsTimeWithinX(now, tp->p_timerexp, tp->p_timeout)) {
+      /* The timer was kept from an earlier wait, it is re-armed for the
+         time remaining to the deadline of this one.*/
+      timeout_arm(tp, now, tp->p_timeout - now);
+      chSysUnlockFromISR();
+      return;
+    }
+  }
+#endif
   switch (tp->p_state) {
   case CH_STATE_READY:
     /* Handling the special case where the thread has been made ready by
@@ -321,12 +453,28 @@ msg_t chSchGoSleepTimeoutS(tstate_t newstate, systime_t time) {
   chDbgCheckClassS();
 
   if (TIME_INFINITE != time) {
+#if CH_CFG_USE_LAZY_TIMEOUTS
+    thread_t *otp = currp;
+    systime_t now = chVTGetSystemTimeX();
+
+    /* A timer left armed by an earlier wait is reused if possible, else
+       it is re-armed for this wait.*/
+    otp->p_timeout = now + time;
+    if (!timeout_reusable(otp, now, time)) {
+      chVTResetI(&otp->p_timer);
+      timeout_arm(otp, now, time);
+    }
+    otp->p_flags |= CH_FLAG_TIMEOUT;
+    chSchGoSleepS(newstate);
+    otp->p_flags &= (tmode_t)~CH_FLAG_TIMEOUT;
+#else /* !CH_CFG_USE_LAZY_TIMEOUTS */
     virtual_timer_t vt;
 
     chVTDoSetI(&vt, time, wakeup, currp);
     chSchGoSleepS(newstate);
     if (chVTIsArmedI(&vt))
       chVTDoResetI(&vt);
+#endif /* !CH_CFG_USE_LAZY_TIMEOUTS */
   }
   else
     chSchGoSleepS(newstate);
@@ -407,7 +555,7 @@ void chSchRescheduleS(void) {
  * @special
  */
 bool chSchIsPreemptionRequired(void) {
-  tprio_t p1 = firstprio(&ch.rlist.r_queue);
+  tprio_t p1 = rlist_firstprio();
   tprio_t p2 = currp->p_prio;
 #if CH_CFG_TIME_QUANTUM > 0
   /* If the running thread has not reached its time quantum, reschedule only
@@ -437,7 +585,7 @@ void chSchDoRescheduleBehind(void) {
 
   otp = currp;
   /* Picks the first thread from the ready queue and makes it current.*/
-  setcurrp(queue_fifo_remove(&ch.rlist.r_queue));
+  setcurrp(rlist_fifo_remove());
 #if defined(CH_CFG_IDLE_LEAVE_HOOK)
   if (otp->p_prio == IDLEPRIO) {
     CH_CFG_IDLE_LEAVE_HOOK();
@@ -461,11 +609,14 @@ void chSchDoRescheduleBehind(void) {
  * @special
  */
 void chSchDoRescheduleAhead(void) {
-  thread_t *otp, *cp;
+  thread_t *otp;
+#if !CH_CFG_USE_READY_BITMAP
+  thread_t *cp;
+#endif
 
   otp = currp;
   /* Picks the first thread from the ready queue and makes it current.*/
-  setcurrp(queue_fifo_remove(&ch.rlist.r_queue));
+  setcurrp(rlist_fifo_remove());
 #if defined(CH_CFG_IDLE_LEAVE_HOOK)
   if (otp->p_prio == IDLEPRIO) {
     CH_CFG_IDLE_LEAVE_HOOK();
@@ -474,6 +625,9 @@ void chSchDoRescheduleAhead(void) {
   currp->p_state = CH_STATE_CURRENT;
 
   otp->p_state = CH_STATE_READY;
+#if CH_CFG_USE_READY_BITMAP
+  rlist_insert(otp, true);
+#else
   cp = (thread_t *)&ch.rlist.r_queue;
   do {
     cp = cp->p_next;
@@ -482,6 +636,7 @@ void chSchDoRescheduleAhead(void) {
   otp->p_next = cp;
   otp->p_prev = cp->p_prev;
   otp->p_prev->p_next = cp->p_prev = otp;
+#endif
 
   chSysSwitch(currp, otp);
 }
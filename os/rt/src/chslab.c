@@ -0,0 +1,354 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006,2007,2008,2009,2010,
+                 2011,2012,2013,2014 Giovanni Di Sirio.
+
+    This file is part of ChibiOS/RT.
+
+    ChibiOS/RT is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    ChibiOS/RT is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file    chslab.c
+ * @brief   Slab caches code.
+ *
+ * @addtogroup slabs
+ * @details Slab caches related APIs and services.
+ *          <h2>Operation mode</h2>
+ *          A slab cache allocates objects of a single type, the objects
+ *          are carved from slabs of @p CH_CFG_SLAB_SIZE bytes, each slab
+ *          holding a memory pool of as many objects as fit in it.<br>
+ *          Slabs are taken from the core allocator when needed and, once
+ *          empty, are released to a list of idle slabs shared by all the
+ *          caches instead of being kept by their cache. Long running
+ *          systems allocating objects of different types do not fragment
+ *          the heap this way because the memory is only ever handled in
+ *          slab sized chunks.<br>
+ *          Allocation and release scan the slabs of the cache so their
+ *          time is proportional to the number of slabs owned.
+ * @pre     In order to use the slab caches APIs the @p CH_CFG_USE_SLABS
+ *          option must be enabled in @p chconf.h.
+ * @{
+ */
+
+#include "ch.h"
+
+#if CH_CFG_USE_SLABS || defined(__DOXYGEN__)
+
+/*===========================================================================*/
+/* Module local definitions.                                                 */
+/*===========================================================================*/
+
+/*
+ * Defaults on the best synchronization mechanism available.
+ */
+#if CH_CFG_USE_MUTEXES || defined(__DOXYGEN__)
+#define S_LOCK(scp)     chMtxLock(&(scp)->sc_mtx)
+#define S_UNLOCK(scp)   chMtxUnlock(&(scp)->sc_mtx)
+#else
+#define S_LOCK(scp)     chSemWait(&(scp)->sc_sem)
+#define S_UNLOCK(scp)   chSemSignal(&(scp)->sc_sem)
+#endif
+
+/**
+ * @brief   Size of the slab header, the first object follows it.
+ */
+#define S_HEADER_SIZE   MEM_ALIGN_NEXT(sizeof(slab_t))
+
+/*===========================================================================*/
+/* Module exported variables.                                                */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module local types.                                                       */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module local variables.                                                   */
+/*===========================================================================*/
+
+/**
+ * @brief   Idle slabs, grown from the core allocator.
+ */
+static MEMORYPOOL_DECL(slab_pool, CH_CFG_SLAB_SIZE, chCoreAllocI);
+
+/**
+ * @brief   Number of slabs in @p slab_pool.
+ */
+static size_t slabs_idle;
+
+/**
+ * @brief   Registered caches list.
+ */
+static slab_cache_t *caches;
+
+/*===========================================================================*/
+/* Module local functions.                                                   */
+/*===========================================================================*/
+
+/**
+ * @brief   Gets a slab and loads it with free objects.
+ *
+ * @param[in] scp       pointer to the @p slab_cache_t structure
+ * @return              The pointer to the slab.
+ * @retval NULL         if the core memory is exhausted.
+ *
+ * @notapi
+ */
+static slab_t *slab_get(slab_cache_t *scp) {
+  slab_t *sp;
+
+  chSysLock();
+  if (((sp = chPoolAllocI(&slab_pool)) != NULL) && (slabs_idle > 0U))
+    slabs_idle--;
+  chSysUnlock();
+  if (sp == NULL)
+    return NULL;
+
+  sp->s_next = NULL;
+  sp->s_used = 0;
+  chPoolObjectInit(&sp->s_pool, scp->sc_object_size, NULL);
+  chPoolLoadArray(&sp->s_pool, (uint8_t *)sp + S_HEADER_SIZE,
+                  scp->sc_objects);
+  return sp;
+}
+
+/**
+ * @brief   Returns a slab to the idle slabs.
+ *
+ * @param[in] sp        pointer to the slab
+ *
+ * @notapi
+ */
+static void slab_put(slab_t *sp) {
+
+  chSysLock();
+  chPoolFreeI(&slab_pool, sp);
+  slabs_idle++;
+  chSysUnlock();
+}
+
+/*===========================================================================*/
+/* Module exported functions.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   Initializes a slab cache.
+ * @details The number of objects in each slab is derived from the objects
+ *          size, the cache is registered so that it can be enumerated
+ *          using @p chSlabCacheNext().
+ * @note    Initializing again a cache is allowed only while it owns no
+ *          slabs.
+ *
+ * @param[out] scp      pointer to the @p slab_cache_t structure
+ * @param[in] name      name of the cache, used for reporting
+ * @param[in] size      size of the objects, it is rounded up to the
+ *                      alignment type
+ *
+ * @init
+ */
+void chSlabCacheObjectInit(slab_cache_t *scp, const char *name, size_t size) {
+  slab_cache_t *p;
+
+  if (size < sizeof(void *))
+    size = sizeof(void *);
+  size = MEM_ALIGN_NEXT(size);
+
+  chDbgCheck((scp != NULL) && (size <= CH_CFG_SLAB_SIZE - S_HEADER_SIZE));
+
+  scp->sc_name = name;
+  scp->sc_slabs = NULL;
+  scp->sc_object_size = size;
+  scp->sc_objects = (CH_CFG_SLAB_SIZE - S_HEADER_SIZE) / size;
+  scp->sc_nslabs = 0;
+  scp->sc_used = 0;
+  scp->sc_peak = 0;
+  scp->sc_fails = 0;
+#if CH_CFG_USE_MUTEXES
+  chMtxObjectInit(&scp->sc_mtx);
+#else
+  chSemObjectInit(&scp->sc_sem, 1);
+#endif
+
+  /* A cache initialized again is not linked twice.*/
+  chSysLock();
+  for (p = caches; (p != NULL) && (p != scp); p = p->sc_next)
+    ;
+  if (p == NULL) {
+    scp->sc_next = caches;
+    caches = scp;
+  }
+  chSysUnlock();
+}
+
+/**
+ * @brief   Allocates an object from a slab cache.
+ * @details The object is taken from the first slab having a free object,
+ *          new slabs are appended to the cache so that the older slabs
+ *          are filled first and the newer ones have a chance to empty.
+ *
+ * @param[in] scp       pointer to the @p slab_cache_t structure
+ * @return              The pointer to the allocated object.
+ * @retval NULL         if the core memory is exhausted.
+ *
+ * @api
+ */
+void *chSlabAlloc(slab_cache_t *scp) {
+  slab_t *sp, **spp;
+  void *objp;
+
+  chDbgCheck(scp != NULL);
+
+  S_LOCK(scp);
+  spp = &scp->sc_slabs;
+  while (((sp = *spp) != NULL) && (sp->s_used == scp->sc_objects))
+    spp = &sp->s_next;
+  if (sp == NULL) {
+    if ((sp = slab_get(scp)) == NULL) {
+      scp->sc_fails++;
+      S_UNLOCK(scp);
+      return NULL;
+    }
+    *spp = sp;
+    scp->sc_nslabs++;
+  }
+  objp = chPoolAlloc(&sp->s_pool);
+  sp->s_used++;
+  if (++scp->sc_used > scp->sc_peak)
+    scp->sc_peak = scp->sc_used;
+  S_UNLOCK(scp);
+  return objp;
+}
+
+/**
+ * @brief   Releases an object into its slab cache.
+ * @details A slab left empty is returned to the idle slabs unless all the
+ *          other slabs of the cache are full, this keeps a cache whose
+ *          usage oscillates around a slab boundary from getting and
+ *          returning the same slab at each operation.
+ * @pre     The object must have been allocated from the same cache.
+ *
+ * @param[in] scp       pointer to the @p slab_cache_t structure
+ * @param[in] objp      the pointer to the object to be released
+ *
+ * @api
+ */
+void chSlabFree(slab_cache_t *scp, void *objp) {
+  slab_t *sp, **spp;
+
+  chDbgCheck((scp != NULL) && (objp != NULL));
+
+  S_LOCK(scp);
+  spp = &scp->sc_slabs;
+  while (((sp = *spp) != NULL) &&
+         (((uint8_t *)objp < (uint8_t *)sp + S_HEADER_SIZE) ||
+          ((uint8_t *)objp >= (uint8_t *)sp + CH_CFG_SLAB_SIZE)))
+    spp = &sp->s_next;
+  chDbgAssert(sp != NULL, "not in cache");
+
+  chPoolFree(&sp->s_pool, objp);
+  sp->s_used--;
+  scp->sc_used--;
+  if ((sp->s_used == 0U) &&
+      (scp->sc_used < (scp->sc_nslabs - 1U) * scp->sc_objects)) {
+    *spp = sp->s_next;
+    scp->sc_nslabs--;
+    slab_put(sp);
+  }
+  S_UNLOCK(scp);
+}
+
+/**
+ * @brief   Returns all the empty slabs of a slab cache.
+ * @details The empty slab kept by @p chSlabFree() is returned too, the
+ *          slabs become available to the other caches.
+ *
+ * @param[in] scp       pointer to the @p slab_cache_t structure
+ *
+ * @api
+ */
+void chSlabCacheShrink(slab_cache_t *scp) {
+  slab_t *sp, **spp;
+
+  chDbgCheck(scp != NULL);
+
+  S_LOCK(scp);
+  spp = &scp->sc_slabs;
+  while ((sp = *spp) != NULL) {
+    if (sp->s_used == 0U) {
+      *spp = sp->s_next;
+      scp->sc_nslabs--;
+      slab_put(sp);
+    }
+    else
+      spp = &sp->s_next;
+  }
+  S_UNLOCK(scp);
+}
+
+/**
+ * @brief   Reports the occupancy of a slab cache.
+ *
+ * @param[in] scp       pointer to the @p slab_cache_t structure
+ * @param[out] ssp      pointer to a @p slab_stats_t structure
+ *
+ * @api
+ */
+void chSlabCacheGetStats(slab_cache_t *scp, slab_stats_t *ssp) {
+
+  chDbgCheck((scp != NULL) && (ssp != NULL));
+
+  S_LOCK(scp);
+  ssp->ss_object_size = scp->sc_object_size;
+  ssp->ss_slabs = scp->sc_nslabs;
+  ssp->ss_capacity = scp->sc_nslabs * scp->sc_objects;
+  ssp->ss_used = scp->sc_used;
+  ssp->ss_peak = scp->sc_peak;
+  ssp->ss_fails = scp->sc_fails;
+  S_UNLOCK(scp);
+}
+
+/**
+ * @brief   Enumerates the registered slab caches.
+ *
+ * @param[in] scp       pointer to a @p slab_cache_t structure or @p NULL
+ *                      for the first registered cache
+ * @return              The next registered cache.
+ * @retval NULL         if there are no more caches.
+ *
+ * @api
+ */
+slab_cache_t *chSlabCacheNext(slab_cache_t *scp) {
+  slab_cache_t *next;
+
+  chSysLock();
+  next = scp == NULL ? caches : scp->sc_next;
+  chSysUnlock();
+  return next;
+}
+
+/**
+ * @brief   Idle slabs status.
+ *
+ * @return              The number of slabs not owned by any cache.
+ *
+ * @api
+ */
+size_t chSlabStatus(void) {
+
+  return slabs_idle;
+}
+
+#endif /* CH_CFG_USE_SLABS */
+
+/** @} */
@@ -128,6 +128,12 @@ thread_t *_thread_init(thread_t *tp, tprio_t prio) {
   chTMObjectInit(&tp->p_stats);
   chTMStartMeasurementX(&tp->p_stats);
 #endif
+#if CH_CFG_USE_LAZY_TIMEOUTS
+  chVTObjectInit(&tp->p_timer);
+#endif
+#if CH_CFG_HEAP_TAGS > 0
+  tp->p_heaptag = 0;
+#endif
 #if defined(CH_CFG_THREAD_INIT_HOOK)
   CH_CFG_THREAD_INIT_HOOK(tp);
 #endif
@@ -414,6 +420,10 @@ void chThdExitS(msg_t msg) {
   while (list_notempty(&tp->p_waiting))
     chSchReadyI(list_remove(&tp->p_waiting));
 #endif
+#if CH_CFG_USE_LAZY_TIMEOUTS
+  /* A timeout timer left armed must not outlive the thread.*/
+  chVTResetI(&tp->p_timer);
+#endif
 #if CH_CFG_USE_REGISTRY
   /* Static threads are immediately removed from the registry because
      there is no memory to recover.*/
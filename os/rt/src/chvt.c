@@ -33,6 +33,27 @@
 /* Module local definitions.                                                 */
 /*===========================================================================*/
 
+#if CH_CFG_USE_TIMER_WHEEL || defined(__DOXYGEN__)
+/**
+ * @brief   System time the timer wheel has been advanced to.
+ */
+#if CH_CFG_ST_TIMEDELTA == 0
+#define WHEEL_TIME          ch.vtlist.vt_systime
+#else
+#define WHEEL_TIME          ch.vtlist.vt_lasttime
+#endif
+
+/**
+ * @brief   Slot index mask within a level.
+ */
+#define WHEEL_MASK          (CH_VT_WHEEL_SLOTS - 1U)
+
+/**
+ * @brief   Longest alarm interval, half the system time range.
+ */
+#define WHEEL_MAX_DELTA     ((uint32_t)1 << (CH_CFG_ST_RESOLUTION - 1))
+#endif /* CH_CFG_USE_TIMER_WHEEL */
+
 /*===========================================================================*/
 /* Module exported variables.                                                */
 /*===========================================================================*/
@@ -49,6 +70,212 @@
 /* Module local functions.                                                   */
 /*===========================================================================*/
 
+#if CH_CFG_USE_TIMER_WHEEL || defined(__DOXYGEN__)
+/**
+ * @brief   Returns the index of the lowest set bit of a non-zero word.
+ */
+static inline unsigned wheel_ffs(uint32_t w) {
+
+  return 31U - port_clz(w & (0U - w));
+}
+
+/**
+ * @brief   Returns @p true if no timers are armed.
+ */
+static bool wheel_isempty(void) {
+  unsigned level;
+
+  for (level = 0U; level < CH_VT_WHEEL_LEVELS; level++) {
+    if (ch.vtlist.vt_map[level] != 0U)
+      return false;
+  }
+  return true;
+}
+
+/**
+ * @brief   Links a timer into the wheel.
+ * @details Timers expiring within one revolution of level 0 go into the
+ *          level 0 slot of their expiry time, the others into the first
+ *          level whose revolution covers their distance from the wheel
+ *          time.
+ */
+static void wheel_insert(virtual_timer_t *vtp) {
+  uint32_t delta = (uint32_t)(systime_t)(vtp->vt_time - WHEEL_TIME);
+  virtual_timers_slot_t *sp;
+  unsigned level, slot;
+
+  level = delta < CH_VT_WHEEL_SLOTS ?
+          0U : (31U - port_clz(delta)) / CH_CFG_TIMER_WHEEL_BITS;
+  slot = ((uint32_t)vtp->vt_time >> (level * CH_CFG_TIMER_WHEEL_BITS)) &
+         WHEEL_MASK;
+  sp = &ch.vtlist.vt_wheel[level * CH_VT_WHEEL_SLOTS + slot];
+  vtp->vt_next = (virtual_timer_t *)sp;
+  vtp->vt_prev = sp->vt_prev;
+  vtp->vt_prev->vt_next = vtp;
+  sp->vt_prev = vtp;
+  ch.vtlist.vt_map[level] |= 1U << slot;
+}
+
+/**
+ * @brief   Unlinks a timer from its wheel slot.
+ */
+static void wheel_remove(virtual_timer_t *vtp) {
+
+  vtp->vt_prev->vt_next = vtp->vt_next;
+  vtp->vt_next->vt_prev = vtp->vt_prev;
+  if (vtp->vt_next == vtp->vt_prev) {
+    /* Both neighbours are the slot header, the slot is now empty.*/
+    unsigned n = (unsigned)((virtual_timers_slot_t *)vtp->vt_next -
+                            ch.vtlist.vt_wheel);
+    ch.vtlist.vt_map[n / CH_VT_WHEEL_SLOTS] &=
+        ~(1U << (n % CH_VT_WHEEL_SLOTS));
+  }
+}
+
+/**
+ * @brief   Moves the timers of an upper level slot to the lower levels.
+ */
+static void wheel_cascade(unsigned level, unsigned slot) {
+  virtual_timers_slot_t *sp;
+  virtual_timer_t *vtp;
+
+  if ((ch.vtlist.vt_map[level] & (1U << slot)) == 0U)
+    return;
+
+  ch.vtlist.vt_map[level] &= ~(1U << slot);
+  sp = &ch.vtlist.vt_wheel[level * CH_VT_WHEEL_SLOTS + slot];
+  vtp = sp->vt_next;
+  sp->vt_next = sp->vt_prev = (virtual_timer_t *)sp;
+  while (vtp != (virtual_timer_t *)sp) {
+    virtual_timer_t *next = vtp->vt_next;
+
+    wheel_insert(vtp);
+    vtp = next;
+  }
+}
+
+/**
+ * @brief   Processes the wheel at its current time.
+ * @details The upper level slots starting at this time are moved down, then
+ *          the timers expiring now are triggered.
+ */
+static void wheel_step(void) {
+  systime_t now = WHEEL_TIME;
+  virtual_timers_slot_t *sp;
+  unsigned level;
+
+  for (level = 1U; level < CH_VT_WHEEL_LEVELS; level++) {
+    unsigned shift = level * CH_CFG_TIMER_WHEEL_BITS;
+
+    if (((uint32_t)now & ((1U << shift) - 1U)) != 0U)
+      break;
+    wheel_cascade(level, ((uint32_t)now >> shift) & WHEEL_MASK);
+  }
+
+  /* Timers armed by the callbacks are appended to the slots, the loop
+     stops at the first one that is not due now.*/
+  sp = &ch.vtlist.vt_wheel[(uint32_t)now & WHEEL_MASK];
+  while ((sp->vt_next != (virtual_timer_t *)sp) &&
+         (sp->vt_next->vt_time == now)) {
+    virtual_timer_t *vtp = sp->vt_next;
+    vtfunc_t fn = vtp->vt_func;
+
+    wheel_remove(vtp);
+    if (vtp->vt_period > (systime_t)0) {
+      /* Periodic timers are re-armed from their deadline.*/
+#if CH_CFG_ST_TIMEDELTA > 0
+      chDbgAssert(vtp->vt_period >= (systime_t)CH_CFG_ST_TIMEDELTA,
+                  "period below the minimum delta");
+#endif
+      vtp->vt_time += vtp->vt_period;
+      wheel_insert(vtp);
+    }
+    else
+      vtp->vt_func = (vtfunc_t)NULL;
+    chSysUnlockFromISR();
+    fn(vtp->vt_par);
+    chSysLockFromISR();
+  }
+}
+
+#if CH_CFG_ST_TIMEDELTA > 0 || defined(__DOXYGEN__)
+/**
+ * @brief   Ticks from the wheel time to the next wheel event.
+ * @details The next event is either the next non-empty level 0 slot or the
+ *          start of the next non-empty upper level slot, whose timers are
+ *          moved down at that time. The result is clipped to half the
+ *          system time range.
+ *
+ * @param[out] deltap   ticks to the next event
+ * @return              @p false if no timers are armed.
+ */
+static bool wheel_next(systime_t *deltap) {
+  uint32_t now = (uint32_t)WHEEL_TIME;
+  uint32_t best = WHEEL_MAX_DELTA;
+  bool found = false;
+  unsigned level;
+
+  for (level = 0U; level < CH_VT_WHEEL_LEVELS; level++) {
+    unsigned shift = level * CH_CFG_TIMER_WHEEL_BITS;
+    uint32_t map = ch.vtlist.vt_map[level];
+    uint32_t cur, ahead, blocks;
+
+    if (map == 0U)
+      continue;
+    found = true;
+
+    /* Slots after the current one first, then wrapping around. The
+       current slot is a whole revolution away.*/
+    cur = (now >> shift) & WHEEL_MASK;
+    ahead = map & ~((2U << cur) - 1U);
+    if (ahead != 0U)
+      blocks = wheel_ffs(ahead) - cur;
+    else
+      blocks = wheel_ffs(map) - cur +
+               (level < CH_VT_WHEEL_LEVELS - 1U ? CH_VT_WHEEL_SLOTS :
+                                                  CH_VT_WHEEL_TOPSLOTS);
+    if (blocks <= (best >> shift) + 1U) {
+      uint32_t delta = (blocks << shift) - (now & ((1U << shift) - 1U));
+
+      if (delta < best)
+        best = delta;
+    }
+  }
+  *deltap = (systime_t)best;
+  return found;
+}
+#endif /* CH_CFG_ST_TIMEDELTA > 0 */
+#endif /* CH_CFG_USE_TIMER_WHEEL */
+
+#if !CH_CFG_USE_TIMER_WHEEL || defined(__DOXYGEN__)
+/**
+ * @brief   Links a timer into the delta list.
+ *
+ * @param[in] vtp       the @p virtual_timer_t structure pointer
+ * @param[in] delay     the number of ticks from the delta list base time
+ */
+static void vt_insert(virtual_timer_t *vtp, systime_t delay) {
+  virtual_timer_t *p = ch.vtlist.vt_next;
+
+  /* The delta list is scanned in order to find the correct position for
+     this timer. */
+  while (p->vt_delta < delay) {
+    delay -= p->vt_delta;
+    p = p->vt_next;
+  }
+
+  /* The timer is inserted in the delta list.*/
+  vtp->vt_prev = (vtp->vt_next = p)->vt_prev;
+  vtp->vt_prev->vt_next = p->vt_prev = vtp;
+  vtp->vt_delta = delay
+
+  /* Special case when the timer is in last position in the list, the
+     value in the header must be restored.*/;
+  p->vt_delta -= delay;
+  ch.vtlist.vt_delta = (systime_t)-1;
+}
+#endif /* !CH_CFG_USE_TIMER_WHEEL */
+
 /*===========================================================================*/
 /* Module exported functions.                                                */
 /*===========================================================================*/
@@ -61,8 +288,19 @@
  */
 void _vt_init(void) {
 
+#if !CH_CFG_USE_TIMER_WHEEL
   ch.vtlist.vt_next = ch.vtlist.vt_prev = (void *)&ch.vtlist;
   ch.vtlist.vt_delta = (systime_t)-1;
+#else /* CH_CFG_USE_TIMER_WHEEL */
+  unsigned i;
+
+  for (i = 0U; i < CH_VT_WHEEL_SIZE; i++) {
+    ch.vtlist.vt_wheel[i].vt_next = (virtual_timer_t *)&ch.vtlist.vt_wheel[i];
+    ch.vtlist.vt_wheel[i].vt_prev = (virtual_timer_t *)&ch.vtlist.vt_wheel[i];
+  }
+  for (i = 0U; i < CH_VT_WHEEL_LEVELS; i++)
+    ch.vtlist.vt_map[i] = 0U;
+#endif /* CH_CFG_USE_TIMER_WHEEL */
 #if CH_CFG_ST_TIMEDELTA == 0
   ch.vtlist.vt_systime = 0;
 #else /* CH_CFG_ST_TIMEDELTA > 0 */
@@ -94,17 +332,49 @@ void _vt_init(void) {
  */
 void chVTDoSetI(virtual_timer_t *vtp, systime_t delay,
                 vtfunc_t vtfunc, void *par) {
-  virtual_timer_t *p;
 
   chDbgCheckClassI();
   chDbgCheck((vtp != NULL) && (vtfunc != NULL) && (delay != TIME_IMMEDIATE));
 
   vtp->vt_par = par;
   vtp->vt_func = vtfunc;
-  p = ch.vtlist.vt_next;
+  vtp->vt_period = (systime_t)0;
+
+#if CH_CFG_USE_TIMER_WHEEL
+#if CH_CFG_ST_TIMEDELTA == 0
+  vtp->vt_time = ch.vtlist.vt_systime + delay;
+  wheel_insert(vtp);
+#else /* CH_CFG_ST_TIMEDELTA > 0 */
+  {
+    systime_t now = port_timer_get_time();
 
+    /* If the requested delay is lower than the minimum safe delta then it
+       is raised to the minimum safe value.*/
+    if (delay < CH_CFG_ST_TIMEDELTA)
+      delay = CH_CFG_ST_TIMEDELTA;
+    vtp->vt_time = now + delay;
+
+    if (wheel_isempty()) {
+      /* The wheel is empty, the current time becomes the new wheel
+         time.*/
+      ch.vtlist.vt_lasttime = now;
+      wheel_insert(vtp);
+      port_timer_start_alarm(vtp->vt_time);
+    }
+    else {
+      wheel_insert(vtp);
+
+      /* If the timer expires before the programmed alarm then it becomes
+         the next alarm event in time.*/
+      if ((systime_t)(port_timer_get_alarm() - now) > delay)
+        port_timer_set_alarm(vtp->vt_time);
+    }
+  }
+#endif /* CH_CFG_ST_TIMEDELTA > 0 */
+#else /* !CH_CFG_USE_TIMER_WHEEL */
 #if CH_CFG_ST_TIMEDELTA > 0 || defined(__DOXYGEN__)
   {
+    virtual_timer_t *p = ch.vtlist.vt_next;
     systime_t now = port_timer_get_time();
 
     /* If the requested delay is lower than the minimum safe delta then it
@@ -131,22 +401,8 @@ void chVTDoSetI(virtual_timer_t *vtp, systime_t delay,
   }
 #endif /* CH_CFG_ST_TIMEDELTA > 0 */
 
-  /* The delta list is scanned in order to find the correct position for
-     this timer. */
-  while (p->vt_delta < delay) {
-    delay -= p->vt_delta;
-    p = p->vt_next;
-  }
-
-  /* The timer is inserted in the delta list.*/
-  vtp->vt_prev = (vtp->vt_next = p)->vt_prev;
-  vtp->vt_prev->vt_next = p->vt_prev = vtp;
-  vtp->vt_delta = delay
-
-  /* Special case when the timer is in last position in the list, the
-     value in the header must be restored.*/;
-  p->vt_delta -= delay;
-  ch.vtlist.vt_delta = (systime_t)-1;
+  vt_insert(vtp, delay);
+#endif /* !CH_CFG_USE_TIMER_WHEEL */
 }
 
 /**
@@ -163,6 +419,17 @@ void chVTDoResetI(virtual_timer_t *vtp) {
   chDbgCheck(vtp != NULL);
   chDbgAssert(vtp->vt_func != NULL, "timer not set or already triggered");
 
+#if CH_CFG_USE_TIMER_WHEEL
+  wheel_remove(vtp);
+  vtp->vt_func = (vtfunc_t)NULL;
+
+#if CH_CFG_ST_TIMEDELTA > 0 || defined(__DOXYGEN__)
+  /* Just removed the last timer, alarm timer stopped. Otherwise the alarm
+     is left alone, it is never later than the next expiry.*/
+  if (wheel_isempty())
+    port_timer_stop_alarm();
+#endif /* CH_CFG_ST_TIMEDELTA > 0 */
+#else /* !CH_CFG_USE_TIMER_WHEEL */
   /* Removing the element from the delta list.*/
   vtp->vt_next->vt_delta += vtp->vt_delta;
   vtp->vt_prev->vt_next = vtp->vt_next;
@@ -186,6 +453,69 @@ void chVTDoResetI(virtual_timer_t *vtp) {
     }
   }
 #endif /* CH_CFG_ST_TIMEDELTA > 0 */
+#endif /* !CH_CFG_USE_TIMER_WHEEL */
+}
+
+#if !CH_CFG_USE_TIMER_WHEEL || defined(__DOXYGEN__)
+/**
+ * @brief   Re-arms a periodic timer that has just been unlinked.
+ * @details The timer is linked again one period after its deadline, which
+ *          is the delta list base time while the timer is being triggered.
+ * @note    Internal use only, called by @p chVTDoTickI().
+ *
+ * @param[in] vtp       the @p virtual_timer_t structure pointer
+ *
+ * @notapi
+ */
+void _vt_reload(virtual_timer_t *vtp) {
+
+#if CH_CFG_ST_TIMEDELTA > 0
+  chDbgAssert(vtp->vt_period >= (systime_t)CH_CFG_ST_TIMEDELTA,
+              "period below the minimum delta");
+#endif
+  vt_insert(vtp, vtp->vt_period);
+}
+#endif /* !CH_CFG_USE_TIMER_WHEEL */
+
+#if CH_CFG_USE_TIMER_WHEEL || defined(__DOXYGEN__)
+/**
+ * @brief   Timer wheel ticker.
+ * @details Advances the wheel to the current system time, triggering the
+ *          expired timers, then programs the alarm for the next event.
+ * @note    Internal use only, called by @p chVTDoTickI().
+ *
+ * @notapi
+ */
+void _vt_wheel_tick(void) {
+
+#if CH_CFG_ST_TIMEDELTA == 0
+  ch.vtlist.vt_systime++;
+  wheel_step();
+#else /* CH_CFG_ST_TIMEDELTA > 0 */
+  systime_t now = chVTGetSystemTimeX();
+  systime_t delta;
+
+  while (wheel_next(&delta)) {
+    if (delta > (systime_t)(now - ch.vtlist.vt_lasttime)) {
+      /* Next event in the future, the alarm is kept at least the minimum
+         safe delta away.*/
+      systime_t next = ch.vtlist.vt_lasttime + delta;
+
+      if ((systime_t)(next - now) < (systime_t)CH_CFG_ST_TIMEDELTA)
+        next = now + CH_CFG_ST_TIMEDELTA;
+      port_timer_set_alarm(next);
+      return;
+    }
+    ch.vtlist.vt_lasttime += delta;
+    wheel_step();
+    now = chVTGetSystemTimeX();
+  }
+
+  /* The wheel is empty, no tick event needed so the alarm timer
+     is stopped.*/
+  port_timer_stop_alarm();
+#endif /* CH_CFG_ST_TIMEDELTA > 0 */
 }
+#endif /* CH_CFG_USE_TIMER_WHEEL */
 
 /** @} */
@@ -121,6 +121,55 @@
  */
 #define CH_CFG_OPTIMIZE_SPEED               TRUE
 
+/**
+ * @brief   Priority bitmap ready list.
+ * @details If enabled then threads are made ready in constant time using one
+ *          queue per priority level and a bitmap of the non-empty levels,
+ *          else a single priority ordered queue is scanned on insertion.
+ *
+ * @note    This requires up to 2kB of RAM, see
+ *          @p CH_CFG_READY_BITMAP_SHIFT.
+ * @note    The default is @p FALSE.
+ */
+#define CH_CFG_USE_READY_BITMAP             FALSE
+
+/**
+ * @brief   Ready list levels reduction, as a power of two.
+ * @details Priorities are grouped by 2^n in each ready list level, each
+ *          increment halves the RAM used by the priority bitmap ready list.
+ *
+ * @note    The default is zero.
+ */
+#define CH_CFG_READY_BITMAP_SHIFT           0
+
+/**
+ * @brief   Hierarchical timer wheel.
+ * @details If enabled the virtual timers are kept in a hierarchical timing
+ *          wheel instead of a delta list, arming and disarming a timer take
+ *          constant time regardless of the number of armed timers. The
+ *          wheel costs RAM, see @p CH_CFG_TIMER_WHEEL_BITS.
+ * @note    The default is @p FALSE.
+ */
+#define CH_CFG_USE_TIMER_WHEEL              FALSE
+
+/**
+ * @brief   Timer wheel slots per level, as a power of two.
+ * @details Each level covers this many bits of the system time, with the
+ *          default and a 16 bits system time the wheel takes 64 slots of
+ *          two pointers each.
+ * @note    The default is 4, valid values are 2..5.
+ */
+#define CH_CFG_TIMER_WHEEL_BITS             4
+
+/**
+ * @brief   Per-thread timeout timer with lazy cancel.
+ * @details If enabled each thread embeds the virtual timer used by its
+ *          timed waits, a thread woken before the timeout leaves it armed
+ *          for reuse by its next timed wait instead of disarming it.
+ * @note    The default is @p FALSE.
+ */
+#define CH_CFG_USE_LAZY_TIMEOUTS            FALSE
+
 /** @} */
 
 /*===========================================================================*/
@@ -289,6 +338,49 @@
  */
 #define CH_CFG_USE_HEAP                     TRUE
 
+/**
+ * @brief   Segregated fit heap allocator.
+ * @details If enabled the heap keeps its free blocks into size classes
+ *          lists, allocation and release take a constant time.
+ *
+ * @note    The default is @p FALSE.
+ * @note    Requires @p CH_CFG_USE_HEAP.
+ */
+#define CH_CFG_USE_HEAP_TLSF                FALSE
+
+/**
+ * @brief   Number of first level heap size classes.
+ * @details Heap blocks must be smaller than MEM_ALIGN_SIZE shifted left by
+ *          this number plus @p CH_CFG_HEAP_TLSF_SL_BITS minus one.
+ */
+#define CH_CFG_HEAP_TLSF_FL_COUNT           12
+
+/**
+ * @brief   Number of second level heap size classes, as a power of two.
+ */
+#define CH_CFG_HEAP_TLSF_SL_BITS            2
+
+/**
+ * @brief   Heap statistics.
+ * @details If enabled each heap keeps running counters of its allocated
+ *          bytes, peak, allocations and failures.
+ *
+ * @note    The default is @p FALSE.
+ * @note    Requires @p CH_CFG_USE_HEAP.
+ */
+#define CH_CFG_HEAP_STATS                   FALSE
+
+/**
+ * @brief   Number of heap owner tags.
+ * @details If not zero each allocated block records the owner tag of the
+ *          allocating thread and each heap counts the bytes allocated
+ *          under each tag.
+ *
+ * @note    The default is zero, disabled.
+ * @note    Requires @p CH_CFG_HEAP_STATS.
+ */
+#define CH_CFG_HEAP_TAGS                    0
+
 /**
  * @brief   Memory Pools Allocator APIs.
  * @details If enabled then the memory pools allocator APIs are included
@@ -298,6 +390,37 @@
  */
 #define CH_CFG_USE_MEMPOOLS                 TRUE
 
+/**
+ * @brief   Lock-free Memory Pools.
+ * @details If enabled then the memory pools free list is handled using the
+ *          port exclusive load/store primitives, objects can be allocated
+ *          and released from any context without entering a critical zone.
+ *
+ * @note    The default is @p FALSE.
+ * @note    Requires @p CH_CFG_USE_MEMPOOLS.
+ * @note    Requires a port supporting exclusive accesses, ARMv7-M for
+ *          example.
+ */
+#define CH_CFG_USE_MEMPOOLS_LOCKFREE        FALSE
+
+/**
+ * @brief   Slab Caches APIs.
+ * @details If enabled then the slab caches APIs are included in the
+ *          kernel, objects of each type are allocated from fixed size
+ *          slabs taken from the core allocator and shared by all caches.
+ *
+ * @note    The default is @p FALSE.
+ * @note    Requires @p CH_CFG_USE_MEMPOOLS.
+ */
+#define CH_CFG_USE_SLABS                    FALSE
+
+/**
+ * @brief   Size of a slab.
+ * @details All the slabs have this size, the largest object a slab cache
+ *          can hold is a bit smaller.
+ */
+#define CH_CFG_SLAB_SIZE                    512
+
 /**
  * @brief   Dynamic Threads APIs.
  * @details If enabled then the dynamic threads creation APIs are included
@@ -34,32 +34,66 @@
 #define MAX_FILLER 11
 #define FLOAT_PRECISION 5
 
-static char *long_to_string_with_divisor(char *p,
-                                         long num,
-                                         unsigned radix,
-                                         long divisor) {
-  int i;
+/*
+ * Output is gathered here and written to the stream in chunks, so that
+ * the stream methods (and whatever locking they do) run once per chunk
+ * instead of once per character.
+ */
+typedef struct {
+  BaseSequentialStream  *chp;
+  size_t                n;
+  uint8_t               buf[CHPRINTF_BUFFER_SIZE];
+} outbuf_t;
+
+static void out_flush(outbuf_t *obp) {
+
+  if (obp->n > 0) {
+    chSequentialStreamWrite(obp->chp, obp->buf, obp->n);
+    obp->n = 0;
+  }
+}
+
+static inline void out_put(outbuf_t *obp, char c) {
+
+  obp->buf[obp->n++] = (uint8_t)c;
+  if (obp->n == sizeof(obp->buf))
+    out_flush(obp);
+}
+
+/*
+ * Converts an unsigned number emitting at least @p digits digits. Decimal
+ * has its own loop so that the compiler can turn the constant division
+ * into a multiplication, the other radixes are powers of two and only need
+ * shifts.
+ */
+static char *ultoa(char *p, unsigned long num, unsigned radix, int digits) {
+  char buf[MAX_FILLER];
   char *q;
-  long l, ll;
+  unsigned shift;
+  int i;
 
-  l = num;
-  if (divisor == 0) {
-    ll = num;
-  } else {
-    ll = divisor;
+  if (digits > MAX_FILLER)
+    digits = MAX_FILLER;
+
+  q = buf + MAX_FILLER;
+  if (radix == 10) {
+    do {
+      *--q = (char)('0' + num % 10);
+      num /= 10;
+      digits--;
+    } while ((num != 0) || (digits > 0));
+  }
+  else {
+    shift = (radix == 16) ? 4 : 3;
+    do {
+      i = (int)(num & (radix - 1));
+      *--q = (char)((i < 10) ? '0' + i : 'A' - 10 + i);
+      num >>= shift;
+      digits--;
+    } while ((num != 0) || (digits > 0));
   }
 
-  q = p + MAX_FILLER;
-  do {
-    i = (int)(l % radix);
-    i += '0';
-    if (i > '9')
-      i += 'A' - '0' - 10;
-    *--q = i;
-    l /= radix;
-  } while ((ll /= radix) != 0);
-
-  i = (int)(p + MAX_FILLER - q);
+  i = (int)(buf + MAX_FILLER - q);
   do
     *p++ = *q++;
   while (--i);
@@ -67,31 +101,199 @@ static char *long_to_string_with_divisor(char *p,
   return p;
 }
 
-static char *ltoa(char *p, long num, unsigned radix) {
-
-  return long_to_string_with_divisor(p, num, radix, 0);
-}
-
 #if CHPRINTF_USE_FLOAT
-static long pow10[] = {10, 100, 1000, 10000, 100000, 1000000, 10000000,
-                       100000000, 1000000000, 10000000000, 100000000000,
-                       1000000000000, 10000000000000};
+static const unsigned long pow10[] = {10, 100, 1000, 10000, 100000, 1000000,
+                                      10000000, 100000000, 1000000000};
 
 static char *ftoa(char *p, double num, unsigned long precision) {
-  long l;
+  unsigned long l;
 
   if (precision == 0)
     precision = FLOAT_PRECISION;
-  precision = pow10[precision - 1];
+  if (precision > sizeof(pow10) / sizeof(pow10[0]))
+    precision = sizeof(pow10) / sizeof(pow10[0]);
 
-  l = (long)num;
-  p = long_to_string_with_divisor(p, l, 10, 0);
+  l = (unsigned long)num;
+  p = ultoa(p, l, 10, 0);
   *p++ = '.';
-  l = (long)((num - l) * precision);
-  return long_to_string_with_divisor(p, l, 10, precision / 10);
+  l = (unsigned long)((num - l) * pow10[precision - 1]);
+  return ultoa(p, l, 10, (int)precision);
 }
 #endif
 
+/* Clamps a width or precision to what a specification can hold.*/
+static uint8_t spec_clamp(unsigned n) {
+
+  return (n > 255U) ? 255U : (uint8_t)n;
+}
+
+/*
+ * Parses the specification following a '%', returns a pointer past it.
+ * A zero conversion means the format string ended early.
+ */
+static const char *parse_spec(const char *fmt, chprintf_spec_t *sp) {
+  unsigned n;
+  char c;
+
+  sp->flags = 0;
+  if (*fmt == '-') {
+    fmt++;
+    sp->flags |= CHPRINTF_SPEC_LEFT;
+  }
+  if (*fmt == '0') {
+    fmt++;
+    sp->flags |= CHPRINTF_SPEC_ZERO;
+  }
+  n = 0;
+  if (*fmt == '*') {
+    fmt++;
+    sp->flags |= CHPRINTF_SPEC_WIDTH_ARG;
+  }
+  else {
+    while ((*fmt >= '0') && (*fmt <= '9'))
+      n = n * 10 + (unsigned)(*fmt++ - '0');
+  }
+  sp->width = spec_clamp(n);
+  n = 0;
+  if (*fmt == '.') {
+    fmt++;
+    if (*fmt == '*') {
+      fmt++;
+      sp->flags |= CHPRINTF_SPEC_PREC_ARG;
+    }
+    else {
+      while ((*fmt >= '0') && (*fmt <= '9'))
+        n = n * 10 + (unsigned)(*fmt++ - '0');
+    }
+  }
+  sp->precision = spec_clamp(n);
+
+  /* Long modifier.*/
+  c = *fmt;
+  if ((c == 'l') || (c == 'L')) {
+    sp->flags |= CHPRINTF_SPEC_LONG;
+    c = *++fmt;
+  }
+  else if ((c >= 'A') && (c <= 'Z'))
+    sp->flags |= CHPRINTF_SPEC_LONG;
+  sp->conv = c;
+  if (c != 0)
+    fmt++;
+  return fmt;
+}
+
+/* Performs a single conversion, taking its arguments from @p app.*/
+static void emit_spec(outbuf_t *obp, const chprintf_spec_t *sp,
+                      va_list *app) {
+  char *p, *s, c, filler;
+  int i, precision, width;
+  bool is_long;
+  long l;
+  unsigned long ul;
+#if CHPRINTF_USE_FLOAT
+  float f;
+  char tmpbuf[2*MAX_FILLER + 1];
+#else
+  char tmpbuf[MAX_FILLER + 1];
+#endif
+
+  p = tmpbuf;
+  s = tmpbuf;
+  filler = (sp->flags & CHPRINTF_SPEC_ZERO) ? '0' : ' ';
+  is_long = (sp->flags & CHPRINTF_SPEC_LONG) != 0;
+  width = sp->width;
+  if (sp->flags & CHPRINTF_SPEC_WIDTH_ARG)
+    width = va_arg(*app, int);
+  precision = sp->precision;
+  if (sp->flags & CHPRINTF_SPEC_PREC_ARG)
+    precision = va_arg(*app, int);
+
+  /* Command decoding.*/
+  c = sp->conv;
+  switch (c) {
+  case 'c':
+    filler = ' ';
+    *p++ = va_arg(*app, int);
+    break;
+  case 's':
+    filler = ' ';
+    if ((s = va_arg(*app, char *)) == 0)
+      s = "(null)";
+    if (precision == 0)
+      precision = 32767;
+    for (p = s; *p && (--precision >= 0); p++)
+      ;
+    break;
+  case 'D':
+  case 'd':
+  case 'I':
+  case 'i':
+    if (is_long)
+      l = va_arg(*app, long);
+    else
+      l = va_arg(*app, int);
+    ul = (unsigned long)l;
+    if (l < 0) {
+      *p++ = '-';
+      ul = 0UL - ul;
+    }
+    p = ultoa(p, ul, 10, precision);
+    break;
+#if CHPRINTF_USE_FLOAT
+  case 'f':
+    f = (float) va_arg(*app, double);
+    if (f < 0) {
+      *p++ = '-';
+      f = -f;
+    }
+    p = ftoa(p, f, precision);
+    break;
+#endif
+  case 'X':
+  case 'x':
+    c = 16;
+    goto unsigned_common;
+  case 'U':
+  case 'u':
+    c = 10;
+    goto unsigned_common;
+  case 'O':
+  case 'o':
+    c = 8;
+unsigned_common:
+    if (is_long)
+      ul = va_arg(*app, unsigned long);
+    else
+      ul = va_arg(*app, unsigned int);
+    p = ultoa(p, ul, c, precision);
+    break;
+  default:
+    *p++ = c;
+    break;
+  }
+  i = (int)(p - s);
+  if ((width -= i) < 0)
+    width = 0;
+  if ((sp->flags & CHPRINTF_SPEC_LEFT) == 0)
+    width = -width;
+  if (width < 0) {
+    if (*s == '-' && filler == '0') {
+      out_put(obp, *s++);
+      i--;
+    }
+    do {
+      out_put(obp, filler);
+    } while (++width != 0);
+  }
+  while (--i >= 0)
+    out_put(obp, *s++);
+
+  while (width) {
+    out_put(obp, filler);
+    width--;
+  }
+}
+
 /**
  * @brief   System formatted output function.
  * @details This function implements a minimal @p vprintf()-like functionality
@@ -109,6 +311,8 @@ static char *ftoa(char *p, double num, unsigned long precision) {
  *          - <b>c</b> character.
  *          - <b>s</b> string.
  *          .
+ *          For integer types the precision is the minimum number of digits,
+ *          padded with zeros.
  *
  * @param[in] chp       pointer to a @p BaseSequentialStream implementing object
  * @param[in] fmt       formatting string
@@ -117,154 +321,26 @@ static char *ftoa(char *p, double num, unsigned long precision) {
  * @api
  */
 void chvprintf(BaseSequentialStream *chp, const char *fmt, va_list ap) {
-  char *p, *s, c, filler;
-  int i, precision, width;
-  bool is_long, left_align;
-  long l;
-#if CHPRINTF_USE_FLOAT
-  float f;
-  char tmpbuf[2*MAX_FILLER + 1];
-#else
-  char tmpbuf[MAX_FILLER + 1];
-#endif
+  chprintf_spec_t spec;
+  outbuf_t ob;
+  va_list args;
+  char c;
 
-  while (TRUE) {
-    c = *fmt++;
-    if (c == 0)
-      return;
+  ob.chp = chp;
+  ob.n = 0;
+  va_copy(args, ap);
+  while ((c = *fmt++) != 0) {
     if (c != '%') {
-      chSequentialStreamPut(chp, (uint8_t)c);
+      out_put(&ob, c);
       continue;
     }
-    p = tmpbuf;
-    s = tmpbuf;
-    left_align = FALSE;
-    if (*fmt == '-') {
-      fmt++;
-      left_align = TRUE;
-    }
-    filler = ' ';
-    if (*fmt == '0') {
-      fmt++;
-      filler = '0';
-    }
-    width = 0;
-    while (TRUE) {
-      c = *fmt++;
-      if (c >= '0' && c <= '9')
-        c -= '0';
-      else if (c == '*')
-        c = va_arg(ap, int);
-      else
-        break;
-      width = width * 10 + c;
-    }
-    precision = 0;
-    if (c == '.') {
-      while (TRUE) {
-        c = *fmt++;
-        if (c >= '0' && c <= '9')
-          c -= '0';
-        else if (c == '*')
-          c = va_arg(ap, int);
-        else
-          break;
-        precision *= 10;
-        precision += c;
-      }
-    }
-    /* Long modifier.*/
-    if (c == 'l' || c == 'L') {
-      is_long = TRUE;
-      if (*fmt)
-        c = *fmt++;
-    }
-    else
-      is_long = (c >= 'A') && (c <= 'Z');
-
-    /* Command decoding.*/
-    switch (c) {
-    case 'c':
-      filler = ' ';
-      *p++ = va_arg(ap, int);
-      break;
-    case 's':
-      filler = ' ';
-      if ((s = va_arg(ap, char *)) == 0)
-        s = "(null)";
-      if (precision == 0)
-        precision = 32767;
-      for (p = s; *p && (--precision >= 0); p++)
-        ;
-      break;
-    case 'D':
-    case 'd':
-    case 'I':
-    case 'i':
-      if (is_long)
-        l = va_arg(ap, long);
-      else
-        l = va_arg(ap, int);
-      if (l < 0) {
-        *p++ = '-';
-        l = -l;
-      }
-      p = ltoa(p, l, 10);
-      break;
-#if CHPRINTF_USE_FLOAT
-    case 'f':
-      f = (float) va_arg(ap, double);
-      if (f < 0) {
-        *p++ = '-';
-        f = -f;
-      }
-      p = ftoa(p, f, precision);
-      break;
-#endif
-    case 'X':
-    case 'x':
-      c = 16;
-      goto unsigned_common;
-    case 'U':
-    case 'u':
-      c = 10;
-      goto unsigned_common;
-    case 'O':
-    case 'o':
-      c = 8;
-unsigned_common:
-      if (is_long)
-        l = va_arg(ap, unsigned long);
-      else
-        l = va_arg(ap, unsigned int);
-      p = ltoa(p, l, c);
+    fmt = parse_spec(fmt, &spec);
+    if (spec.conv == 0)
       break;
-    default:
-      *p++ = c;
-      break;
-    }
-    i = (int)(p - s);
-    if ((width -= i) < 0)
-      width = 0;
-    if (left_align == FALSE)
-      width = -width;
-    if (width < 0) {
-      if (*s == '-' && filler == '0') {
-        chSequentialStreamPut(chp, (uint8_t)*s++);
-        i--;
-      }
-      do {
-        chSequentialStreamPut(chp, (uint8_t)filler);
-      } while (++width != 0);
-    }
-    while (--i >= 0)
-      chSequentialStreamPut(chp, (uint8_t)*s++);
-
-    while (width) {
-      chSequentialStreamPut(chp, (uint8_t)filler);
-      width--;
-    }
+    emit_spec(&ob, &spec, &args);
   }
+  va_end(args);
+  out_flush(&ob);
 }
 
 /**
@@ -312,4 +388,81 @@ int chsnprintf(char *str, size_t size, const char *fmt, ...) {
   return ms.eos;
 }
 
+#if CHPRINTF_USE_COMPILED || defined(__DOXYGEN__)
+/**
+ * @brief   Parses a format string once for repeated use.
+ * @details The format string is split into runs of literal characters
+ *          and conversion specifications, so that printing it later
+ *          with @p chprintfCompiled() skips the parsing entirely.
+ * @note    The format string is referenced, not copied, and must stay
+ *          valid for as long as the compiled format is used.
+ *
+ * @param[out] cfp      pointer to the compiled format
+ * @param[in] fmt       formatting string
+ * @return              The operation status.
+ * @retval true         if the format was compiled.
+ * @retval false        if it needs more than @p CHPRINTF_COMPILED_OPS
+ *                      steps.
+ *
+ * @api
+ */
+bool chprintfCompile(chprintf_compiled_t *cfp, const char *fmt) {
+  chprintf_op_t *op;
+  const char *lit, *spec;
+
+  cfp->fmt = fmt;
+  cfp->nops = 0;
+  do {
+    if (cfp->nops >= CHPRINTF_COMPILED_OPS)
+      return false;
+    op = &cfp->ops[cfp->nops++];
+
+    lit = fmt;
+    while ((*fmt != 0) && (*fmt != '%'))
+      fmt++;
+    op->literal = (uint16_t)(fmt - lit);
+    op->skip = 0;
+    op->spec.conv = 0;
+    if (*fmt == '%') {
+      spec = ++fmt;
+      fmt = parse_spec(fmt, &op->spec);
+      op->skip = (uint8_t)(fmt - spec + 1);
+    }
+  } while (op->spec.conv != 0);
+
+  return true;
+}
+
+/**
+ * @brief   Formatted output using a compiled format.
+ *
+ * @param[in] chp       pointer to a @p BaseSequentialStream implementing object
+ * @param[in] cfp       format compiled by @p chprintfCompile()
+ * @param[in] ap        list of parameters
+ *
+ * @api
+ */
+void chvprintfCompiled(BaseSequentialStream *chp,
+                       const chprintf_compiled_t *cfp, va_list ap) {
+  const chprintf_op_t *op;
+  const char *fmt = cfp->fmt;
+  outbuf_t ob;
+  va_list args;
+  int i;
+
+  ob.chp = chp;
+  ob.n = 0;
+  va_copy(args, ap);
+  for (op = cfp->ops; op < &cfp->ops[cfp->nops]; op++) {
+    for (i = 0; i < op->literal; i++)
+      out_put(&ob, fmt[i]);
+    fmt += op->literal + op->skip;
+    if (op->spec.conv != 0)
+      emit_spec(&ob, &op->spec, &args);
+  }
+  va_end(args);
+  out_flush(&ob);
+}
+#endif /* CHPRINTF_USE_COMPILED */
+
 /** @} */
@@ -34,11 +34,104 @@
 #define CHPRINTF_USE_FLOAT          FALSE
 #endif
 
+/**
+ * @brief   Size of the on-stack output buffer.
+ * @details Formatted output is collected in a buffer of this size and
+ *          handed to the stream in chunks, rather than one character at
+ *          a time.
+ */
+#if !defined(CHPRINTF_BUFFER_SIZE) || defined(__DOXYGEN__)
+#define CHPRINTF_BUFFER_SIZE        32
+#endif
+
+#if CHPRINTF_BUFFER_SIZE < 1
+#error "CHPRINTF_BUFFER_SIZE must be at least 1"
+#endif
+
+/**
+ * @brief   Precompiled format strings support.
+ */
+#if !defined(CHPRINTF_USE_COMPILED) || defined(__DOXYGEN__)
+#define CHPRINTF_USE_COMPILED       FALSE
+#endif
+
+/**
+ * @brief   Maximum number of steps in a compiled format.
+ * @details Each step is a run of literal text followed by one conversion,
+ *          plus one for any text after the last conversion.
+ */
+#if !defined(CHPRINTF_COMPILED_OPS) || defined(__DOXYGEN__)
+#define CHPRINTF_COMPILED_OPS       8
+#endif
+
+/**
+ * @brief   Marks a function as taking a printf-style format string.
+ * @details Lets GCC check the arguments against the format, the
+ *          conversions accepted by chprintf are a subset of printf's.
+ */
+#if defined(__GNUC__) || defined(__DOXYGEN__)
+#define CHPRINTF_FORMAT(fmt, args) __attribute__((format(printf, fmt, args)))
+#else
+#define CHPRINTF_FORMAT(fmt, args)
+#endif
+
+/**
+ * @name    Conversion specification flags
+ * @{
+ */
+#define CHPRINTF_SPEC_LEFT          1   /**< @brief Left aligned.         */
+#define CHPRINTF_SPEC_ZERO          2   /**< @brief Zero filled.          */
+#define CHPRINTF_SPEC_LONG          4   /**< @brief Long argument.        */
+#define CHPRINTF_SPEC_WIDTH_ARG     8   /**< @brief Width is an argument. */
+#define CHPRINTF_SPEC_PREC_ARG      16  /**< @brief Precision is an
+                                             argument.                    */
+/** @} */
+
+/**
+ * @brief   A parsed conversion specification.
+ */
+typedef struct {
+  char                      conv;       /**< @brief Conversion character. */
+  uint8_t                   flags;      /**< @brief Specification flags.  */
+  uint8_t                   width;      /**< @brief Field width.          */
+  uint8_t                   precision;  /**< @brief Precision.            */
+} chprintf_spec_t;
+
+#if CHPRINTF_USE_COMPILED || defined(__DOXYGEN__)
+/**
+ * @brief   One step of a compiled format.
+ */
+typedef struct {
+  uint16_t                  literal;    /**< @brief Literal characters
+                                             before the conversion.       */
+  uint8_t                   skip;       /**< @brief Length of the
+                                             conversion in the format.    */
+  chprintf_spec_t           spec;       /**< @brief The conversion, a zero
+                                             @p conv ends the format.     */
+} chprintf_op_t;
+
+/**
+ * @brief   A format string parsed by @p chprintfCompile().
+ */
+typedef struct {
+  const char                *fmt;       /**< @brief Source format.        */
+  uint8_t                   nops;       /**< @brief Steps in use.         */
+  chprintf_op_t             ops[CHPRINTF_COMPILED_OPS];
+} chprintf_compiled_t;
+#endif /* CHPRINTF_USE_COMPILED */
+
 #ifdef __cplusplus
 extern "C" {
 #endif
-  void chvprintf(BaseSequentialStream *chp, const char *fmt, va_list ap);
-  int chsnprintf(char *str, size_t size, const char *fmt, ...);
+  void chvprintf(BaseSequentialStream *chp, const char *fmt, va_list ap)
+    CHPRINTF_FORMAT(2, 0);
+  int chsnprintf(char *str, size_t size, const char *fmt, ...)
+    CHPRINTF_FORMAT(3, 4);
+#if CHPRINTF_USE_COMPILED
+  bool chprintfCompile(chprintf_compiled_t *cfp, const char *fmt);
+  void chvprintfCompiled(BaseSequentialStream *chp,
+                         const chprintf_compiled_t *cfp, va_list ap);
+#endif
 #ifdef __cplusplus
 }
 #endif
@@ -66,7 +159,8 @@ extern "C" {
  *
  * @api
  */
-static inline void chprintf(BaseSequentialStream *chp, const char *fmt, ...) {
+static inline CHPRINTF_FORMAT(2, 3)
+void chprintf(BaseSequentialStream *chp, const char *fmt, ...) {
   va_list ap;
 
   va_start(ap, fmt);
@@ -74,6 +168,27 @@ static inline void chprintf(BaseSequentialStream *chp, const char *fmt, ...) {
   va_end(ap);
 }
 
+#if CHPRINTF_USE_COMPILED || defined(__DOXYGEN__)
+/**
+ * @brief   Formatted output using a compiled format.
+ * @note    The arguments cannot be checked against the format at compile
+ *          time, compile and test the format with @p chprintf() first.
+ *
+ * @param[in] chp       pointer to a @p BaseSequentialStream implementing object
+ * @param[in] cfp       format compiled by @p chprintfCompile()
+ *
+ * @api
+ */
+static inline void chprintfCompiled(BaseSequentialStream *chp,
+                                    const chprintf_compiled_t *cfp, ...) {
+  va_list ap;
+
+  va_start(ap, cfp);
+  chvprintfCompiled(chp, cfp, ap);
+  va_end(ap);
+}
+#endif /* CHPRINTF_USE_COMPILED */
+
 #endif /* _CHPRINTF_H_ */
 
 /** @} */
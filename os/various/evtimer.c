@@ -50,7 +50,6 @@ static void tmrcb(void *p) {
 
   chSysLockFromISR();
   chEvtBroadcastI(&etp->et_es);
-  chVTDoSetI(&etp->et_vt, etp->et_interval, tmrcb, etp);
   chSysUnlockFromISR();
 }
 
@@ -79,7 +78,7 @@ void evtObjectInit(event_timer_t *etp, systime_t time) {
  */
 void evtStart(event_timer_t *etp) {
 
-  chVTSet(&etp->et_vt, etp->et_interval, tmrcb, etp);
+  chVTSetPeriodic(&etp->et_vt, etp->et_interval, tmrcb, etp);
 }
 
 /** @} */
@@ -34,6 +34,31 @@
  */
 event_source_t shell_terminated;
 
+#define SHELL_PROMPT            "ch> "
+
+/**
+ * @brief   Command history type.
+ * @details Lines are stored oldest first, each one NUL terminated.
+ */
+typedef struct {
+  size_t                len;
+#if SHELL_HISTORY_SIZE > 0
+  char                  buf[SHELL_HISTORY_SIZE];
+#endif
+} shell_history_t;
+
+/**
+ * @brief   Tab completion state.
+ */
+typedef struct {
+  const char            *prefix;
+  size_t                len;
+  const char            *match;
+  size_t                common;
+  unsigned              count;
+  BaseSequentialStream  *list;
+} shell_completion_t;
+
 static char *_strtok(char *str, const char *delim, char **saveptr) {
   char *token;
   if (str)
@@ -56,6 +81,15 @@ static void usage(BaseSequentialStream *chp, char *p) {
   chprintf(chp, "Usage: %s\r\n", p);
 }
 
+/**
+ * @brief   Commands handled by the shell thread itself.
+ */
+static const ShellCommand builtin_commands[] = {
+  {"help", NULL},
+  {"exit", NULL},
+  {NULL, NULL}
+};
+
 static void list_commands(BaseSequentialStream *chp, const ShellCommand *scp) {
 
   while (scp->sc_name != NULL) {
@@ -115,21 +149,446 @@ static ShellCommand local_commands[] = {
   {NULL, NULL}
 };
 
-static bool cmdexec(const ShellCommand *scp, BaseSequentialStream *chp,
-                      char *name, int argc, char *argv[]) {
+#define LOCAL_COMMANDS  (sizeof(local_commands) / sizeof(local_commands[0]) - 1)
 
+static size_t count_commands(const ShellCommand *scp) {
+  size_t n = 0;
+
+  while (scp[n].sc_name != NULL) {
+#if SHELL_COMMANDS_SORTED
+    chDbgAssert((n == 0) ||
+                (strcasecmp(scp[n - 1].sc_name, scp[n].sc_name) < 0),
+                "commands not sorted");
+#endif
+    n++;
+  }
+  return n;
+}
+
+static const ShellCommand *cmdfind(const ShellCommand *scp, size_t n,
+                                   const char *name) {
+#if SHELL_COMMANDS_SORTED
+  size_t lo = 0;
+
+  while (lo < n) {
+    size_t mid = lo + (n - lo) / 2;
+    int cmp = strcasecmp(name, scp[mid].sc_name);
+
+    if (cmp == 0)
+      return &scp[mid];
+    if (cmp < 0)
+      n = mid;
+    else
+      lo = mid + 1;
+  }
+#else
+  (void)n;
   while (scp->sc_name != NULL) {
-    if (strcasecmp(scp->sc_name, name) == 0) {
-      scp->sc_function(chp, argc, argv);
+    if (strcasecmp(scp->sc_name, name) == 0)
+      return scp;
+    scp++;
+  }
+#endif
+  return NULL;
+}
+
+static void complete_table(shell_completion_t *cp, const ShellCommand *scp) {
+
+  for (; scp->sc_name != NULL; scp++) {
+    const char *name = scp->sc_name;
+    size_t i;
+
+    if (strncasecmp(name, cp->prefix, cp->len) != 0)
+      continue;
+    if (cp->list != NULL) {
+      chprintf(cp->list, "%s ", name);
+      continue;
+    }
+    if (cp->count++ == 0) {
+      cp->match = name;
+      cp->common = strlen(name);
+      continue;
+    }
+    for (i = cp->len; (i < cp->common) && (name[i] == cp->match[i]); i++)
+      ;
+    cp->common = i;
+  }
+}
+
+static void complete_all(shell_completion_t *cp, const ShellCommand *scp) {
+
+  complete_table(cp, builtin_commands);
+  complete_table(cp, local_commands);
+  if (scp != NULL)
+    complete_table(cp, scp);
+}
+
+/*
+ * Completes the command name being typed, as far as it is unambiguous.
+ * If it already is as long as it can be made, lists the candidates.
+ */
+static char *complete(BaseSequentialStream *chp, char *line, char *p,
+                      unsigned size, const ShellCommand *scp) {
+  shell_completion_t c;
+  const char *s;
+
+  *p = '\0';
+  if (strpbrk(line, " \t") != NULL)
+    return p;
+
+  c.prefix = line;
+  c.len = p - line;
+  c.count = 0;
+  c.list = NULL;
+  complete_all(&c, scp);
+  if (c.count == 0)
+    return p;
+
+  if ((c.count > 1) && (c.common == c.len)) {
+    c.list = chp;
+    chprintf(chp, "\r\n");
+    complete_all(&c, scp);
+    chprintf(chp, "\r\n" SHELL_PROMPT "%s", line);
+    return p;
+  }
+
+  for (s = c.match + c.len; (s < c.match + c.common) &&
+                            (p < line + size - 1); s++) {
+    chSequentialStreamPut(chp, *s);
+    *p++ = *s;
+  }
+  if ((c.count == 1) && (p < line + size - 1)) {
+    chSequentialStreamPut(chp, ' ');
+    *p++ = ' ';
+  }
+  return p;
+}
+
+/* Returns the n-th most recent history line, NULL if there is none.*/
+static const char *history_get(shell_history_t *hp, unsigned n) {
+#if SHELL_HISTORY_SIZE > 0
+  const char *p = hp->buf + hp->len;
+
+  while (p > hp->buf) {
+    p--;
+    while ((p > hp->buf) && (p[-1] != '\0'))
+      p--;
+    if (n-- == 0)
+      return p;
+  }
+#else
+  (void)hp;
+  (void)n;
+#endif
+  return NULL;
+}
+
+static void history_add(shell_history_t *hp, const char *line) {
+#if SHELL_HISTORY_SIZE > 0
+  size_t n = strlen(line) + 1;
+
+  if ((n == 1) || (n > SHELL_HISTORY_SIZE))
+    return;
+  if ((hp->len > 0) && (strcmp(history_get(hp, 0), line) == 0))
+    return;
+
+  /* Makes room by dropping the oldest lines.*/
+  while (hp->len + n > SHELL_HISTORY_SIZE) {
+    size_t old = strlen(hp->buf) + 1;
+
+    memmove(hp->buf, hp->buf + old, hp->len - old);
+    hp->len -= old;
+  }
+  memcpy(hp->buf + hp->len, line, n);
+  hp->len += n;
+#else
+  (void)hp;
+  (void)line;
+#endif
+}
+
+/* Erases the last n characters echoed on the terminal.*/
+static void erase(BaseSequentialStream *chp, size_t n) {
+
+  if (n > 0)
+    chprintf(chp, "\033[%uD\033[K", (unsigned)n);
+}
+
+/* Replaces the line being edited with s, returns the new end of line.*/
+static char *replace(BaseSequentialStream *chp, char *line, char *p,
+                     unsigned size, const char *s) {
+  size_t n = strlen(s);
+
+  if (n > size - 1)
+    n = size - 1;
+  erase(chp, p - line);
+  memcpy(line, s, n);
+  chSequentialStreamWrite(chp, (const uint8_t *)line, n);
+  return line + n;
+}
+
+/*
+ * Line editor behind shellGetLine().  On top of backspace it handles
+ * CTRL-U (kill line) and CTRL-W (kill word).  When @p hp is not NULL it
+ * also offers history recall with the up and down arrows or CTRL-P and
+ * CTRL-N, and tab completion of the command name against the builtin,
+ * local and @p scp commands.  When @p overp is not NULL it tells whether
+ * characters were dropped because the line did not fit.  Such a line is
+ * not added to the history, and ends with the last character received
+ * so that a continuation can still be told.
+ */
+static bool get_line(BaseSequentialStream *chp, char *line, unsigned size,
+                     shell_history_t *hp, const ShellCommand *scp,
+                     bool *overp) {
+  char *p = line;
+  unsigned esc = 0;
+  int hidx = -1;
+  bool over = FALSE;
+
+  while (TRUE) {
+    const char *s;
+    char c;
+
+    if (chSequentialStreamRead(chp, (uint8_t *)&c, 1) == 0)
+      return TRUE;
+
+    /* ANSI escape sequences, ESC [ or ESC O then parameters and a final
+       byte. Only the up and down arrows are acted upon.*/
+    if (esc == 1) {
+      esc = ((c == '[') || (c == 'O')) ? 2 : 0;
+      continue;
+    }
+    if (esc == 2) {
+      if ((c >= 0x30) && (c <= 0x3f))
+        continue;
+      esc = 0;
+      if (c == 'A')
+        c = 0x10;
+      else if (c == 'B')
+        c = 0x0e;
+      else
+        continue;
+    }
+
+    switch (c) {
+    case 4:
+      chprintf(chp, "^D");
+      return TRUE;
+    case 0x1b:
+      esc = 1;
+      continue;
+    case '\b':
+    case 0x7f:
+      if (p != line) {
+        chSequentialStreamPut(chp, '\b');
+        chSequentialStreamPut(chp, 0x20);
+        chSequentialStreamPut(chp, '\b');
+        p--;
+      }
+      continue;
+    case 0x15:
+      erase(chp, p - line);
+      p = line;
+      over = FALSE;
+      continue;
+    case 0x17:
+      s = p;
+      while ((p != line) && (p[-1] == ' '))
+        p--;
+      while ((p != line) && (p[-1] != ' '))
+        p--;
+      erase(chp, s - p);
+      continue;
+    case 0x10:
+      if ((hp != NULL) && ((s = history_get(hp, hidx + 1)) != NULL)) {
+        hidx++;
+        p = replace(chp, line, p, size, s);
+        over = FALSE;
+      }
+      continue;
+    case 0x0e:
+      if ((hp != NULL) && (hidx >= 0)) {
+        hidx--;
+        s = (hidx >= 0) ? history_get(hp, hidx) : "";
+        p = replace(chp, line, p, size, s);
+        over = FALSE;
+      }
+      continue;
+    case '\t':
+      if (hp != NULL)
+        p = complete(chp, line, p, size, scp);
+      continue;
+    case '\r':
+      chprintf(chp, "\r\n");
+      *p = 0;
+      if ((hp != NULL) && !over)
+        history_add(hp, line);
+      if (overp != NULL)
+        *overp = over;
       return FALSE;
     }
-    scp++;
+    if (c < 0x20)
+      continue;
+    if (p < line + size - 1) {
+      chSequentialStreamPut(chp, c);
+      *p++ = (char)c;
+    }
+    else {
+      if (p != line)
+        p[-1] = (char)c;
+      over = TRUE;
+    }
+  }
+}
+
+static size_t null_write(void *ip, const uint8_t *bp, size_t n) {
+
+  (void)ip;
+  (void)bp;
+  return n;
+}
+
+static size_t null_read(void *ip, uint8_t *bp, size_t n) {
+
+  (void)ip;
+  (void)bp;
+  (void)n;
+  return 0;
+}
+
+static msg_t null_put(void *ip, uint8_t b) {
+
+  (void)ip;
+  (void)b;
+  return MSG_OK;
+}
+
+static msg_t null_get(void *ip) {
+
+  (void)ip;
+  return MSG_RESET;
+}
+
+static const struct BaseSequentialStreamVMT null_vmt = {
+  null_write, null_read, null_put, null_get
+};
+
+/**
+ * @brief   Output of the commands run in quiet mode.
+ */
+static BaseSequentialStream null_stream = {&null_vmt};
+
+/**
+ * @brief   Shell that reported the failure of its running command.
+ */
+static thread_t *failed_tp;
+
+/*
+ * Cuts the next command off a batch line. Returns the rest of the line,
+ * or NULL after the last command. @p andp tells whether the separator
+ * was "&&" rather than ";".
+ */
+static char *split_batch(char *s, bool *andp) {
+
+  for (; *s != '\0'; s++) {
+    if (*s == ';') {
+      *s = '\0';
+      *andp = FALSE;
+      return s + 1;
+    }
+    if ((s[0] == '&') && (s[1] == '&')) {
+      *s = '\0';
+      *andp = TRUE;
+      return s + 2;
+    }
+  }
+  return NULL;
+}
+
+/*
+ * Runs a single command of a batch, returns FALSE if it failed. A
+ * leading '@' discards the command output, only reporting a failure.
+ */
+static bool cmdexec(BaseSequentialStream *chp, const ShellConfig *scfg,
+                    size_t ncmds, char *line, bool *exitp) {
+  const ShellCommand *scp = scfg->sc_commands;
+  const ShellCommand *cp;
+  BaseSequentialStream *out = chp;
+  char *lp, *cmd, *tokp;
+  char *args[SHELL_MAX_ARGUMENTS + 1];
+  bool failed;
+  int n;
+
+  line += strspn(line, " \t");
+  if (*line == '@') {
+    out = &null_stream;
+    line++;
+  }
+
+  lp = _strtok(line, " \t", &tokp);
+  cmd = lp;
+  n = 0;
+  if (cmd == NULL)
+    return TRUE;
+  while ((lp = _strtok(NULL, " \t", &tokp)) != NULL) {
+    if (n >= SHELL_MAX_ARGUMENTS) {
+      chprintf(chp, "too many arguments\r\n");
+      return FALSE;
+    }
+    args[n++] = lp;
+  }
+  args[n] = NULL;
+
+  if (strcasecmp(cmd, "exit") == 0) {
+    if (n > 0) {
+      usage(chp, "exit");
+      return FALSE;
+    }
+    *exitp = TRUE;
+    return TRUE;
+  }
+  if (strcasecmp(cmd, "help") == 0) {
+    if (n > 0) {
+      usage(chp, "help");
+      return FALSE;
+    }
+    chprintf(out, "Commands: ");
+    list_commands(out, builtin_commands);
+    list_commands(out, local_commands);
+    if (scp != NULL)
+      list_commands(out, scp);
+    chprintf(out, "\r\n");
+    return TRUE;
   }
-  return TRUE;
+
+  cp = cmdfind(local_commands, LOCAL_COMMANDS, cmd);
+  if ((cp == NULL) && (scp != NULL))
+    cp = cmdfind(scp, ncmds, cmd);
+  if (cp == NULL) {
+    chprintf(chp, "%s ?\r\n", cmd);
+    return FALSE;
+  }
+
+  failed_tp = NULL;
+  if (scfg->sc_busy != NULL)
+    scfg->sc_busy(TRUE);
+  cp->sc_function(out, n, args);
+  if (scfg->sc_busy != NULL)
+    scfg->sc_busy(FALSE);
+  failed = (failed_tp == chThdGetSelfX());
+  if (failed && (out != chp))
+    chprintf(chp, "%s: failed\r\n", cmd);
+  return !failed;
 }
 
 /**
  * @brief   Shell thread function.
+ * @details Each line is a batch of commands separated by ";", or by "&&"
+ *          to skip the rest of the chain when a command fails. A line
+ *          ending with a backslash continues on the next one, so a whole
+ *          script is read before any of it runs. A batch that does not
+ *          fit in @p SHELL_MAX_LINE_LENGTH is discarded with an error
+ *          rather than run truncated.
  *
  * @param[in] p         pointer to a @p BaseSequentialStream object
  * @return              Termination reason.
@@ -137,58 +596,55 @@ static bool cmdexec(const ShellCommand *scp, BaseSequentialStream *chp,
  * @retval MSG_RESET    terminated by reset condition on the I/O channel.
  */
 static msg_t shell_thread(void *p) {
-  int n;
-  BaseSequentialStream *chp = ((ShellConfig *)p)->sc_channel;
-  const ShellCommand *scp = ((ShellConfig *)p)->sc_commands;
-  char *lp, *cmd, *tokp, line[SHELL_MAX_LINE_LENGTH];
-  char *args[SHELL_MAX_ARGUMENTS + 1];
+  const ShellConfig *scfg = p;
+  BaseSequentialStream *chp = scfg->sc_channel;
+  const ShellCommand *scp = scfg->sc_commands;
+  size_t ncmds = (scp != NULL) ? count_commands(scp) : 0;
+  char *lp, *cmd, line[SHELL_MAX_LINE_LENGTH];
+  bool cond, skip, ok, over, toolong, done = FALSE;
+  shell_history_t history;
+  size_t len;
 
   chRegSetThreadName("shell");
+  history.len = 0;
   chprintf(chp, "\r\nChibiOS/RT Shell\r\n");
-  while (TRUE) {
-    chprintf(chp, "ch> ");
-    if (shellGetLine(chp, line, sizeof(line))) {
-      chprintf(chp, "\r\nlogout");
-      break;
-    }
-    lp = _strtok(line, " \t", &tokp);
-    cmd = lp;
-    n = 0;
-    while ((lp = _strtok(NULL, " \t", &tokp)) != NULL) {
-      if (n >= SHELL_MAX_ARGUMENTS) {
-        chprintf(chp, "too many arguments\r\n");
-        cmd = NULL;
-        break;
+  while (!done) {
+    chprintf(chp, SHELL_PROMPT);
+    len = 0;
+    toolong = FALSE;
+    while (TRUE) {
+      if (get_line(chp, line + len, sizeof(line) - len, &history, scp,
+                   &over)) {
+        chprintf(chp, "\r\nlogout");
+        goto out;
       }
-      args[n++] = lp;
-    }
-    args[n] = NULL;
-    if (cmd != NULL) {
-      if (strcasecmp(cmd, "exit") == 0) {
-        if (n > 0) {
-          usage(chp, "exit");
-          continue;
-        }
+      len += strlen(line + len);
+      toolong = toolong || over;
+      if ((len == 0) || (line[len - 1] != '\\'))
         break;
+      line[len - 1] = ' ';
+      /* Once too long, the rest of the batch is read and thrown away.*/
+      if (toolong || (len >= sizeof(line) - 1)) {
+        toolong = TRUE;
+        len = 0;
       }
-      else if (strcasecmp(cmd, "help") == 0) {
-        if (n > 0) {
-          usage(chp, "help");
-          continue;
-        }
-        chprintf(chp, "Commands: help exit ");
-        list_commands(chp, local_commands);
-        if (scp != NULL)
-          list_commands(chp, scp);
-        chprintf(chp, "\r\n");
-      }
-      else if (cmdexec(local_commands, chp, cmd, n, args) &&
-          ((scp == NULL) || cmdexec(scp, chp, cmd, n, args))) {
-        chprintf(chp, "%s", cmd);
-        chprintf(chp, " ?\r\n");
-      }
+      chprintf(chp, "> ");
+    }
+    if (toolong) {
+      chprintf(chp, "line too long\r\n");
+      continue;
+    }
+
+    lp = line;
+    skip = FALSE;
+    while ((lp != NULL) && !done) {
+      cmd = lp;
+      lp = split_batch(lp, &cond);
+      ok = skip || cmdexec(chp, scfg, ncmds, cmd, &done);
+      skip = cond && (skip || !ok);
     }
   }
+out:
   shellExit(MSG_OK);
   /* Never executed, silencing a warning.*/
   return 0;
@@ -222,6 +678,19 @@ void shellExit(msg_t msg) {
   chThdExitS(msg);
 }
 
+/**
+ * @brief   Marks the running command as failed.
+ * @details Stops the rest of an "&&" chain and reports the failure of a
+ *          command run in quiet mode.
+ * @note    Must be invoked from the command handlers.
+ *
+ * @api
+ */
+void shellSetError(void) {
+
+  failed_tp = chThdGetSelfX();
+}
+
 /**
  * @brief   Spawns a new shell.
  * @pre     @p CH_CFG_USE_HEAP and @p CH_CFG_USE_DYNAMIC must be enabled.
@@ -271,38 +740,8 @@ thread_t *shellCreateStatic(const ShellConfig *scp, void *wsp,
  * @api
  */
 bool shellGetLine(BaseSequentialStream *chp, char *line, unsigned size) {
-  char *p = line;
 
-  while (TRUE) {
-    char c;
-
-    if (chSequentialStreamRead(chp, (uint8_t *)&c, 1) == 0)
-      return TRUE;
-    if (c == 4) {
-      chprintf(chp, "^D");
-      return TRUE;
-    }
-    if (c == '\b' || c == 0x7f) {
-      if (p != line) {
-        chSequentialStreamPut(chp, '\b');
-        chSequentialStreamPut(chp, 0x20);
-        chSequentialStreamPut(chp, '\b');
-        p--;
-      }
-      continue;
-    }
-    if (c == '\r') {
-      chprintf(chp, "\r\n");
-      *p = 0;
-      return FALSE;
-    }
-    if (c < 0x20)
-      continue;
-    if (p < line + size - 1) {
-      chSequentialStreamPut(chp, c);
-      *p++ = (char)c;
-    }
-  }
+  return get_line(chp, line, size, NULL, NULL, NULL);
 }
 
 /** @} */
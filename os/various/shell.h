@@ -39,11 +39,40 @@
 #define SHELL_MAX_ARGUMENTS         4
 #endif
 
+/**
+ * @brief   Command history buffer size.
+ * @details Previous lines are kept back to back in a buffer of this many
+ *          bytes on the shell thread stack, the oldest ones are dropped
+ *          first. Zero disables the history.
+ */
+#if !defined(SHELL_HISTORY_SIZE) || defined(__DOXYGEN__)
+#define SHELL_HISTORY_SIZE          128
+#endif
+
+/**
+ * @brief   Sorted commands table.
+ * @details If enabled the @p sc_commands table of every shell must be
+ *          sorted by name, ignoring case, and is searched by bisection
+ *          instead of linearly.
+ */
+#if !defined(SHELL_COMMANDS_SORTED) || defined(__DOXYGEN__)
+#define SHELL_COMMANDS_SORTED       FALSE
+#endif
+
+#if (SHELL_HISTORY_SIZE > 0) && (SHELL_HISTORY_SIZE < SHELL_MAX_LINE_LENGTH)
+#error "SHELL_HISTORY_SIZE must be zero or at least SHELL_MAX_LINE_LENGTH"
+#endif
+
 /**
  * @brief   Command handler function type.
  */
 typedef void (*shellcmd_t)(BaseSequentialStream *chp, int argc, char *argv[]);
 
+/**
+ * @brief   Command execution notification type.
+ */
+typedef void (*shellbusy_t)(bool busy);
+
 /**
  * @brief   Custom command entry type.
  */
@@ -60,6 +89,9 @@ typedef struct {
                                                  to the shell.              */
   const ShellCommand    *sc_commands;       /**< @brief Shell extra commands
                                                  table.                     */
+  shellbusy_t           sc_busy;            /**< @brief Optional, invoked with
+                                                 @p true before and @p false
+                                                 after each command.        */
 } ShellConfig;
 
 #if !defined(__DOXYGEN__)
@@ -71,6 +103,7 @@ extern "C" {
 #endif
   void shellInit(void);
   void shellExit(msg_t msg);
+  void shellSetError(void);
   thread_t *shellCreate(const ShellConfig *scp, size_t size, tprio_t prio);
   thread_t *shellCreateStatic(const ShellConfig *scp, void *wsp,
                               size_t size, tprio_t prio);
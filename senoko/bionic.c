@@ -34,10 +34,10 @@
  * that weren't getting correctly linked.
  */
 
+#include <stddef.h>
 #include <stdint.h>
 #include "bionic.h"
 typedef unsigned char u_char;
-typedef unsigned int size_t;
 int bionic_errno;
 
 #if !defined(NULL)
@@ -156,6 +156,23 @@ int strcasecmp(const char *s1, const char *s2)
 	return (cm[*us1] - cm[*--us2]);
 }
 
+int strncasecmp(const char *s1, const char *s2, size_t n)
+{
+	if (n != 0) {
+		const u_char *cm = charmap;
+		const u_char *us1 = (const u_char *)s1;
+		const u_char *us2 = (const u_char *)s2;
+
+		do {
+			if (cm[*us1] != cm[*us2++])
+				return (cm[*us1] - cm[*--us2]);
+			if (*us1++ == '\0')
+				break;
+		} while (--n != 0);
+	}
+	return (0);
+}
+
 /*
  * sizeof(word) MUST BE A POWER OF TWO
  * SO THAT wmask BELOW IS ALL ONES
@@ -165,6 +182,19 @@ typedef	long word;		/* "word" used for optimal copy speed */
 #define	wsize	sizeof(word)
 #define	wmask	(wsize - 1)
 
+/* Bytes per unrolled iteration of the word loops below */
+#define	bsize	(4 * wsize)
+
+#if defined(__ARM_FEATURE_UNALIGNED)
+/*
+ * Cortex-M3 does unaligned LDR/STR in hardware, but LDM/STM still
+ * fault, so unaligned words must be read through this.
+ */
+struct uword {
+	word w;
+} __attribute__((packed));
+#endif
+
 #define MEMCOPY
 /*
  * Copy a block of memory, handling overlap.
@@ -208,13 +238,26 @@ void bcopy(const void *src0, void *dst0, size_t length)
 				t = length;
 			else
 				t = wsize - (t & wmask);
+#if defined(__ARM_FEATURE_UNALIGNED)
+			if (t == length && length >= bsize)
+				goto unaligned;
+#endif
 			length -= t;
 			TLOOP1(*dst++ = *src++);
 		}
 		/*
-		 * Copy whole words, then mop up any trailing bytes.
+		 * Copy blocks of four words, which the compiler turns
+		 * into LDM/STM bursts, then whole words, then mop up any
+		 * trailing bytes.
 		 */
-		t = length / wsize;
+		t = length / bsize;
+		TLOOP(
+			((word *)dst)[0] = ((const word *)src)[0];
+			((word *)dst)[1] = ((const word *)src)[1];
+			((word *)dst)[2] = ((const word *)src)[2];
+			((word *)dst)[3] = ((const word *)src)[3];
+			src += bsize; dst += bsize);
+		t = (length & (bsize - 1)) / wsize;
 		TLOOP(*(word *)dst = *(word *)src; src += wsize; dst += wsize);
 		t = length & wmask;
 		TLOOP(*dst++ = *src++);
@@ -240,6 +283,23 @@ void bcopy(const void *src0, void *dst0, size_t length)
 		t = length & wmask;
 		TLOOP(*--dst = *--src);
 	}
+#if defined(__ARM_FEATURE_UNALIGNED)
+	goto done;
+
+unaligned:
+	/*
+	 * Forward copy with mismatched low bits: align the destination
+	 * and fetch the source a word at a time anyway.
+	 */
+	t = -(long)dst & wmask;
+	length -= t;
+	TLOOP(*dst++ = *src++);
+	t = length / wsize;
+	TLOOP(*(word *)dst = ((const struct uword *)src)->w;
+	      src += wsize; dst += wsize);
+	t = length & wmask;
+	TLOOP(*dst++ = *src++);
+#endif
 done:
 #if defined(MEMCOPY) || defined(MEMMOVE)
 	return (dst0);
@@ -278,6 +338,13 @@ static int isalpha(int c)
 	return isupper(c) || islower(c);
 }
 
+int toupper(int c)
+{
+	if (islower(c))
+		c -= 'a' - 'A';
+	return c;
+}
+
 unsigned long strtoul(const char *nptr, char **endptr, int base)
 {
 	const char *s;
@@ -349,33 +416,72 @@ long strtol(const char *cp,char **endp,unsigned int base)
 void *memset(void *dst0, int val, size_t length)
 {
 	uint8_t *ptr = dst0;
-	while(length--)
+	word w;
+	size_t t;
+
+	/* Too short to be worth aligning */
+	if (length < bsize) {
+		while (length--)
+			*ptr++ = val;
+		return dst0;
+	}
+
+	t = -(long)ptr & wmask;
+	length -= t;
+	while (t--)
+		*ptr++ = val;
+
+	/* Replicate the byte into every lane of a word */
+	w = (word)((unsigned long)-1 / 0xff * (uint8_t)val);
+
+	t = length / bsize;
+	while (t--) {
+		((word *)ptr)[0] = w;
+		((word *)ptr)[1] = w;
+		((word *)ptr)[2] = w;
+		((word *)ptr)[3] = w;
+		ptr += bsize;
+	}
+	t = (length & (bsize - 1)) / wsize;
+	while (t--) {
+		*(word *)ptr = w;
+		ptr += wsize;
+	}
+	t = length & wmask;
+	while (t--)
 		*ptr++ = val;
 	return dst0;
 }
 
+/* Non-zero if any byte of the 32-bit word is zero */
+#define	haszero(w)	(((w) - 0x01010101UL) & ~(w) & 0x80808080UL)
+
+/*
+ * Look for the terminator a word at a time once aligned.  The aligned
+ * load may read past the end of the string, but never past the end of
+ * the word holding it, so it can't fault.
+ */
 size_t strlen (const char *__s)
 {
-  size_t i = 0;
-  while(__s[i++]);
-  return i;
+  const char *p = __s;
+  const uint32_t *w;
+
+  for (; (unsigned long)p & (sizeof(*w) - 1); p++)
+    if (!*p)
+      return p - __s;
+
+  for (w = (const uint32_t *)p; !haszero(*w); w++)
+    ;
+
+  for (p = (const char *)w; *p; p++)
+    ;
+  return p - __s;
 }
 
 size_t strnlen (const char *__string, size_t __maxlen)
 {
   size_t i = 0;
-  while(__string[i++] && i < __maxlen);
+  while (i < __maxlen && __string[i])
+    i++;
   return i;
 }
-
-extern int sprintf(char * buf, const char *fmt, ...);
-const char *minutesToTime(uint32_t minutes)
-{
-	static char str[16];
-	int hours = minutes / 60;
-
-	minutes -= (hours * 60);
-
-	sprintf(str, "%d:%02d", hours, minutes);
-	return str;
-}
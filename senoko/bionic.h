@@ -7,6 +7,7 @@
 #define ULONG_MAX	4294967295UL
 
 int strcasecmp(const char *s1, const char *s2);
+int strncasecmp(const char *s1, const char *s2, size_t n);
 void *memcpy(void *dst0, const void *src0, size_t length);
 void *memset(void *dst0, int val, size_t length);
 unsigned long strtoul(const char *nptr, char **endptr, int base);
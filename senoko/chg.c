@@ -8,6 +8,7 @@
 #include "bionic.h"
 #include "senoko.h"
 #include "senoko-i2c.h"
+#include "senoko-wdt.h"
 #include "power.h"
 
 #define CHG_ADDR 0x9
@@ -15,6 +16,9 @@
 /* Number of milliseconds between runthrus of the charger thread */
 #define THREAD_SLEEP_MS 52500
 
+/* Longest the charger thread may go without checking in */
+#define CHG_WDT_TIMEOUT_MS (THREAD_SLEEP_MS + 30000)
+
 /* Number of times to try looking for the gas gauge during startup */
 #define CHG_TRIES 50
 
@@ -177,9 +181,11 @@ bool chgPaused(void) {
 
 static THD_WORKING_AREA(waChgThread, 256);
 static msg_t chg_thread(void *arg) {
+  int wdt_id;
   (void)arg;
 
   chRegSetThreadName("charge controller");
+  wdt_id = senokoWatchdogRegister("charge controller", CHG_WDT_TIMEOUT_MS);
   chThdSleepMilliseconds(200);
 
   senokoI2cAcquireBus();
@@ -196,6 +202,7 @@ static msg_t chg_thread(void *arg) {
     static enum gg_state system_state = -1;
 
     senokoI2cReleaseBus();
+    senokoWatchdogCheckin(wdt_id);
     chThdSleepMilliseconds(THREAD_SLEEP_MS);
     senokoI2cAcquireBus();
 
@@ -267,7 +274,7 @@ static msg_t chg_thread(void *arg) {
 
     /* If we're unplugged and low on power, turn off the mainboard. */
     if ((voltage <= termvolt) && powerIsOn() && acRemoved())
-      powerOff();
+      powerLowBattery();
 
     /* Figure out what the gas gauge wants us to charge at.*/
     ret = ggChargingVoltage(&voltage);
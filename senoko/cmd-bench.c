@@ -0,0 +1,368 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006-2013 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "ch.h"
+#include "hal.h"
+#include "shell.h"
+#include "chprintf.h"
+
+#include "bionic.h"
+#include "membench.h"
+#include "senoko.h"
+
+/* Calls timed per measurement */
+#define MEMBENCH_ITERATIONS 64
+
+/* Lines formatted per measurement, the best of PRINTF_ROUNDS is kept */
+#define PRINTF_LINES        16
+#define PRINTF_ROUNDS       3
+
+/* Ring under test, the smallest that shows wrapping and dropping */
+#define RING_SIZE           4
+#define RING_WATERMARK      2
+
+/* Bytes written one at a time per round, then read back as a block */
+#define RING_BLOCK          16
+#define RING_ROUNDS         256
+
+/*
+ * Output sink for the printf benchmark.  Like a serial output queue,
+ * every call takes the system lock once.  The data itself is dropped.
+ */
+struct SinkStreamVMT {
+  _base_sequential_stream_methods
+};
+
+typedef struct {
+  const struct SinkStreamVMT *vmt;
+  uint32_t calls;
+  uint32_t bytes;
+} SinkStream;
+
+static const struct membench_impl bionic_impl = {
+  memcpy,
+  memset,
+  strlen,
+};
+
+/* The realtime counter counts core cycles */
+static uint32_t cycles(void) {
+  return chSysGetRealtimeCounterX();
+}
+
+static void bench_mem(BaseSequentialStream *chp) {
+  struct membench_result r;
+  uint8_t *buf;
+  int test;
+
+  buf = chHeapAlloc(NULL, MEMBENCH_BUFFER_SIZE);
+  if (!buf) {
+    chprintf(chp, "Not enough memory\r\n");
+    shellSetError();
+    return;
+  }
+
+  chprintf(chp, "Routine   Size  Before  After  (cycles/call)\r\n");
+  for (test = 0; membench_run(test, &bionic_impl, buf, MEMBENCH_ITERATIONS,
+                              cycles, &r); test++)
+    chprintf(chp, "%-8s %5u %7lu %6lu  %lu.%02lux\r\n",
+        r.name, r.size,
+        r.baseline / MEMBENCH_ITERATIONS, r.current / MEMBENCH_ITERATIONS,
+        r.baseline / r.current, (r.baseline * 100 / r.current) % 100);
+
+  chHeapFree(buf);
+}
+
+static size_t sink_write(void *ip, const uint8_t *bp, size_t n) {
+  SinkStream *ssp = ip;
+
+  (void)bp;
+  chSysLock();
+  ssp->calls++;
+  ssp->bytes += n;
+  chSysUnlock();
+  return n;
+}
+
+static size_t sink_read(void *ip, uint8_t *bp, size_t n) {
+
+  (void)ip;
+  (void)bp;
+  (void)n;
+  return 0;
+}
+
+static msg_t sink_put(void *ip, uint8_t b) {
+  SinkStream *ssp = ip;
+
+  (void)b;
+  chSysLock();
+  ssp->calls++;
+  ssp->bytes++;
+  chSysUnlock();
+  return MSG_OK;
+}
+
+static msg_t sink_get(void *ip) {
+
+  (void)ip;
+  return MSG_RESET;
+}
+
+/* What chvprintf cost before it buffered: one locked put per character */
+static size_t sink_write_bytes(void *ip, const uint8_t *bp, size_t n) {
+  size_t i;
+
+  for (i = 0; i < n; i++)
+    sink_put(ip, bp[i]);
+  return n;
+}
+
+static const struct SinkStreamVMT sink_chunked_vmt = {
+  sink_write, sink_read, sink_put, sink_get
+};
+
+static const struct SinkStreamVMT sink_bytes_vmt = {
+  sink_write_bytes, sink_read, sink_put, sink_get
+};
+
+/* A row of the threads command */
+static void print_threads_line(BaseSequentialStream *chp) {
+  chprintf(chp, "%.8lx %.8lx %.8lx %4lu %4lu %12s  %-10s\r\n",
+      0x20000c40UL, 0x08001a2dUL, 0x20000bd8UL, 64UL, 0UL,
+      "WTSEM", "i2c slave");
+}
+
+/* A row of the stats command */
+static void print_stats_line(BaseSequentialStream *chp) {
+  chprintf(chp, "%-19s %d mV\r\n", "Voltage:", 11873);
+}
+
+#if CHPRINTF_USE_COMPILED
+static chprintf_compiled_t threads_fmt;
+
+static void print_threads_compiled(BaseSequentialStream *chp) {
+  chprintfCompiled(chp, &threads_fmt,
+      0x20000c40UL, 0x08001a2dUL, 0x20000bd8UL, 64UL, 0UL,
+      "WTSEM", "i2c slave");
+}
+#endif
+
+/* Cycles per line of print into the sink, and stream calls per line */
+static void time_printf(BaseSequentialStream *chp, const char *name,
+                        const char *stream,
+                        const struct SinkStreamVMT *vmt,
+                        void (*print)(BaseSequentialStream *chp)) {
+  SinkStream sink;
+  uint32_t best = UINT32_MAX, start, t;
+  int round, i;
+
+  sink.vmt = vmt;
+  for (round = 0; round < PRINTF_ROUNDS; round++) {
+    sink.calls = 0;
+    sink.bytes = 0;
+    start = chSysGetRealtimeCounterX();
+    for (i = 0; i < PRINTF_LINES; i++)
+      print((BaseSequentialStream *)&sink);
+    t = chSysGetRealtimeCounterX() - start;
+    if (t < best)
+      best = t;
+  }
+
+  chprintf(chp, "%-8s %-9s %5lu %5lu %7lu\r\n", name, stream,
+      sink.bytes / PRINTF_LINES, sink.calls / PRINTF_LINES,
+      best / PRINTF_LINES);
+}
+
+static void bench_printf(BaseSequentialStream *chp) {
+
+  chprintf(chp, "Line     Stream    Bytes Calls  Cycles (per line)\r\n");
+  time_printf(chp, "threads", "per char", &sink_bytes_vmt,
+              print_threads_line);
+  time_printf(chp, "threads", "chunked", &sink_chunked_vmt,
+              print_threads_line);
+#if CHPRINTF_USE_COMPILED
+  if (chprintfCompile(&threads_fmt,
+                      "%.8lx %.8lx %.8lx %4lu %4lu %12s  %-10s\r\n"))
+    time_printf(chp, "threads", "compiled", &sink_chunked_vmt,
+                print_threads_compiled);
+#endif
+  time_printf(chp, "stats", "per char", &sink_bytes_vmt,
+              print_stats_line);
+  time_printf(chp, "stats", "chunked", &sink_chunked_vmt,
+              print_stats_line);
+}
+
+static input_queue_t ring_iq;
+static byte_ring_t ring;
+static uint8_t ring_buf[RING_BLOCK * 4];
+static char ring_trace[32];
+static unsigned ring_traced;
+
+/* Records what the reader got, as text */
+static void ring_emit(char c) {
+  if (ring_traced < sizeof(ring_trace) - 1)
+    ring_trace[ring_traced++] = c;
+  ring_trace[ring_traced] = '\0';
+}
+
+/* Traces each return of brReadTimeout(), a '|' marks where it returned */
+static THD_WORKING_AREA(waRingReader, 192);
+static msg_t ring_reader(void *arg) {
+  uint8_t buf[RING_SIZE];
+  size_t i, n;
+
+  (void)arg;
+  chRegSetThreadName("ring reader");
+  do {
+    n = brReadTimeout(&ring, buf, sizeof(buf), TIME_INFINITE);
+    for (i = 0; i < n; i++)
+      ring_emit(buf[i]);
+    ring_emit('|');
+  } while (n == 0 || buf[n - 1] != 'Z');
+  return 0;
+}
+
+/* Reads up to n bytes without waiting */
+static void ring_read(size_t n) {
+  uint8_t buf[RING_SIZE * 2];
+  size_t i;
+
+  n = brReadTimeout(&ring, buf, n, TIME_IMMEDIATE);
+  for (i = 0; i < n; i++)
+    ring_emit(buf[i]);
+  ring_emit('|');
+}
+
+/* Lets the reader run if it has been woken, it must not have been */
+static void ring_reschedule(void) {
+  chSysLock();
+  chSchRescheduleS();
+  chSysUnlock();
+}
+
+/*
+ * Ordering across the buffer end and dropping when full, then the wakeups
+ * of a waiting reader, which must return exactly when the watermark is
+ * reached.  Woken from thread context, it runs before brPutX() returns.
+ */
+static bool ring_check(BaseSequentialStream *chp) {
+  thread_t *tp;
+
+  ring_traced = 0;
+  brObjectInit(&ring, ring_buf, RING_SIZE, RING_WATERMARK);
+  brWriteX(&ring, (const uint8_t *)"ABC", 3);
+  ring_read(2);
+  brWriteX(&ring, (const uint8_t *)"DEF", 3);
+  brPutX(&ring, 'X');
+  brWriteX(&ring, (const uint8_t *)"XY", 2);
+  ring_read(RING_SIZE * 2);
+  ring_read(RING_SIZE * 2);
+  chprintf(chp, "Ordering and drops: %s, %u dropped\r\n",
+      ring_trace, brGetDroppedX(&ring));
+  if (strcasecmp(ring_trace, "AB|CDEF||") || brGetDroppedX(&ring) != 3)
+    return false;
+
+  ring_traced = 0;
+  brObjectInit(&ring, ring_buf, RING_SIZE, RING_WATERMARK);
+  tp = chThdCreateStatic(waRingReader, sizeof(waRingReader),
+                         chThdGetPriorityX() + 1, ring_reader, NULL);
+  brPutX(&ring, 'A');
+  ring_reschedule();
+  brPutX(&ring, 'B');
+  brPutX(&ring, 'C');
+  ring_reschedule();
+  brPutX(&ring, 'D');
+  brPutX(&ring, 'E');
+  brPutX(&ring, 'F');
+  ring_reschedule();
+  brWriteX(&ring, (const uint8_t *)"GHI", 3);
+  brWriteX(&ring, (const uint8_t *)"X", 1);
+  ring_reschedule();
+  brWriteX(&ring, (const uint8_t *)"YZ", 2);
+  chThdWait(tp);
+  chprintf(chp, "Reader wakeups:     %s, %u dropped\r\n",
+      ring_trace, brGetDroppedX(&ring));
+  return !strcasecmp(ring_trace, "AB|CD|EF|GHI|XYZ|") &&
+         brGetDroppedX(&ring) == 0;
+}
+
+/* Cycles per byte put into an input queue under the lock, as an ISR does */
+static uint32_t time_iq(void) {
+  uint8_t buf[RING_BLOCK];
+  uint32_t start;
+  int round, i;
+
+  iqObjectInit(&ring_iq, ring_buf, sizeof(ring_buf), NULL, NULL);
+  start = chSysGetRealtimeCounterX();
+  for (round = 0; round < RING_ROUNDS; round++) {
+    for (i = 0; i < RING_BLOCK; i++) {
+      chSysLock();
+      iqPutI(&ring_iq, (uint8_t)i);
+      chSysUnlock();
+    }
+    iqReadTimeout(&ring_iq, buf, RING_BLOCK, TIME_IMMEDIATE);
+  }
+  return (chSysGetRealtimeCounterX() - start) / (RING_BLOCK * RING_ROUNDS);
+}
+
+/* The same through a byte ring, which takes no lock */
+static uint32_t time_ring(void) {
+  uint8_t buf[RING_BLOCK];
+  uint32_t start;
+  int round, i;
+
+  brObjectInit(&ring, ring_buf, sizeof(ring_buf), sizeof(ring_buf));
+  start = chSysGetRealtimeCounterX();
+  for (round = 0; round < RING_ROUNDS; round++) {
+    for (i = 0; i < RING_BLOCK; i++)
+      brPutX(&ring, (uint8_t)i);
+    brReadTimeout(&ring, buf, RING_BLOCK, TIME_IMMEDIATE);
+  }
+  return (chSysGetRealtimeCounterX() - start) / (RING_BLOCK * RING_ROUNDS);
+}
+
+static void bench_ring(BaseSequentialStream *chp) {
+
+  if (!ring_check(chp)) {
+    chprintf(chp, "Byte ring check failed\r\n");
+    shellSetError();
+    return;
+  }
+  chprintf(chp, "Input queue, iqPutI: %4lu cycles/byte\r\n", time_iq());
+  chprintf(chp, "Byte ring, brPutX:   %4lu cycles/byte\r\n", time_ring());
+}
+
+static void print_usage(BaseSequentialStream *chp) {
+  chprintf(chp, "Usage: bench mem|printf|ring\r\n");
+  chprintf(chp, "    mem     Time memcpy, memset and strlen per size\r\n");
+  chprintf(chp, "    printf  Time chprintf per formatted line\r\n");
+  chprintf(chp, "    ring    Check a byte ring, time it against a queue\r\n");
+}
+
+void cmd_bench(BaseSequentialStream *chp, int argc, char *argv[]) {
+
+  if (argc == 1 && !strcasecmp(argv[0], "mem"))
+    bench_mem(chp);
+  else if (argc == 1 && !strcasecmp(argv[0], "printf"))
+    bench_printf(chp);
+  else if (argc == 1 && !strcasecmp(argv[0], "ring"))
+    bench_ring(chp);
+  else {
+    print_usage(chp);
+    shellSetError();
+  }
+}
@@ -66,12 +66,12 @@ void cmd_chg(BaseSequentialStream *chp, int argc, char *argv[]) {
         goto out;
       }
 
-      chprintf(chp, "Setting charger: %dmA @ %dmV (input: %dmA)... ",
+      chprintf(chp, "Setting charger: %lumA @ %lumV (input: %lumA)... ",
           current, voltage, input);
       ret = chgSetAll(current, voltage, input);
     }
     else {
-      chprintf(chp, "Setting charger: %dmA @ %dmV... ", current, voltage);
+      chprintf(chp, "Setting charger: %lumA @ %lumV... ", current, voltage);
       ret = chgSet(current, voltage);
     }
 
@@ -95,7 +95,7 @@ void cmd_chg(BaseSequentialStream *chp, int argc, char *argv[]) {
       goto out;
     }
 
-    chprintf(chp, "Setting charger input current to %dmA\r\n", input);
+    chprintf(chp, "Setting charger input current to %lumA\r\n", input);
     ret = chgSetInput(input);
   }
 
@@ -14,134 +14,149 @@
     limitations under the License.
 */
 
+#include <time.h>
+
 #include "ch.h"
 #include "hal.h"
 #include "rtc.h"
 #include "chprintf.h"
+#include "shell.h"
 
 #include "bionic.h"
 #include "senoko.h"
 
 #if HAL_USE_RTC
-const char *dow[] = { "Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat" };
-const char *mon[] = { "Non", "Jan", "Feb", "Mar", "Apr", "May", "Jun",
+static const char *dow[] = { "Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat" };
+static const char *mon[] = { "Jan", "Feb", "Mar", "Apr", "May", "Jun",
                              "Jul", "Aug", "Sep", "Oct", "Nov", "Dec", };
 static const char *ampm[] = { "am", "pm" };
 
-static void print_time(BaseSequentialStream *chp, int usage) {
-  RTCDateTime ts;
-  uint32_t hour, minute, second, millisecond;
-  const char *ap = ampm[0];
+/* Reads exactly digits decimal digits from *sp, advancing it.*/
+static int parse_digits(const char **sp, int digits, int *val) {
+  const char *s = *sp;
+  int v = 0;
 
-  chThdSleepMilliseconds(100);
-  rtcGetTime(&RTCD1, &ts);
+  while (digits--) {
+    if (*s < '0' || *s > '9')
+      return 0;
+    v = v * 10 + (*s++ - '0');
+  }
 
-  millisecond = ts.millisecond;
-  
-  second = millisecond / 1000;
-  millisecond -= second * 1000;
+  *val = v;
+  *sp = s;
+  return 1;
+}
 
-  minute = second / 60;
-  second -= minute * 60;
+/*
+ * Parses either "@SECONDS" since 1970, or a UTC time in the ISO-8601
+ * form YYYY-MM-DDTHH:MM:SS with an optional trailing Z.
+ */
+static int parse_time(const char *s, time_t *t) {
+  struct tm tm;
+  int year, month, day, hour, minute, second;
+
+  if (s[0] == '@') {
+    unsigned long secs;
+    char *end;
+
+    if (s[1] < '0' || s[1] > '9')
+      return 0;
+    secs = strtoul(s + 1, &end, 10);
+    if (*end || (time_t)secs < 0)
+      return 0;
+    *t = secs;
+    return 1;
+  }
 
-  hour = minute / 60;
-  minute -= hour * 60;
+  if (!parse_digits(&s, 4, &year)   || *s++ != '-' ||
+      !parse_digits(&s, 2, &month)  || *s++ != '-' ||
+      !parse_digits(&s, 2, &day)    || *s++ != 'T' ||
+      !parse_digits(&s, 2, &hour)   || *s++ != ':' ||
+      !parse_digits(&s, 2, &minute) || *s++ != ':' ||
+      !parse_digits(&s, 2, &second))
+    return 0;
+  if (*s == 'Z')
+    s++;
+  if (*s)
+    return 0;
+
+  if (year < 1970 || month < 1 || month > 12 || day < 1 ||
+      hour > 23 || minute > 59 || second > 59)
+    return 0;
+
+  memset(&tm, 0, sizeof(tm));
+  tm.tm_year = year - 1900;
+  tm.tm_mon = month - 1;
+  tm.tm_mday = day;
+  tm.tm_hour = hour;
+  tm.tm_min = minute;
+  tm.tm_sec = second;
+  *t = mktime(&tm);
+
+  /* mktime() normalises days past the end of the month, reject those */
+  if (*t == (time_t)-1 || tm.tm_mday != day)
+    return 0;
+  return 1;
+}
+
+static void print_time(BaseSequentialStream *chp) {
+  struct tm tm;
+  time_t t;
+  uint32_t sec, msec;
+  int hour;
 
+  /* One read of the counter, rather than one per field */
+  rtcSTM32GetSecMsec(&RTCD1, &sec, &msec);
+  t = sec;
+  gmtime_r(&t, &tm);
+
+  hour = tm.tm_hour % 12;
   if (hour == 0)
-    hour += 12;
-  else if (hour >= 12) {
-    ap = ampm[1];
-    if (hour > 12)
-      hour -= 12;
-  }
+    hour = 12;
 
-  chprintf(chp, "%s %s %d  %d:%02d:%02d:%04d %s  UTC  %d\r\n",
-      dow[ts.dayofweek - 1], mon[ts.month], ts.day,
-      hour, minute, second, millisecond, ap,
-      ts.year + 1980);
-
-  if (usage) {
-    chprintf(chp, "Usage:\r\n");
-    chprintf(chp, "    date day [d]    Set day-of-month to [d]\r\n");
-    chprintf(chp, "    date month [m]  Set month to [m]\r\n");
-    chprintf(chp, "    date ms [m]     Set milliseconds-since-midnight to [m]\r\n");
-    chprintf(chp, "    date year [y]   Set the year to [y]\r\n");
-  }
+  chprintf(chp, "%s %s %d  %d:%02d:%02d.%03lu %s  UTC  %d\r\n",
+      dow[tm.tm_wday], mon[tm.tm_mon], tm.tm_mday,
+      hour, tm.tm_min, tm.tm_sec, msec, ampm[tm.tm_hour >= 12],
+      tm.tm_year + 1900);
+  chprintf(chp, "Seconds since 1970: %lu\r\n", (unsigned long)sec);
+}
+
+static void print_usage(BaseSequentialStream *chp) {
+  chprintf(chp, "Usage:\r\n");
+  chprintf(chp, "    date set YYYY-MM-DDTHH:MM:SS[Z]  Set the UTC date and time\r\n");
+  chprintf(chp, "    date set @SECONDS               Set seconds since 1970\r\n");
 }
 #endif /* HAL_USE_RTC */
 
 void cmd_date(BaseSequentialStream *chp, int argc, char *argv[]) {
 #if HAL_USE_RTC
-  int usage = 1;
-
-  if (argc >= 1 && !strcasecmp(argv[0], "day")) {
-    RTCDateTime ts;
-    rtcGetTime(&RTCD1, &ts);
-    int day;
-
-    day = strtoul(argv[1], NULL, 0);
-    chprintf(chp, "Setting day-of-month: %d\r\n", day);
-    ts.day = day;
-    rtcSetTime(&RTCD1, &ts);
-    usage = 0;
-  }
+  time_t t;
 
-  else if (argc >= 1 && !strcasecmp(argv[0], "month")) {
-    RTCDateTime ts;
-    rtcGetTime(&RTCD1, &ts);
-    int month;
-
-    month = strtoul(argv[1], NULL, 0);
-    if (!month) {
-      size_t i;
-      for (i = 0; (!month) && (i < ARRAY_SIZE(mon)); i++)
-        if (!strcasecmp(argv[1], mon[i]))
-          month = i;
-    }
-
-    if (month) {
-      chprintf(chp, "Setting month: %s\r\n", mon[month]);
-      ts.month = month;
-      rtcSetTime(&RTCD1, &ts);
-      usage = 0;
-    }
-    else {
-      chprintf(chp, "Invalid month: %s\r\n", argv[1]);
-      return;
-    }
+  if (argc == 0) {
+    print_time(chp);
+    print_usage(chp);
+    return;
   }
 
-  else if (argc >= 1 && !strcasecmp(argv[0], "ms")) {
-    RTCDateTime ts;
-    rtcGetTime(&RTCD1, &ts);
-    int ms;
-
-    ms = strtoul(argv[1], NULL, 0);
-
-    chprintf(chp, "Setting milliseconds-since-midnight: %d\r\n", ms);
-    ts.millisecond = ms;
-    rtcSetTime(&RTCD1, &ts);
-    usage = 0;
+  if (argc != 2 || strcasecmp(argv[0], "set")) {
+    print_usage(chp);
+    shellSetError();
+    return;
   }
 
-  else if (argc >= 1 && !strcasecmp(argv[0], "year")) {
-    RTCDateTime ts;
-    rtcGetTime(&RTCD1, &ts);
-    int year;
-
-    year = strtoul(argv[1], NULL, 0);
-
-    chprintf(chp, "Party like it's %d\r\n", year);
-    ts.year = year - 1980;
-    rtcSetTime(&RTCD1, &ts);
-    usage = 0;
+  if (!parse_time(argv[1], &t)) {
+    chprintf(chp, "Invalid time: %s\r\n", argv[1]);
+    shellSetError();
+    return;
   }
 
-  print_time(chp, usage);
+  /* The whole timestamp goes to the RTC counter in a single write */
+  rtcSTM32SetSec(&RTCD1, t);
+  print_time(chp);
 #else
   (void)argc;
   (void)argv;
   chprintf(chp, "RTC not enabled\r\n");
+  shellSetError();
 #endif /* HAL_USE_RTC */
-  return;
 }
@@ -17,6 +17,7 @@
 #include "ch.h"
 #include "hal.h"
 #include "chprintf.h"
+#include "shell.h"
 
 #include "bionic.h"
 #include "board-type.h"
@@ -33,6 +34,7 @@ void cmd_gg(BaseSequentialStream *chp, int argc, char *argv[]) {
 
   if (boardType() != senoko_full) {
     chprintf(chp, "Gas gauge not present on this board.\r\n");
+    shellSetError();
     return;
   }
 
@@ -47,11 +49,14 @@ void cmd_gg(BaseSequentialStream *chp, int argc, char *argv[]) {
         if ( ! (ret = ggSetDsgFET(0)))
           chprintf(chp, "Discharge FET allowed to turn off\r\n");
       }
-      if (ret < 0)
+      if (ret < 0) {
         chprintf(chp, "Unable to modify  DSG fet: %d\r\n", ret);
+        shellSetError();
+      }
     }
     else {
       chprintf(chp, "Usage: gg dsg +/-\r\n");
+      shellSetError();
       return;
     }
   }
@@ -65,11 +70,14 @@ void cmd_gg(BaseSequentialStream *chp, int argc, char *argv[]) {
         if ( ! (ret = ggSetChgFET(0)))
           chprintf(chp, "Charge FET allowed to turn off\r\n");
       }
-      if (ret < 0)
+      if (ret < 0) {
         chprintf(chp, "Unable to modify  DSG fet: %d\r\n", ret);
+        shellSetError();
+      }
     }
     else {
       chprintf(chp, "Usage: gg chg +/-\r\n");
+      shellSetError();
       return;
     }
   }
@@ -90,11 +98,13 @@ void cmd_gg(BaseSequentialStream *chp, int argc, char *argv[]) {
       }
       else {
         chprintf(chp, "Unrecognized temp source \"%s\".\r\n", argv[1]);
+        shellSetError();
         return;
       }
 
       if (ret) {
         chprintf(chp, "Unable to set temp source: 0x%x\r\n", ret);
+        shellSetError();
         return;
       }
 
@@ -142,8 +152,10 @@ void cmd_gg(BaseSequentialStream *chp, int argc, char *argv[]) {
       chprintf(chp, "Gas gauge deadband: +/- %d mA\r\n", db);
       return;
     }
-    if (ggSetDeadband(strtoul(argv[1], NULL, 0)))
+    if (ggSetDeadband(strtoul(argv[1], NULL, 0))) {
       chprintf(chp, "Error\r\n");
+      shellSetError();
+    }
     else
       chprintf(chp, "Ok\r\n");
   }
@@ -159,8 +171,10 @@ void cmd_gg(BaseSequentialStream *chp, int argc, char *argv[]) {
     chprintf(chp, "Setting fastcharge curent... ");
 
     ret = ggSetFastChargeCurrent(current);
-    if (ret < 0)
+    if (ret < 0) {
       chprintf(chp, "Unable to set fastcharge current: 0x%x\r\n", ret);
+      shellSetError();
+    }
     else
       chprintf(chp, "Set fastcharge current to %d mA\r\n", current);
   }
@@ -176,8 +190,10 @@ void cmd_gg(BaseSequentialStream *chp, int argc, char *argv[]) {
     chprintf(chp, "Setting cycle count... ");
 
     ret = ggSetCycleCount(count);
-    if (ret < 0)
+    if (ret < 0) {
       chprintf(chp, "Unable to set cycle count: 0x%x\r\n", ret);
+      shellSetError();
+    }
     else
       chprintf(chp, "Set cycle count to %u\r\n", count);
   }
@@ -186,6 +202,7 @@ void cmd_gg(BaseSequentialStream *chp, int argc, char *argv[]) {
     int cells;
     if (argc != 3) {
       chprintf(chp, "Usage: gg capacity [cells] [capacity in mAh]\r\n");
+      shellSetError();
       return;
     }
     cells = strtoul(argv[1], NULL, 0);
@@ -193,8 +210,10 @@ void cmd_gg(BaseSequentialStream *chp, int argc, char *argv[]) {
 
     chprintf(chp, "Setting capacity... ");
     ret = ggSetCapacity(cells, capacity);
-    if (ret < 0)
+    if (ret < 0) {
       chprintf(chp, "Unable to set capacity: 0x%x\r\n", ret);
+      shellSetError();
+    }
     else
       chprintf(chp, "Set capacity of %d cells to %d mAh\r\n",
           cells, capacity);
@@ -202,19 +221,23 @@ void cmd_gg(BaseSequentialStream *chp, int argc, char *argv[]) {
   else if (is_command(argc, argv, "cells")) {
     if (argc == 1) {
       chprintf(chp, "Usage: gg cells [2|3|4]\r\n");
+      shellSetError();
     }
     else {
       if (argv[1][0] >= '2' && argv[1][0] <= '4') {
         int cellCount = argv[1][0]-'0';
         ret = ggSetCellCount(cellCount);
-        if (ret < 0)
+        if (ret < 0) {
           chprintf(chp, "Unable to set %d cells: 0x%x\r\n", cellCount, ret);
+          shellSetError();
+        }
         else
           chprintf(chp, "Set %d-cell mode\r\n",cellCount);
       }
       else {
         chprintf(chp, "Unknown cell count: %c\r\n",
             argv[1][0]);
+        shellSetError();
       }
     }
   }
@@ -242,39 +265,47 @@ void cmd_gg(BaseSequentialStream *chp, int argc, char *argv[]) {
 
     if (!handled) {
       chprintf(chp, "Usage: gg rm [0|1]\r\n");
+      shellSetError();
     }
   }
   else if (is_command(argc, argv, "it")) {
     chprintf(chp, "Starting ImpedenceTrackTM algorithm... ");
     ret = ggStartImpedenceTrackTM();
-    if (ret)
+    if (ret) {
       chprintf(chp, "Error: 0x%08x\r\n", ret);
+      shellSetError();
+    }
     else
       chprintf(chp, "Ok\r\n");
   }
   else if (is_command(argc, argv, "pfreset")) {
     chprintf(chp, "Resetting permanent failure flags...");
     ret = ggPermanentFailureReset();
-    if (ret != MSG_OK)
+    if (ret != MSG_OK) {
       chprintf(chp, " Error: %x\r\n", ret);
+      shellSetError();
+    }
     else
       chprintf(chp, " ok.\r\n");
   }
   else if (is_command(argc, argv, "reboot")) {
     chprintf(chp, "Rebooting the gas gauge chip...");
     ret = ggReboot();
-    if (ret != MSG_OK)
+    if (ret != MSG_OK) {
       chprintf(chp, " Error: %x\r\n", ret);
+      shellSetError();
+    }
     else
       chprintf(chp, " ok.\r\n");
   }
   else if (is_command(argc, argv, "cal")) {
     if (argc != 4) {
-      chprintf(chp, "Usage: gg cal [voltage] [current] [temperature]\r\n",
+      chprintf(chp, "Usage: gg cal [voltage] [current] [temperature]\r\n"
                     "    voltage - Millivolts of something, not sure what\r\n"
                     "    current - Milliamps (negative) of something, not sure what\r\n"
                     "temperature - Temperature in degrees C\r\n"
           );
+      shellSetError();
     }
     else {
       int16_t voltage;
@@ -316,6 +347,7 @@ void cmd_gg(BaseSequentialStream *chp, int argc, char *argv[]) {
       "gg it            Start a runthrough of the ImpedenceTrack algorithm\r\n"
       "gg rm [0|1]      Set or print whether battery is removable\r\n"
       );
+    shellSetError();
     return;
   }
 
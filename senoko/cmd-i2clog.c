@@ -69,12 +69,12 @@ void cmd_i2clog(BaseSequentialStream *chp, int argc, char *argv[]) {
   (void)argv;
   uint32_t idx;
 
-  chprintf(chp, "I2C log head: %d/%d\r\n", i2clog.head, I2C_LOG_ENTRIES);
+  chprintf(chp, "I2C log head: %lu/%d\r\n", i2clog.head, I2C_LOG_ENTRIES);
 
   for (idx = 0; idx < I2C_LOG_ENTRIES; idx++) {
     if (!i2clog.entries[idx].type)
       continue;
-    chprintf(chp, "%6s %03d %5s %d\r\n", (idx == i2clog.head) ? " =>" : "",
+    chprintf(chp, "%6s %03lu %5s %d\r\n", (idx == i2clog.head) ? " =>" : "",
                   idx,
 		  i2ctype(i2clog.entries[idx].type),
 		  i2clog.entries[idx].size);
@@ -17,19 +17,98 @@
 #include "ch.h"
 #include "shell.h"
 #include "chprintf.h"
+
+#include "bionic.h"
 #include "senoko.h"
 
-void cmd_mem(BaseSequentialStream *chp, int argc, char *argv[])
+#if CH_CFG_HEAP_STATS
+/*
+ * Only walks the free blocks when asked to, the heap stays locked for the
+ * whole walk.
+ */
+static void print_stats(BaseSequentialStream *chp, bool walk)
+{
+  heap_stats_t st;
+  unsigned i, n;
+
+  if (walk)
+    chHeapGetFreeStats(NULL, &st);
+  else
+    chHeapGetStats(NULL, &st);
+
+  chprintf(chp, "core free memory : %u bytes\r\n", chCoreStatus());
+  if (walk) {
+    for (i = 0, n = 0; i < CH_HEAP_FRAG_BINS; i++)
+      n += st.hs_frags[i];
+    chprintf(chp, "heap fragments   : %u\r\n", n);
+    chprintf(chp, "heap free total  : %u bytes\r\n", st.hs_free);
+  }
+  chprintf(chp, "heap largest free: %u bytes\r\n", st.hs_largest);
+  chprintf(chp, "heap used        : %u bytes (peak %u)\r\n",
+           st.hs_used, st.hs_peak);
+  chprintf(chp, "heap allocations : %lu (%lu freed, %lu failed)\r\n",
+           st.hs_allocs, st.hs_frees, st.hs_fails);
+
+  if (walk) {
+    chprintf(chp, "free blocks      :");
+    for (i = 0; i < CH_HEAP_FRAG_BINS - 1; i++)
+      chprintf(chp, " <%u:%u", 32U << i, st.hs_frags[i]);
+    chprintf(chp, " more:%u\r\n", st.hs_frags[i]);
+  }
+
+#if CH_CFG_HEAP_TAGS > 0
+  for (i = 0; i < CH_CFG_HEAP_TAGS; i++) {
+    size_t size = chHeapGetTagUsage(NULL, i);
+
+    if (size)
+      chprintf(chp, "heap tag %u used : %u bytes\r\n", i, size);
+  }
+#endif
+}
+#else
+static void print_stats(BaseSequentialStream *chp, bool walk)
 {
   size_t n, size;
 
-  (void)argv;
-  if (argc > 0) {
-    chprintf(chp, "Usage: mem\r\n");
+  chprintf(chp, "core free memory : %u bytes\r\n", chCoreStatus());
+  if (walk) {
+    n = chHeapStatus(NULL, &size);
+    chprintf(chp, "heap fragments   : %u\r\n", n);
+    chprintf(chp, "heap free total  : %u bytes\r\n", size);
+  }
+}
+#endif
+
+#if CH_CFG_USE_SLABS
+static void print_slabs(BaseSequentialStream *chp)
+{
+  slab_cache_t *scp;
+  slab_stats_t st;
+
+  chprintf(chp, "idle slabs       : %u of %u bytes\r\n",
+           chSlabStatus(), CH_CFG_SLAB_SIZE);
+  for (scp = chSlabCacheNext(NULL); scp != NULL; scp = chSlabCacheNext(scp)) {
+    chSlabCacheGetStats(scp, &st);
+    chprintf(chp, "slab %-12s: %u/%u objects of %u bytes in %u slabs "
+             "(peak %u, %lu failed)\r\n",
+             scp->sc_name, st.ss_used, st.ss_capacity, st.ss_object_size,
+             st.ss_slabs, st.ss_peak, st.ss_fails);
+  }
+}
+#endif
+
+void cmd_mem(BaseSequentialStream *chp, int argc, char *argv[])
+{
+  bool walk = argc == 1 && !strcasecmp(argv[0], "free");
+
+  if (argc > 0 && !walk) {
+    chprintf(chp, "Usage: mem [free]\r\n");
+    chprintf(chp, "    free    Also walk the free blocks of the heap\r\n");
+    shellSetError();
     return;
   }
-  n = chHeapStatus(NULL, &size);
-  chprintf(chp, "core free memory : %u bytes\r\n", chCoreStatus());
-  chprintf(chp, "heap fragments   : %u\r\n", n);
-  chprintf(chp, "heap free total  : %u bytes\r\n", size);
+  print_stats(chp, walk);
+#if CH_CFG_USE_SLABS
+  print_slabs(chp);
+#endif
 }
@@ -22,23 +22,72 @@
 #include "power.h"
 #include "shell.h"
 
+/* ST2MS() rounds up from n - 1, which wraps for a zero count.*/
+static uint32_t ticks_to_ms(systime_t ticks) {
+  return ticks ? ST2MS(ticks) : 0;
+}
+
+static void print_power_stats(BaseSequentialStream *chp) {
+  struct power_state_stats ss;
+  struct power_transition_stats ts;
+  struct power_shutdown_stats sd;
+  enum power_state state, from, to;
+  systime_t now = chVTGetSystemTime();
+  int i;
+
+  chprintf(chp, "State          Entries  Last (ms)  Max (ms)\r\n");
+  for (state = 0; state < __power_state_last; state++) {
+    powerStateStats(state, &ss);
+    chprintf(chp, "%-12s %9lu %10lu %9lu%s\r\n",
+        powerStateName(state), ss.entries,
+        ticks_to_ms(ss.last_ticks), ticks_to_ms(ss.max_ticks),
+        (state == powerState()) ? "  <=" : "");
+  }
+
+  chprintf(chp, "\r\nTransition                  Count  Last (ms ago)\r\n");
+  for (i = 0; !powerTransitionStats(i, &from, &to, &ts); i++) {
+    if (!ts.count)
+      continue;
+    chprintf(chp, "%-12s -> %-12s %5lu %14lu\r\n",
+        powerStateName(from), powerStateName(to), ts.count,
+        ticks_to_ms((systime_t)(now - ts.last)));
+  }
+
+  powerShutdownStats(&sd);
+  chprintf(chp, "\r\nLow battery shutdowns: %lu (%lu not acknowledged)\r\n",
+      sd.requests, sd.timeouts);
+  if (sd.requests)
+    chprintf(chp, "Last shutdown took:    %lu ms\r\n",
+        ticks_to_ms(sd.last_ticks));
+}
+
 void cmd_power(BaseSequentialStream *chp, int argc, char *argv[])
 {
   if ((argc > 0) && !strcasecmp(argv[0], "on")) {
     chprintf(chp, "Powering on... ");
     powerOn();
-    chprintf(chp, "Ok\r\n");
+    chprintf(chp, "%s\r\n", powerIsOn() ? "Ok" : "Refused");
   }
   else if ((argc > 0) && !strcasecmp(argv[0], "off")) {
     chprintf(chp, "Powering off... ");
     powerOff();
     chprintf(chp, "Ok\r\n");
   }
+  else if ((argc > 0) && !strcasecmp(argv[0], "stats")) {
+    print_power_stats(chp);
+  }
+  else if ((argc > 0) && !strcasecmp(argv[0], "grace")) {
+    if (argc > 1)
+      powerSetShutdownGrace(strtoul(argv[1], NULL, 0));
+    chprintf(chp, "Low battery shutdown grace period: %u seconds\r\n",
+        powerShutdownGrace());
+  }
   else if ((argc > 0)) {
-    chprintf(chp, "Usage: power [on|off]\r\n");
+    chprintf(chp, "Usage: power [on|off|stats|grace [seconds]]\r\n");
   }
   else {
-    chprintf(chp, "Power status: %s\r\n", powerIsOn() ? "on" : "off");
+    chprintf(chp, "Power status: %s (%s)\r\n", powerIsOn() ? "on" : "off",
+                  powerStateName(powerState()));
   }
   chprintf(chp, "\r\n");
 }
@@ -50,6 +50,11 @@ static const char *mfgr_states[] = {
   "battery removed",
 };
 
+/*
+ * The value is printed with a format passed in by the caller, so the
+ * compiler can only check that the format itself is well formed.
+ */
+CHPRINTF_FORMAT(4, 0)
 static void print_str(BaseSequentialStream *chp,
                           const char *item,
                           void *func,
@@ -70,6 +75,7 @@ static void print_str(BaseSequentialStream *chp,
   return;
 }
 
+CHPRINTF_FORMAT(4, 0)
 static void print_byte(BaseSequentialStream *chp,
                        const char *item,
                        int (*func)(uint8_t *),
@@ -89,6 +95,7 @@ static void print_byte(BaseSequentialStream *chp,
   return;
 }
 
+CHPRINTF_FORMAT(4, 0)
 static void print_word(BaseSequentialStream *chp,
                        const char *item,
                        int (*func)(uint16_t *),
@@ -108,6 +115,7 @@ static void print_word(BaseSequentialStream *chp,
   return;
 }
 
+CHPRINTF_FORMAT(4, 0)
 static void print_signed_word(BaseSequentialStream *chp,
                               const char *item,
                               int (*func)(int16_t *),
@@ -179,10 +187,10 @@ void cmd_stats(BaseSequentialStream *chp, int argc, char *argv[]) {
       print_word(chp, "Fuse flag:", ggFuseFlag, "0x%x");
       print_word(chp, "PF flags:", ggPermanentFailureFlags, "0x%x");
       print_word(chp, "PF flags 2:", ggPermanentFailureFlags2, "0x%x");
-      print_word(chp, "PF voltage:", ggPermanentFailureFlags, "%d mV");
+      print_word(chp, "PF voltage:", ggPermanentFailureVoltage, "%d mV");
       print_signed_word(chp, "PF current:", ggPermanentFailureCurrent, "%d mA");
       print_signed_word(chp, "PF temperature:", ggPermanentFailureTemperature, "%d mC");
-      print_word(chp, "PF remaining capacity:", ggPermanentFailureRemainingCapacity, "%d mA");
+      print_word(chp, "PF remaining capacity:", ggPermanentFailureRemainingCapacity, "%d mAh");
       print_word(chp, "PF battery status:", ggPermanentFailureBatteryStatus, "0x%x");
       print_word(chp, "PF charge status:", ggPermanentFailureChargeStatus, "0x%x");
       print_word(chp, "PF safety status:", ggPermanentFailureSafetyStatus, "0x%x");
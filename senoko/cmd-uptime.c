@@ -15,17 +15,40 @@
 */
 
 #include "ch.h"
+#include "hal.h"
 #include "senoko.h"
+#include "senoko-idle.h"
 #include "chprintf.h"
 
+/* Realtime counter cycles per millisecond */
+#define CYCLES_PER_MS (STM32_HCLK / 1000)
+
 void cmd_uptime(BaseSequentialStream *chp, int argc, char *argv[]) {
+  static struct idle_stats last_idle;
+  static uint32_t last_uptime;
+  struct idle_stats idle;
+  uint32_t span_msec, idle_msec;
 
   (void)argv;
   if (argc > 0) {
     chprintf(chp, "Usage: uptime\r\n");
     return;
   }
-  uint32_t uptime_msec = senoko_uptime;
+  uint32_t uptime_msec = senokoUptime();
+  senokoIdleStats(&idle);
+
+  /* Report wakeups and idle residency since the previous invocation.*/
+  span_msec = uptime_msec - last_uptime;
+  idle_msec = (idle.idle_cycles - last_idle.idle_cycles) / CYCLES_PER_MS;
+  if (span_msec)
+    chprintf(chp, "%lu wakeups/s, %lu.%lu%% idle over the last %lu ms\r\n",
+        (uint32_t)(((idle.wakeups - last_idle.wakeups) * 1000ULL) / span_msec),
+        (uint32_t)((idle_msec * 100ULL) / span_msec),
+        (uint32_t)(((idle_msec * 1000ULL) / span_msec) % 10),
+        span_msec);
+  last_idle = idle;
+  last_uptime = uptime_msec;
+
   uint32_t uptime_sec = uptime_msec / 1000;
   uptime_msec -= (uptime_sec * 1000);
   chprintf(chp, "%lu.%03lu seconds\r\n", uptime_sec, uptime_msec);
@@ -0,0 +1,45 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006-2013 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "ch.h"
+#include "chprintf.h"
+
+#include "senoko.h"
+#include "senoko-wdt.h"
+
+void cmd_wdt(BaseSequentialStream *chp, int argc, char *argv[]) {
+  struct wdt_client client;
+  uint32_t now;
+  int id;
+
+  (void)argv;
+  if (argc > 0) {
+    chprintf(chp, "Usage: wdt\r\n");
+    return;
+  }
+
+  now = senokoUptime();
+  chprintf(chp, "Thread              Timeout (ms)  Last check-in (ms ago)  State\r\n");
+  for (id = 0; !senokoWatchdogClient(id, &client); id++)
+    chprintf(chp, "%-19s %12lu %23lu  %s\r\n",
+        client.name, client.timeout_ms, now - client.last_checkin,
+        client.paused ? "paused" :
+        (client.remaining_ms ? "live" : "HUNG"));
+
+  chprintf(chp, "Mainboard watchdog: %s, %d seconds to reset\r\n",
+      senokoWatchdogEnabled() ? "enabled" : "disabled",
+      senokoWatchdogTimeToReset());
+}
@@ -0,0 +1,95 @@
+/*
+ * bionic-bench - times the firmware's memcpy, memset and strlen on the
+ * host, against the versions they replaced.  The numbers only compare
+ * the algorithms; "bench mem" on the board gives the Cortex-M3 cycles.
+ *
+ * bionic.c is built in with its routines renamed, so that they don't
+ * take the place of the C library's.  x86 loads unaligned words in
+ * hardware like the Cortex-M3 does, so the same copy paths are taken.
+ */
+#define __BIONIC_H__
+#define ULONG_MAX		4294967295UL
+#define __ARM_FEATURE_UNALIGNED	1
+
+#define memcpy			bionic_memcpy
+#define memset			bionic_memset
+#define strlen			bionic_strlen
+#define strnlen			bionic_strnlen
+#define strspn			bionic_strspn
+#define strpbrk			bionic_strpbrk
+#define strtok_r		bionic_strtok_r
+#define strcasecmp		bionic_strcasecmp
+#define strncasecmp		bionic_strncasecmp
+#define strtoul			bionic_strtoul
+#define strtol			bionic_strtol
+#define toupper			bionic_toupper
+#define sprintf			bionic_sprintf
+
+#include "../bionic.c"
+
+#undef memcpy
+#undef memset
+#undef strlen
+#undef strnlen
+#undef strspn
+#undef strpbrk
+#undef strtok_r
+#undef strcasecmp
+#undef strncasecmp
+#undef strtoul
+#undef strtol
+#undef toupper
+#undef sprintf
+#undef ULONG_MAX
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "../membench.h"
+
+/* Calls timed per measurement */
+#define ITERATIONS	20000
+
+/* minutesToTime() in bionic.c formats with the firmware's sprintf */
+int bionic_sprintf(char *buf, const char *fmt, ...)
+{
+	va_list ap;
+	int ret;
+
+	va_start(ap, fmt);
+	ret = vsprintf(buf, fmt, ap);
+	va_end(ap);
+	return ret;
+}
+
+static uint32_t nsecs(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint32_t)(ts.tv_sec * 1000000000ULL + ts.tv_nsec);
+}
+
+static const struct membench_impl bionic_impl = {
+	bionic_memcpy,
+	bionic_memset,
+	bionic_strlen,
+};
+
+int main(void)
+{
+	static long buf[MEMBENCH_BUFFER_SIZE / sizeof(long)];
+	struct membench_result r;
+	int test;
+
+	printf("Routine   Size  Before   After  (ns/call)\n");
+	for (test = 0; membench_run(test, &bionic_impl, (uint8_t *)buf,
+				    ITERATIONS, nsecs, &r); test++)
+		printf("%-8s %5zu %7.1f %7.1f  %.2fx\n", r.name, r.size,
+		       (double)r.baseline / ITERATIONS,
+		       (double)r.current / ITERATIONS,
+		       r.current ? (double)r.baseline / r.current : 0.0);
+	return 0;
+}
@@ -0,0 +1,450 @@
+/*
+ * libsenoko - Linux userspace access to the Senoko I2C register map.
+ */
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/i2c.h>
+#include <linux/i2c-dev.h>
+
+#include "libsenoko.h"
+
+struct senoko {
+	const struct senoko_bus_ops *ops;
+	void *priv;
+	uint8_t image[SENOKO_REG_COUNT];
+};
+
+/* -- i2c-dev transport -- */
+
+struct i2cdev {
+	int fd;
+	int addr;
+};
+
+static int i2cdev_transfer(struct i2cdev *bus, struct i2c_msg *msgs, int n)
+{
+	struct i2c_rdwr_ioctl_data session;
+
+	session.msgs = msgs;
+	session.nmsgs = n;
+	if (ioctl(bus->fd, I2C_RDWR, &session) < 0)
+		return -errno;
+	return 0;
+}
+
+/* Register address write and data read, joined by a repeated start */
+static int i2cdev_read(void *priv, uint8_t reg, void *buf, size_t len)
+{
+	struct i2cdev *bus = priv;
+	struct i2c_msg msgs[2];
+
+	msgs[0].addr = bus->addr;
+	msgs[0].flags = 0;
+	msgs[0].len = 1;
+	msgs[0].buf = &reg;
+
+	msgs[1].addr = bus->addr;
+	msgs[1].flags = I2C_M_RD;
+	msgs[1].len = len;
+	msgs[1].buf = buf;
+
+	return i2cdev_transfer(bus, msgs, 2);
+}
+
+static int i2cdev_write(void *priv, uint8_t reg, const void *buf, size_t len)
+{
+	struct i2cdev *bus = priv;
+	struct i2c_msg msg;
+	uint8_t data[1 + SENOKO_REG_COUNT];
+
+	if (len > SENOKO_REG_COUNT)
+		return -EINVAL;
+
+	data[0] = reg;
+	memcpy(&data[1], buf, len);
+
+	msg.addr = bus->addr;
+	msg.flags = 0;
+	msg.len = 1 + len;
+	msg.buf = data;
+
+	return i2cdev_transfer(bus, &msg, 1);
+}
+
+static void i2cdev_close(void *priv)
+{
+	struct i2cdev *bus = priv;
+
+	close(bus->fd);
+	free(bus);
+}
+
+static const struct senoko_bus_ops i2cdev_ops = {
+	.read = i2cdev_read,
+	.write = i2cdev_write,
+	.close = i2cdev_close,
+};
+
+struct senoko *senoko_open(const char *path, int addr)
+{
+	struct senoko *dev;
+	struct i2cdev *bus;
+
+	bus = calloc(1, sizeof(*bus));
+	if (!bus)
+		return NULL;
+
+	bus->fd = open(path, O_RDWR);
+	if (bus->fd == -1) {
+		free(bus);
+		return NULL;
+	}
+	bus->addr = addr;
+
+	dev = senoko_open_ops(&i2cdev_ops, bus);
+	if (!dev)
+		i2cdev_close(bus);
+	return dev;
+}
+
+/* -- Simulated device, backed by a register image file -- */
+
+struct sim {
+	int fd;
+	uint8_t rtc_seconds[4];
+};
+
+static const struct i2c_registers sim_defaults = {
+	.signature = 'S',
+	.version_major = 2,
+	.version_minor = 3,
+	.features = REG_FEATURES_BATTERY,
+	.shutdown_grace = 10,
+	.power = REG_POWER_KEY_READ | REG_POWER_AC_STATUS_MASK,
+};
+
+static int sim_load(struct sim *sim, uint8_t *regs)
+{
+	ssize_t ret = pread(sim->fd, regs, SENOKO_REG_COUNT, 0);
+
+	if (ret < 0)
+		return -errno;
+	if (ret != (ssize_t)SENOKO_REG_COUNT)
+		return -EIO;
+	return 0;
+}
+
+static int sim_store(struct sim *sim, const uint8_t *regs)
+{
+	ssize_t ret = pwrite(sim->fd, regs, SENOKO_REG_COUNT, 0);
+
+	if (ret < 0)
+		return -errno;
+	if (ret != (ssize_t)SENOKO_REG_COUNT)
+		return -EIO;
+	return 0;
+}
+
+/* The register address wraps around, as it does in the firmware */
+static int sim_read(void *priv, uint8_t reg, void *buf, size_t len)
+{
+	uint8_t regs[SENOKO_REG_COUNT];
+	uint8_t *out = buf;
+	size_t i;
+	int ret;
+
+	ret = sim_load(priv, regs);
+	if (ret)
+		return ret;
+	for (i = 0; i < len; i++)
+		out[i] = regs[(reg + i) % SENOKO_REG_COUNT];
+	return 0;
+}
+
+/* Mirrors senokoSlaveDispatch(): only some registers take writes */
+static void sim_write_reg(struct sim *sim, uint8_t *regs, unsigned int reg,
+			  uint8_t val)
+{
+	if (reg >= REG_RTC_SECONDS && reg < REG_RTC_SECONDS + 4) {
+		/* Staged until the top byte arrives */
+		sim->rtc_seconds[reg - REG_RTC_SECONDS] = val;
+		if (reg == REG_RTC_SECONDS + 3)
+			memcpy(&regs[REG_RTC_SECONDS], sim->rtc_seconds, 4);
+		return;
+	}
+
+	switch (reg) {
+	case REG_POWER:
+		if ((val & REG_POWER_KEY_MASK) != REG_POWER_KEY_WRITE)
+			break;
+		regs[reg] &= ~(REG_POWER_WDT_MASK | REG_POWER_STATE_MASK);
+		regs[reg] |= val & REG_POWER_WDT_MASK;
+		if ((val & REG_POWER_STATE_MASK) == REG_POWER_STATE_OFF)
+			regs[reg] |= REG_POWER_STATE_OFF;
+		break;
+	case REG_IRQ_ENABLE:
+	case REG_IRQ_STATUS:
+	case REG_WATCHDOG_SECONDS:
+		regs[reg] = val;
+		break;
+	case REG_SHUTDOWN_GRACE:
+		regs[reg] = val > 60 ? 60 : val;
+		break;
+	case REG_UART:
+		regs[reg] = val & REG_UART_STATE_MASK;
+		break;
+	default:
+		if (reg == 0x10 || (reg >= 0x14 && reg < 0x1b))
+			regs[reg] = val;
+		break;
+	}
+}
+
+static int sim_write(void *priv, uint8_t reg, const void *buf, size_t len)
+{
+	uint8_t regs[SENOKO_REG_COUNT];
+	const uint8_t *in = buf;
+	size_t i;
+	int ret;
+
+	ret = sim_load(priv, regs);
+	if (ret)
+		return ret;
+	for (i = 0; i < len; i++)
+		sim_write_reg(priv, regs, (reg + i) % SENOKO_REG_COUNT, in[i]);
+	return sim_store(priv, regs);
+}
+
+static void sim_close(void *priv)
+{
+	struct sim *sim = priv;
+
+	close(sim->fd);
+	free(sim);
+}
+
+static const struct senoko_bus_ops sim_ops = {
+	.read = sim_read,
+	.write = sim_write,
+	.close = sim_close,
+};
+
+struct senoko *senoko_open_sim(const char *path)
+{
+	struct senoko *dev;
+	struct sim *sim;
+	off_t size;
+
+	sim = calloc(1, sizeof(*sim));
+	if (!sim)
+		return NULL;
+
+	sim->fd = open(path, O_RDWR | O_CREAT, 0644);
+	if (sim->fd == -1)
+		goto err;
+
+	size = lseek(sim->fd, 0, SEEK_END);
+	if (size == 0 &&
+	    sim_store(sim, (const uint8_t *)&sim_defaults) < 0)
+		goto err_close;
+	else if (size > 0 && size < (off_t)SENOKO_REG_COUNT) {
+		errno = EINVAL;
+		goto err_close;
+	}
+
+	dev = senoko_open_ops(&sim_ops, sim);
+	if (!dev)
+		goto err_close;
+	return dev;
+
+err_close:
+	close(sim->fd);
+err:
+	free(sim);
+	return NULL;
+}
+
+/* -- Common code -- */
+
+struct senoko *senoko_open_ops(const struct senoko_bus_ops *ops, void *priv)
+{
+	struct senoko *dev;
+
+	dev = calloc(1, sizeof(*dev));
+	if (!dev)
+		return NULL;
+	dev->ops = ops;
+	dev->priv = priv;
+	return dev;
+}
+
+void senoko_close(struct senoko *dev)
+{
+	if (!dev)
+		return;
+	if (dev->ops->close)
+		dev->ops->close(dev->priv);
+	free(dev);
+}
+
+int senoko_refresh(struct senoko *dev)
+{
+	return dev->ops->read(dev->priv, 0, dev->image, sizeof(dev->image));
+}
+
+int senoko_refresh_range(struct senoko *dev, uint8_t first, size_t count)
+{
+	uint8_t buf[SENOKO_REG_COUNT];
+	int ret;
+
+	if (first >= SENOKO_REG_COUNT || count > SENOKO_REG_COUNT - first)
+		return -EINVAL;
+
+	ret = dev->ops->read(dev->priv, first, buf, count);
+	if (ret)
+		return ret;
+	if (!memcmp(&dev->image[first], buf, count))
+		return 0;
+	memcpy(&dev->image[first], buf, count);
+	return 1;
+}
+
+const uint8_t *senoko_image(const struct senoko *dev)
+{
+	return dev->image;
+}
+
+static uint32_t get_le32(const uint8_t *p)
+{
+	return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+void senoko_decode(const uint8_t *image, struct senoko_state *state)
+{
+	const struct i2c_registers *regs = (const struct i2c_registers *)image;
+	uint8_t power = regs->power;
+
+	memset(state, 0, sizeof(*state));
+	state->signature = regs->signature;
+	state->version_major = regs->version_major;
+	state->version_minor = regs->version_minor;
+	state->has_battery = !!(regs->features & REG_FEATURES_BATTERY);
+	state->has_gpio = !!(regs->features & REG_FEATURES_GPIO);
+	state->uptime_ms = get_le32(regs->uptime);
+	state->irq_enable = regs->irq_enable;
+	state->irq_status = regs->irq_status;
+	state->shutdown_grace_s = regs->shutdown_grace;
+
+	switch (power & REG_POWER_STATE_MASK) {
+	case REG_POWER_STATE_ON:
+		state->power = SENOKO_POWER_ON;
+		break;
+	case REG_POWER_STATE_OFF:
+		state->power = SENOKO_POWER_OFF;
+		break;
+	case REG_POWER_STATE_REBOOT:
+		state->power = SENOKO_POWER_REBOOT;
+		break;
+	default:
+		state->power = SENOKO_POWER_UNKNOWN;
+		break;
+	}
+	state->wdt_enabled = !!(power & REG_POWER_WDT_STATE);
+	state->ac_present = !!(power & REG_POWER_AC_STATUS_MASK);
+	state->button_pressed = !!(power & REG_POWER_PB_STATUS_MASK);
+	state->shutdown_pending = !!(power & REG_POWER_SHUTDOWN_MASK);
+
+	state->gpio_dir = regs->gpio_dir_a | (regs->gpio_dir_b << 8);
+	state->gpio_val = regs->gpio_val_a | (regs->gpio_val_b << 8);
+	state->uart_enabled =
+		(regs->uart & REG_UART_STATE_MASK) == REG_UART_STATE_ON;
+	state->rtc_seconds = get_le32(regs->seconds);
+	state->alarm_seconds = get_le32(regs->alarm_seconds);
+	state->wdt_seconds = regs->wdt_seconds;
+}
+
+void senoko_state(const struct senoko *dev, struct senoko_state *state)
+{
+	senoko_decode(dev->image, state);
+}
+
+int senoko_write_reg(struct senoko *dev, uint8_t reg, uint8_t value)
+{
+	int ret;
+
+	if (reg >= SENOKO_REG_COUNT)
+		return -EINVAL;
+	ret = dev->ops->write(dev->priv, reg, &value, 1);
+	if (ret)
+		return ret;
+
+	/* Read back, as the device may refuse or adjust the value */
+	ret = senoko_refresh_range(dev, reg, 1);
+	return ret < 0 ? ret : 0;
+}
+
+int senoko_set_power(struct senoko *dev, enum senoko_power_state state,
+		     int wdt_enable)
+{
+	uint8_t val = REG_POWER_KEY_WRITE;
+
+	switch (state) {
+	case SENOKO_POWER_ON:
+		val |= REG_POWER_STATE_ON;
+		break;
+	case SENOKO_POWER_OFF:
+		val |= REG_POWER_STATE_OFF;
+		break;
+	case SENOKO_POWER_REBOOT:
+		val |= REG_POWER_STATE_REBOOT;
+		break;
+	default:
+		return -EINVAL;
+	}
+	if (wdt_enable)
+		val |= REG_POWER_WDT_ENABLE;
+
+	return senoko_write_reg(dev, REG_POWER, val);
+}
+
+int senoko_set_watchdog(struct senoko *dev, unsigned int seconds)
+{
+	if (seconds > 255)
+		return -ERANGE;
+	return senoko_write_reg(dev, REG_WATCHDOG_SECONDS, seconds);
+}
+
+int senoko_set_rtc(struct senoko *dev, uint32_t seconds)
+{
+	uint8_t buf[4];
+	int ret;
+
+	buf[0] = seconds;
+	buf[1] = seconds >> 8;
+	buf[2] = seconds >> 16;
+	buf[3] = seconds >> 24;
+	ret = dev->ops->write(dev->priv, REG_RTC_SECONDS, buf, sizeof(buf));
+	if (ret)
+		return ret;
+
+	ret = senoko_refresh_range(dev, REG_RTC_SECONDS, sizeof(buf));
+	return ret < 0 ? ret : 0;
+}
+
+const char *senoko_power_name(enum senoko_power_state state)
+{
+	switch (state) {
+	case SENOKO_POWER_ON:
+		return "on";
+	case SENOKO_POWER_OFF:
+		return "off";
+	case SENOKO_POWER_REBOOT:
+		return "rebooting";
+	default:
+		return "unknown";
+	}
+}
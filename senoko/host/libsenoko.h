@@ -0,0 +1,108 @@
+/*
+ * libsenoko - Linux userspace access to the Senoko I2C register map.
+ *
+ * The whole register image is fetched with a single combined I2C
+ * transaction and decoded from a local copy, so reading every field
+ * costs one bus transfer instead of one per field.  Errors are returned
+ * as negative errno values; nothing in here exits or prints.
+ */
+#ifndef __LIBSENOKO_H__
+#define __LIBSENOKO_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "senoko-slave.h"
+
+#define SENOKO_DEFAULT_BUS	"/dev/i2c-0"
+#define SENOKO_DEFAULT_ADDR	0x20
+#define SENOKO_REG_COUNT	sizeof(struct i2c_registers)
+
+enum senoko_power_state {
+	SENOKO_POWER_ON,
+	SENOKO_POWER_OFF,
+	SENOKO_POWER_REBOOT,
+	SENOKO_POWER_UNKNOWN,
+};
+
+/* Decoded view of a register image */
+struct senoko_state {
+	char signature;
+	uint8_t version_major;
+	uint8_t version_minor;
+	int has_battery;
+	int has_gpio;
+	uint32_t uptime_ms;
+	uint8_t irq_enable;
+	uint8_t irq_status;
+	unsigned int shutdown_grace_s;
+	enum senoko_power_state power;
+	int wdt_enabled;
+	int ac_present;
+	int button_pressed;
+	int shutdown_pending;
+	uint16_t gpio_dir;
+	uint16_t gpio_val;
+	int uart_enabled;
+	uint32_t rtc_seconds;
+	uint32_t alarm_seconds;
+	unsigned int wdt_seconds;
+};
+
+/*
+ * Transport underneath a handle.  read() and write() move len bytes
+ * starting at register reg, each as one bus transaction.
+ */
+struct senoko_bus_ops {
+	int (*read)(void *priv, uint8_t reg, void *buf, size_t len);
+	int (*write)(void *priv, uint8_t reg, const void *buf, size_t len);
+	void (*close)(void *priv);
+};
+
+struct senoko;
+
+/* Opens the device at addr on an i2c-dev node such as /dev/i2c-0 */
+struct senoko *senoko_open(const char *path, int addr);
+
+/*
+ * Opens a simulated device whose registers live in a file, as written
+ * by "senoko dump -r".  Reads and writes follow the firmware's rules
+ * for which registers are writeable, so tools can be exercised without
+ * hardware.  The file is created from a default image if missing.
+ */
+struct senoko *senoko_open_sim(const char *path);
+
+/* Wraps a caller provided transport */
+struct senoko *senoko_open_ops(const struct senoko_bus_ops *ops, void *priv);
+
+void senoko_close(struct senoko *dev);
+
+/* Refreshes the cached copy of every register in one transaction */
+int senoko_refresh(struct senoko *dev);
+
+/*
+ * Refreshes only registers [first, first + count) of the cached image.
+ * Returns 1 if any of them changed, 0 if not.
+ */
+int senoko_refresh_range(struct senoko *dev, uint8_t first, size_t count);
+
+/* The cached register image, SENOKO_REG_COUNT bytes */
+const uint8_t *senoko_image(const struct senoko *dev);
+
+/* Decodes a register image of at least SENOKO_REG_COUNT bytes */
+void senoko_decode(const uint8_t *image, struct senoko_state *state);
+
+/* Decodes the cached image */
+void senoko_state(const struct senoko *dev, struct senoko_state *state);
+
+int senoko_write_reg(struct senoko *dev, uint8_t reg, uint8_t value);
+int senoko_set_power(struct senoko *dev, enum senoko_power_state state,
+		     int wdt_enable);
+int senoko_set_watchdog(struct senoko *dev, unsigned int seconds);
+
+/* Sets the RTC to seconds since 1970, in one write of 0x20 - 0x23 */
+int senoko_set_rtc(struct senoko *dev, uint32_t seconds);
+
+const char *senoko_power_name(enum senoko_power_state state);
+
+#endif /* __LIBSENOKO_H__ */
@@ -0,0 +1,192 @@
+/*
+ * localtime-test - checks the firmware's calendar conversions against
+ * the C library of the host.
+ *
+ * Every day of five and a half thousand years either side of the epoch
+ * goes through gmtime_r() and back through mktime(), at a different time
+ * of day each, and so does every second of the days where an off by one
+ * would show.  mktime() is then fed random out of range fields, which it
+ * must carry the way timegm() does.  Last, every day the RTC can hold goes
+ * to an RTCDateTime and back.
+ */
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define gmtime_r		senoko_gmtime_r
+#define gmtime			senoko_gmtime
+#define localtime_r		senoko_localtime_r
+#define localtime		senoko_localtime
+#define mktime			senoko_mktime
+
+#include "../localtime.c"
+
+#undef gmtime_r
+#undef gmtime
+#undef localtime_r
+#undef localtime
+#undef mktime
+
+#define DAYS		2000000L	/* Days tested either side of 1970 */
+#define RTC_YEAR_BASE	1980		/* RTCDateTime year 0 */
+#define RANDOM_TESTS	1000000
+
+static unsigned long failures;
+
+static int tm_equal(const struct tm *a, const struct tm *b)
+{
+	return a->tm_year == b->tm_year && a->tm_mon == b->tm_mon &&
+	       a->tm_mday == b->tm_mday && a->tm_hour == b->tm_hour &&
+	       a->tm_min == b->tm_min && a->tm_sec == b->tm_sec &&
+	       a->tm_wday == b->tm_wday && a->tm_yday == b->tm_yday &&
+	       a->tm_isdst == b->tm_isdst;
+}
+
+static void print_tm(const char *name, const struct tm *tm)
+{
+	printf("  %-6s %d-%02d-%02d %02d:%02d:%02d wday %d yday %d\n", name,
+	       tm->tm_year + TM_YEAR_BASE, tm->tm_mon + 1, tm->tm_mday,
+	       tm->tm_hour, tm->tm_min, tm->tm_sec, tm->tm_wday, tm->tm_yday);
+}
+
+static void fail(const char *what, long long t, const struct tm *got,
+		 const struct tm *want)
+{
+	if (failures++ < 10) {
+		printf("%s of %lld differs\n", what, t);
+		print_tm("got", got);
+		print_tm("wanted", want);
+	}
+}
+
+/* Converts t both ways, comparing with gmtime_r() and timegm() */
+static void check_time(time_t t)
+{
+	struct tm got, want;
+	time_t back;
+
+	senoko_gmtime_r(&t, &got);
+	gmtime_r(&t, &want);
+	if (!tm_equal(&got, &want)) {
+		fail("gmtime_r", t, &got, &want);
+		return;
+	}
+
+	back = senoko_mktime(&got);
+	if (back != t || !tm_equal(&got, &want))
+		fail("mktime", t, &got, &want);
+}
+
+/* Every second of the day starting at t */
+static void check_day(time_t t)
+{
+	long s;
+
+	for (s = 0; s < SECSPERDAY; s++)
+		check_time(t + s);
+}
+
+/* The RTC counts the days of the week from Monday = 1 to Sunday = 7 */
+static int tm_equal_rtc(const struct tm *tm, const RTCDateTime *ts)
+{
+	return tm->tm_year + TM_YEAR_BASE == (int)ts->year + RTC_YEAR_BASE &&
+	       tm->tm_mon + 1 == (int)ts->month &&
+	       tm->tm_mday == (int)ts->day &&
+	       (tm->tm_wday ? tm->tm_wday : 7) == (int)ts->dayofweek &&
+	       ts->dstflag == 0;
+}
+
+static void fail_rtc(const char *what, long long t, const RTCDateTime *ts)
+{
+	if (failures++ < 10)
+		printf("%s of %lld differs: %d-%02u-%02u wday %u, %lu ms\n",
+		       what, t, (int)ts->year + RTC_YEAR_BASE,
+		       (unsigned)ts->month, (unsigned)ts->day,
+		       (unsigned)ts->dayofweek,
+		       (unsigned long)ts->millisecond);
+}
+
+/* Every day from 1980 to 2235, at a different time and millisecond each */
+static void check_rtc(void)
+{
+	long first = days_from_civil(RTC_YEAR_BASE, 1, 1);
+	long last = days_from_civil(RTC_YEAR_BASE + 255, 12, 31);
+	RTCDateTime ts;
+	struct tm want;
+	uint32_t msec;
+	time_t t;
+	long day, secs;
+
+	for (day = first; day <= last; day++) {
+		secs = (day * 7919) % SECSPERDAY;
+		msec = (uint32_t)(day % 1000);
+		t = (time_t)day * SECSPERDAY + secs;
+
+		epochToDateTime(t, msec, &ts);
+		gmtime_r(&t, &want);
+		if (!tm_equal_rtc(&want, &ts) ||
+		    ts.millisecond != (uint32_t)secs * 1000 + msec)
+			fail_rtc("epochToDateTime", t, &ts);
+		else if (epochFromDateTime(&ts) != t)
+			fail_rtc("epochFromDateTime", t, &ts);
+	}
+}
+
+/* Fields up to a few times out of range, some of them negative */
+static void random_tm(struct tm *tm)
+{
+	tm->tm_year = rand() % 400 - 100;
+	tm->tm_mon = rand() % 100 - 50;
+	tm->tm_mday = rand() % 200 - 50;
+	tm->tm_hour = rand() % 100 - 50;
+	tm->tm_min = rand() % 400 - 200;
+	tm->tm_sec = rand() % 400 - 200;
+	tm->tm_wday = rand();
+	tm->tm_yday = rand();
+	tm->tm_isdst = 0;
+}
+
+int main(void)
+{
+	struct tm in, got, want;
+	time_t t, tg;
+	long day;
+	int i;
+
+	for (day = -DAYS; day <= DAYS; day++)
+		check_time((time_t)day * SECSPERDAY + (day * 7919) % SECSPERDAY);
+
+	check_day(-SECSPERDAY);			/* 1969-12-31 */
+	check_day(0);				/* 1970-01-01 */
+	check_day(951782400);			/* 2000-02-29 */
+	check_day(1078012800);			/* 2004-02-29 */
+	check_day(2147472000);			/* 2038-01-19 */
+	check_day(-2147558400);			/* 1901-12-13 */
+
+	srand(1);
+	for (i = 0; i < RANDOM_TESTS; i++) {
+		t = (time_t)(int32_t)((unsigned)rand() << 1 ^ (unsigned)rand());
+		check_time(t);
+
+		random_tm(&in);
+		got = in;
+		want = in;
+		t = senoko_mktime(&got);
+		tg = timegm(&want);
+		if (t != tg || !tm_equal(&got, &want))
+			fail("mktime of random fields", (long long)tg,
+			     &got, &want);
+	}
+
+	check_rtc();
+
+	if (failures) {
+		printf("%lu failures\n", failures);
+		return 1;
+	}
+	printf("localtime: all conversions match\n");
+	return 0;
+}
@@ -0,0 +1,341 @@
+/*
+ * senoko - command line access to a Senoko board over i2c-dev.
+ */
+#include <ctype.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "libsenoko.h"
+
+/* Registers polled by watch: IRQ enable/status, grace and power control */
+#define WATCH_FIRST	REG_IRQ_ENABLE
+#define WATCH_COUNT	(REG_POWER - REG_IRQ_ENABLE + 1)
+
+static void print_hex(const uint8_t *block, int count)
+{
+	int offset, byte;
+
+	for (offset = 0; offset < count; offset += 16) {
+		printf("%08x ", offset);
+
+		for (byte = 0; byte < 16; byte++) {
+			if (byte == 8)
+				printf(" ");
+			if (offset + byte < count)
+				printf(" %02x", block[offset + byte]);
+			else
+				printf("   ");
+		}
+
+		printf("  |");
+		for (byte = 0; byte < 16 && byte + offset < count; byte++)
+			printf("%c", isprint(block[offset + byte]) ?
+					block[offset + byte] : '.');
+		printf("|\n");
+	}
+}
+
+static void print_status(const struct senoko_state *st)
+{
+	printf("Signature: %c (0x%02x)\n", st->signature, st->signature);
+	printf("Version %d.%d (%s)\n", st->version_major, st->version_minor,
+	       st->has_battery ? "full" : "abbreviated");
+	printf("Uptime: %u.%03u seconds\n",
+	       st->uptime_ms / 1000, st->uptime_ms % 1000);
+	printf("Power: %s\n", senoko_power_name(st->power));
+	printf("AC: %s\n", st->ac_present ? "present" : "absent");
+	printf("Power button: %s\n", st->button_pressed ? "pressed" : "released");
+	printf("Shutdown requested: %s\n", st->shutdown_pending ? "yes" : "no");
+	printf("Shutdown grace: %u seconds\n", st->shutdown_grace_s);
+	printf("Watchdog is %s\n", st->wdt_enabled ? "enabled" : "disabled");
+	printf("Watchdog fires in %u seconds\n", st->wdt_seconds);
+	printf("Enabled IRQs: 0x%02x\n", st->irq_enable);
+	printf("Triggered IRQs: 0x%02x\n", st->irq_status);
+	if (st->has_gpio)
+		printf("GPIO direction 0x%04x, value 0x%04x\n",
+		       st->gpio_dir, st->gpio_val);
+	printf("UART: %s\n", st->uart_enabled ? "enabled" : "disabled");
+}
+
+static void print_watch(const struct senoko_state *st)
+{
+	printf("power=%s ac=%d button=%d shutdown=%d wdt=%d irq=0x%02x/0x%02x\n",
+	       senoko_power_name(st->power), st->ac_present,
+	       st->button_pressed, st->shutdown_pending, st->wdt_enabled,
+	       st->irq_status, st->irq_enable);
+	fflush(stdout);
+}
+
+static int parse_num(const char *s, unsigned long max, unsigned long *val)
+{
+	char *end;
+
+	errno = 0;
+	*val = strtoul(s, &end, 0);
+	if (errno || end == s || *end || *val > max)
+		return -EINVAL;
+	return 0;
+}
+
+static int cmd_status(struct senoko *dev, int argc, char **argv)
+{
+	struct senoko_state st;
+	int ret;
+
+	(void)argc;
+	(void)argv;
+	ret = senoko_refresh(dev);
+	if (ret)
+		return ret;
+	senoko_state(dev, &st);
+	print_status(&st);
+	return 0;
+}
+
+static int cmd_dump(struct senoko *dev, int argc, char **argv)
+{
+	int ret;
+
+	ret = senoko_refresh(dev);
+	if (ret)
+		return ret;
+	if (argc > 1 && !strcmp(argv[1], "-r")) {
+		if (fwrite(senoko_image(dev), SENOKO_REG_COUNT, 1, stdout) != 1)
+			return -EIO;
+		return 0;
+	}
+	print_hex(senoko_image(dev), SENOKO_REG_COUNT);
+	return 0;
+}
+
+static int cmd_get(struct senoko *dev, int argc, char **argv)
+{
+	unsigned long reg;
+	int ret;
+
+	if (argc != 2 || parse_num(argv[1], SENOKO_REG_COUNT - 1, &reg))
+		return -EINVAL;
+	ret = senoko_refresh_range(dev, reg, 1);
+	if (ret < 0)
+		return ret;
+	printf("0x%02x\n", senoko_image(dev)[reg]);
+	return 0;
+}
+
+static int cmd_set(struct senoko *dev, int argc, char **argv)
+{
+	unsigned long reg, val;
+
+	if (argc != 3 || parse_num(argv[1], SENOKO_REG_COUNT - 1, &reg) ||
+	    parse_num(argv[2], 0xff, &val))
+		return -EINVAL;
+	return senoko_write_reg(dev, reg, val);
+}
+
+static int cmd_power(struct senoko *dev, int argc, char **argv)
+{
+	struct senoko_state st;
+	enum senoko_power_state state;
+	int ret;
+
+	if (argc != 2)
+		return -EINVAL;
+	if (!strcmp(argv[1], "on"))
+		state = SENOKO_POWER_ON;
+	else if (!strcmp(argv[1], "off"))
+		state = SENOKO_POWER_OFF;
+	else if (!strcmp(argv[1], "reboot"))
+		state = SENOKO_POWER_REBOOT;
+	else
+		return -EINVAL;
+
+	/* The power register also holds the watchdog enable, keep it */
+	ret = senoko_refresh_range(dev, REG_POWER, 1);
+	if (ret < 0)
+		return ret;
+	senoko_state(dev, &st);
+	return senoko_set_power(dev, state, st.wdt_enabled);
+}
+
+static int cmd_wdt(struct senoko *dev, int argc, char **argv)
+{
+	struct senoko_state st;
+	unsigned long secs;
+	int ret;
+
+	if (argc != 2)
+		return -EINVAL;
+
+	if (!strcmp(argv[1], "on") || !strcmp(argv[1], "off")) {
+		ret = senoko_refresh_range(dev, REG_POWER, 1);
+		if (ret < 0)
+			return ret;
+		senoko_state(dev, &st);
+		return senoko_set_power(dev, st.power, !strcmp(argv[1], "on"));
+	}
+
+	if (parse_num(argv[1], 255, &secs))
+		return -EINVAL;
+	return senoko_set_watchdog(dev, secs);
+}
+
+static int cmd_rtc(struct senoko *dev, int argc, char **argv)
+{
+	struct senoko_state st;
+	unsigned long secs;
+	char buf[32];
+	struct tm tm;
+	time_t t;
+	int ret;
+
+	if (argc > 2)
+		return -EINVAL;
+
+	if (argc == 2) {
+		if (!strcmp(argv[1], "now"))
+			secs = time(NULL);
+		else if (parse_num(argv[1], 0xffffffff, &secs))
+			return -EINVAL;
+		ret = senoko_set_rtc(dev, secs);
+	} else {
+		ret = senoko_refresh_range(dev, REG_RTC_SECONDS, 4);
+	}
+	if (ret < 0)
+		return ret;
+
+	senoko_state(dev, &st);
+	t = st.rtc_seconds;
+	if (!gmtime_r(&t, &tm) ||
+	    !strftime(buf, sizeof(buf), "%Y-%m-%dT%H:%M:%SZ", &tm))
+		return -ERANGE;
+	printf("%s (%u)\n", buf, st.rtc_seconds);
+	return 0;
+}
+
+/*
+ * Polls only the IRQ and power registers, printing the state whenever
+ * they change.
+ */
+static int cmd_watch(struct senoko *dev, int argc, char **argv)
+{
+	struct senoko_state st;
+	unsigned long ms = 500;
+	int ret;
+
+	if (argc > 2 || (argc == 2 && parse_num(argv[1], 3600000, &ms)))
+		return -EINVAL;
+
+	ret = senoko_refresh(dev);
+	if (ret)
+		return ret;
+	senoko_state(dev, &st);
+	print_watch(&st);
+
+	while (1) {
+		usleep(ms * 1000);
+		ret = senoko_refresh_range(dev, WATCH_FIRST, WATCH_COUNT);
+		if (ret < 0)
+			return ret;
+		if (ret) {
+			senoko_state(dev, &st);
+			print_watch(&st);
+		}
+	}
+}
+
+static const struct {
+	const char *name;
+	int (*func)(struct senoko *dev, int argc, char **argv);
+	const char *help;
+} commands[] = {
+	{ "status", cmd_status, "status            Print the decoded registers" },
+	{ "dump", cmd_dump, "dump [-r]         Hex dump, or raw image with -r" },
+	{ "get", cmd_get, "get REG           Print one register" },
+	{ "set", cmd_set, "set REG VAL       Write one register" },
+	{ "power", cmd_power, "power on|off|reboot" },
+	{ "wdt", cmd_wdt, "wdt SECS|on|off   Set or enable the watchdog" },
+	{ "rtc", cmd_rtc, "rtc [SECS|now]    Print or set the RTC, in UTC" },
+	{ "watch", cmd_watch, "watch [MS]        Print IRQ and power changes" },
+};
+
+static void usage(const char *prog)
+{
+	size_t i;
+
+	fprintf(stderr,
+		"Usage: %s [-d DEV] [-a ADDR] [-s IMAGE] [COMMAND [ARGS]]\n"
+		"  -d DEV    i2c-dev node (default " SENOKO_DEFAULT_BUS ")\n"
+		"  -a ADDR   I2C address (default 0x%02x)\n"
+		"  -s IMAGE  Simulate a board whose registers live in IMAGE\n"
+		"Commands:\n", prog, SENOKO_DEFAULT_ADDR);
+	for (i = 0; i < sizeof(commands) / sizeof(commands[0]); i++)
+		fprintf(stderr, "  %s\n", commands[i].help);
+}
+
+int main(int argc, char **argv)
+{
+	const char *path = SENOKO_DEFAULT_BUS;
+	const char *sim = NULL;
+	unsigned long addr = SENOKO_DEFAULT_ADDR;
+	char *status_argv[] = { "status", NULL };
+	struct senoko *dev;
+	size_t i;
+	int ch, ret;
+
+	while ((ch = getopt(argc, argv, "d:a:s:h")) != -1) {
+		switch (ch) {
+		case 'd':
+			path = optarg;
+			break;
+		case 'a':
+			if (parse_num(optarg, 0x7f, &addr)) {
+				usage(argv[0]);
+				return 1;
+			}
+			break;
+		case 's':
+			sim = optarg;
+			break;
+		default:
+			usage(argv[0]);
+			return 1;
+		}
+	}
+	argc -= optind;
+	argv += optind;
+	if (!argc) {
+		argc = 1;
+		argv = status_argv;
+	}
+
+	for (i = 0; i < sizeof(commands) / sizeof(commands[0]); i++)
+		if (!strcmp(argv[0], commands[i].name))
+			break;
+	if (i == sizeof(commands) / sizeof(commands[0])) {
+		usage(argv[-optind]);
+		return 1;
+	}
+
+	dev = sim ? senoko_open_sim(sim) : senoko_open(path, addr);
+	if (!dev) {
+		perror(sim ? sim : path);
+		return 1;
+	}
+
+	ret = commands[i].func(dev, argc, argv);
+	senoko_close(dev);
+
+	if (ret == -EINVAL) {
+		fprintf(stderr, "Usage: %s\n", commands[i].help);
+		return 1;
+	}
+	if (ret < 0) {
+		fprintf(stderr, "%s: %s\n", argv[0], strerror(-ret));
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,468 @@
+/*
+ * senokod - shares one Senoko I2C reader between any number of host
+ * consumers.
+ *
+ * The register image is cached and published two ways: as a tree of
+ * one-value files in the style of /sys/class/power_supply, and over a
+ * Unix socket where every client gets a uevent-style snapshot on
+ * connect and again whenever something changes.
+ *
+ * Senoko raises its IRQ line (PA0) whenever an enabled IRQ fires.  When
+ * that line is wired to a host GPIO, pass its sysfs value file with -g
+ * (with "edge" set to "rising"): the daemon then only reads the bus when
+ * the line fires, plus a slow refresh for the uptime and RTC.  Without
+ * it, the IRQ and power registers are polled at the -i interval.
+ */
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+#include "libsenoko.h"
+
+#define DEFAULT_SOCKET		"/run/senoko.sock"
+#define DEFAULT_TREE		"/run/senoko"
+#define DEFAULT_POLL_MS		1000
+#define DEFAULT_REFRESH_S	60
+#define MAX_CLIENTS		64
+#define UEVENT_SIZE		1024
+
+/* IRQ enable, IRQ status, shutdown grace and power control */
+#define VOLATILE_FIRST		REG_IRQ_ENABLE
+#define VOLATILE_COUNT		(REG_POWER - REG_IRQ_ENABLE + 1)
+
+static volatile sig_atomic_t quit;
+
+static struct senoko *dev;
+static const char *tree;
+static int listen_fd = -1;
+static int irq_fd = -1;
+static int clients[MAX_CLIENTS];
+static int nclients;
+
+static char uevent[UEVENT_SIZE];
+static size_t uevent_len;
+
+static void on_signal(int sig)
+{
+	(void)sig;
+	quit = 1;
+}
+
+static long now_ms(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/* Replaces tree/name atomically, only if the contents changed */
+static void tree_write(const char *name, const char *fmt, ...)
+	__attribute__((format(printf, 2, 3)));
+
+static void tree_write(const char *name, const char *fmt, ...)
+{
+	char path[256], tmp[272], val[UEVENT_SIZE], old[UEVENT_SIZE];
+	va_list ap;
+	ssize_t n;
+	int fd;
+
+	va_start(ap, fmt);
+	vsnprintf(val, sizeof(val), fmt, ap);
+	va_end(ap);
+
+	snprintf(path, sizeof(path), "%s/%s", tree, name);
+	fd = open(path, O_RDONLY);
+	if (fd >= 0) {
+		n = read(fd, old, sizeof(old) - 1);
+		close(fd);
+		if (n >= 0) {
+			old[n] = '\0';
+			if (!strcmp(old, val))
+				return;
+		}
+	}
+
+	snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+	fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0)
+		return;
+	n = write(fd, val, strlen(val));
+	close(fd);
+	if (n == (ssize_t)strlen(val))
+		rename(tmp, path);
+	else
+		unlink(tmp);
+}
+
+static void uevent_add(const char *fmt, ...)
+	__attribute__((format(printf, 1, 2)));
+
+static void uevent_add(const char *fmt, ...)
+{
+	va_list ap;
+	int n;
+
+	va_start(ap, fmt);
+	n = vsnprintf(uevent + uevent_len, sizeof(uevent) - uevent_len, fmt, ap);
+	va_end(ap);
+	if (n > 0 && (size_t)n < sizeof(uevent) - uevent_len)
+		uevent_len += n;
+}
+
+/*
+ * Rebuilds the snapshot from the cached image.  The AC input is named
+ * the way a power_supply of type Mains would be.
+ */
+static void build_uevent(const struct senoko_state *st)
+{
+	uevent_len = 0;
+	uevent_add("POWER_SUPPLY_NAME=senoko-ac\n");
+	uevent_add("POWER_SUPPLY_TYPE=Mains\n");
+	uevent_add("POWER_SUPPLY_ONLINE=%d\n", st->ac_present);
+	uevent_add("SENOKO_VERSION=%d.%d\n", st->version_major,
+		   st->version_minor);
+	uevent_add("SENOKO_BATTERY=%d\n", st->has_battery);
+	uevent_add("SENOKO_POWER=%s\n", senoko_power_name(st->power));
+	uevent_add("SENOKO_BUTTON=%d\n", st->button_pressed);
+	uevent_add("SENOKO_SHUTDOWN_PENDING=%d\n", st->shutdown_pending);
+	uevent_add("SENOKO_SHUTDOWN_GRACE=%u\n", st->shutdown_grace_s);
+	uevent_add("SENOKO_WDT_ENABLED=%d\n", st->wdt_enabled);
+	uevent_add("SENOKO_WDT_SECONDS=%u\n", st->wdt_seconds);
+	uevent_add("SENOKO_UPTIME_MS=%u\n", st->uptime_ms);
+	uevent_add("SENOKO_RTC_SECONDS=%u\n", st->rtc_seconds);
+	uevent_add("SENOKO_IRQ_ENABLE=0x%02x\n", st->irq_enable);
+	uevent_add("\n");
+}
+
+static void publish_tree(const struct senoko_state *st)
+{
+	if (!tree)
+		return;
+	tree_write("type", "Mains\n");
+	tree_write("online", "%d\n", st->ac_present);
+	tree_write("version", "%d.%d\n", st->version_major, st->version_minor);
+	tree_write("power", "%s\n", senoko_power_name(st->power));
+	tree_write("button", "%d\n", st->button_pressed);
+	tree_write("shutdown_pending", "%d\n", st->shutdown_pending);
+	tree_write("shutdown_grace", "%u\n", st->shutdown_grace_s);
+	tree_write("wdt_enabled", "%d\n", st->wdt_enabled);
+	tree_write("wdt_seconds", "%u\n", st->wdt_seconds);
+	tree_write("uptime_ms", "%u\n", st->uptime_ms);
+	tree_write("rtc_seconds", "%u\n", st->rtc_seconds);
+	tree_write("uevent", "%s", uevent);
+}
+
+static void client_drop(int i)
+{
+	close(clients[i]);
+	clients[i] = clients[--nclients];
+}
+
+/* Snapshots are small, a client that cannot take one whole is dropped */
+static int client_send(int fd)
+{
+	return send(fd, uevent, uevent_len, MSG_NOSIGNAL | MSG_DONTWAIT) ==
+	       (ssize_t)uevent_len ? 0 : -1;
+}
+
+static void publish(void)
+{
+	struct senoko_state st;
+	int i;
+
+	senoko_state(dev, &st);
+	build_uevent(&st);
+	publish_tree(&st);
+	for (i = nclients - 1; i >= 0; i--)
+		if (client_send(clients[i]))
+			client_drop(i);
+}
+
+static void client_accept(void)
+{
+	int fd = accept(listen_fd, NULL, NULL);
+
+	if (fd < 0)
+		return;
+	if (nclients == MAX_CLIENTS || client_send(fd)) {
+		close(fd);
+		return;
+	}
+	clients[nclients++] = fd;
+}
+
+static int listen_on(const char *path)
+{
+	struct sockaddr_un addr;
+	int fd;
+
+	if (strlen(path) >= sizeof(addr.sun_path)) {
+		errno = ENAMETOOLONG;
+		return -1;
+	}
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	strcpy(addr.sun_path, path);
+
+	fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (fd < 0)
+		return -1;
+	unlink(path);
+	if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) ||
+	    listen(fd, 8)) {
+		close(fd);
+		return -1;
+	}
+	return fd;
+}
+
+/* Reading the value file re-arms the edge, returns the line level */
+static int irq_level(void)
+{
+	char c = '0';
+
+	if (lseek(irq_fd, 0, SEEK_SET) < 0 || read(irq_fd, &c, 1) != 1)
+		return -1;
+	return c == '1';
+}
+
+/*
+ * Rereads the registers that change without the host asking.  When IRQs
+ * are in use the status is acknowledged so that the line drops again.
+ */
+static int refresh_volatile(void)
+{
+	int changed, ret;
+
+	changed = senoko_refresh_range(dev, VOLATILE_FIRST, VOLATILE_COUNT);
+	if (changed < 0)
+		return changed;
+
+	if (irq_fd >= 0 && senoko_image(dev)[REG_IRQ_STATUS]) {
+		ret = senoko_write_reg(dev, REG_IRQ_STATUS, 0);
+		if (ret)
+			return ret;
+		changed = 1;
+	}
+	return changed;
+}
+
+static void usage(const char *prog)
+{
+	fprintf(stderr,
+		"Usage: %s [-d DEV] [-a ADDR] [-s IMAGE] [-S SOCKET] [-t DIR]\n"
+		"          [-g GPIO_VALUE] [-i MS] [-r SECS]\n"
+		"  -d DEV     i2c-dev node (default " SENOKO_DEFAULT_BUS ")\n"
+		"  -a ADDR    I2C address (default 0x%02x)\n"
+		"  -s IMAGE   Simulate a board whose registers live in IMAGE\n"
+		"  -S SOCKET  Unix socket to serve (default " DEFAULT_SOCKET ")\n"
+		"  -t DIR     Attribute tree to maintain (default " DEFAULT_TREE ")\n"
+		"  -g FILE    sysfs value file of the GPIO wired to Senoko PA0\n"
+		"  -i MS      Poll interval without -g (default %d)\n"
+		"  -r SECS    Full refresh interval (default %d)\n",
+		prog, SENOKO_DEFAULT_ADDR, DEFAULT_POLL_MS, DEFAULT_REFRESH_S);
+}
+
+int main(int argc, char **argv)
+{
+	const char *path = SENOKO_DEFAULT_BUS;
+	const char *sock = DEFAULT_SOCKET;
+	const char *gpio = NULL;
+	const char *sim = NULL;
+	long poll_ms = DEFAULT_POLL_MS;
+	long refresh_ms = DEFAULT_REFRESH_S * 1000L;
+	long next_poll, next_refresh, now, timeout;
+	struct pollfd pfd[2 + MAX_CLIENTS];
+	int addr = SENOKO_DEFAULT_ADDR;
+	struct sigaction sa;
+	int ch, i, n, first, ret, tries, irq_retry = 0;
+	uint8_t irqen;
+	char buf[64];
+
+	tree = DEFAULT_TREE;
+	while ((ch = getopt(argc, argv, "d:a:s:S:t:g:i:r:h")) != -1) {
+		switch (ch) {
+		case 'd':
+			path = optarg;
+			break;
+		case 'a':
+			addr = strtol(optarg, NULL, 0);
+			break;
+		case 's':
+			sim = optarg;
+			break;
+		case 'S':
+			sock = optarg;
+			break;
+		case 't':
+			tree = *optarg ? optarg : NULL;
+			break;
+		case 'g':
+			gpio = optarg;
+			break;
+		case 'i':
+			poll_ms = strtol(optarg, NULL, 0);
+			break;
+		case 'r':
+			refresh_ms = strtol(optarg, NULL, 0) * 1000L;
+			break;
+		default:
+			usage(argv[0]);
+			return 1;
+		}
+	}
+	if (poll_ms <= 0 || refresh_ms <= 0) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	dev = sim ? senoko_open_sim(sim) : senoko_open(path, addr);
+	if (!dev) {
+		perror(sim ? sim : path);
+		return 1;
+	}
+
+	if (tree && mkdir(tree, 0755) && errno != EEXIST) {
+		perror(tree);
+		return 1;
+	}
+
+	listen_fd = listen_on(sock);
+	if (listen_fd < 0) {
+		perror(sock);
+		return 1;
+	}
+
+	ret = senoko_refresh(dev);
+	if (ret) {
+		fprintf(stderr, "Unable to read Senoko: %s\n", strerror(-ret));
+		return 1;
+	}
+
+	if (gpio) {
+		irq_fd = open(gpio, O_RDONLY | O_CLOEXEC);
+		if (irq_fd < 0) {
+			perror(gpio);
+			return 1;
+		}
+		irq_level();
+
+		/* Let power and button changes raise the line */
+		irqen = senoko_image(dev)[REG_IRQ_ENABLE] |
+			REG_IRQ_POWER_MASK | REG_IRQ_KEYPAD_MASK;
+		ret = senoko_write_reg(dev, REG_IRQ_ENABLE, irqen);
+		if (!ret)
+			ret = refresh_volatile();
+		if (ret < 0) {
+			fprintf(stderr, "Unable to enable IRQs: %s\n",
+				strerror(-ret));
+			return 1;
+		}
+	}
+	publish();
+
+	memset(&sa, 0, sizeof(sa));
+	sa.sa_handler = on_signal;
+	sigaction(SIGINT, &sa, NULL);
+	sigaction(SIGTERM, &sa, NULL);
+
+	now = now_ms();
+	next_poll = now + poll_ms;
+	next_refresh = now + refresh_ms;
+	while (!quit) {
+		n = 0;
+		pfd[n].fd = listen_fd;
+		pfd[n++].events = POLLIN;
+		if (irq_fd >= 0) {
+			pfd[n].fd = irq_fd;
+			pfd[n++].events = POLLPRI | POLLERR;
+		}
+		first = n;
+		for (i = 0; i < nclients; i++) {
+			pfd[n].fd = clients[i];
+			pfd[n++].events = POLLIN;
+		}
+
+		now = now_ms();
+		timeout = next_refresh - now;
+		if ((irq_fd < 0 || irq_retry) && next_poll - now < timeout)
+			timeout = next_poll - now;
+		if (timeout < 0)
+			timeout = 0;
+
+		if (poll(pfd, n, timeout) < 0) {
+			if (errno == EINTR)
+				continue;
+			perror("poll");
+			break;
+		}
+
+		/* Clients only ever listen, any input or hangup ends them */
+		for (i = nclients - 1; i >= 0; i--) {
+			if (!pfd[first + i].revents)
+				continue;
+			if (read(clients[i], buf, sizeof(buf)) <= 0)
+				client_drop(i);
+		}
+		if (pfd[0].revents & POLLIN)
+			client_accept();
+
+		ret = 0;
+		now = now_ms();
+		if (now >= next_refresh) {
+			next_refresh = now + refresh_ms;
+			ret = senoko_refresh(dev);
+			if (!ret && irq_fd >= 0)
+				ret = refresh_volatile();
+			if (!ret)
+				ret = 1;
+		}
+		else if (irq_fd >= 0 ? (pfd[1].revents != 0 ||
+					(irq_retry && now >= next_poll)) :
+					(now >= next_poll)) {
+			next_poll = now + poll_ms;
+			ret = refresh_volatile();
+
+			/*
+			 * An IRQ raised before the acknowledge keeps the line
+			 * high and will not make another edge.
+			 */
+			for (tries = 0; irq_fd >= 0 && ret >= 0 &&
+			     irq_level() == 1 && tries < 3; tries++)
+				ret = refresh_volatile() < 0 ? -EIO : 1;
+
+			/*
+			 * After a failed read the edge is still pending and
+			 * poll() would return at once.  Re-arm it and try
+			 * again at the poll interval instead.
+			 */
+			irq_retry = irq_fd >= 0 && ret < 0;
+			if (irq_retry)
+				irq_level();
+		}
+
+		if (ret < 0)
+			fprintf(stderr, "Unable to read Senoko: %s\n",
+				strerror(-ret));
+		else if (ret > 0)
+			publish();
+	}
+
+	for (i = 0; i < nclients; i++)
+		close(clients[i]);
+	close(listen_fd);
+	unlink(sock);
+	senoko_close(dev);
+	return 0;
+}
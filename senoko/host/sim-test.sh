@@ -0,0 +1,60 @@
+#!/bin/sh
+#
+# Runs the senoko tool against a fresh simulated board and prints each
+# command followed by its output.  "make check" compares the result with
+# sim-test.expected, so a change in the output or in the register write
+# rules shows up as a diff.
+#
+# Usage: sim-test.sh [SENOKO]
+
+SENOKO=${1:-./senoko}
+IMAGE=$(mktemp) || exit 1
+trap 'rm -f "$IMAGE"' EXIT
+rm -f "$IMAGE"
+
+run() {
+	echo "\$ senoko${*:+ $*}"
+	"$SENOKO" -s "$IMAGE" "$@" 2>&1 || echo "[exit $?]"
+}
+
+# Default image
+run
+run status
+run get 0x00
+run get 3
+
+# Writeable registers, read-only ones and the shutdown grace limit
+run set 0x09 0x05
+run get 0x09
+run set 0x00 0x41
+run get 0x00
+run set 0x0e 90
+run get 0x0e
+run set 0x1e 0xff
+run get 0x1e
+
+# The power register only takes writes with the key
+run set 0x0f 0x01
+run get 0x0f
+run power off
+run get 0x0f
+run wdt on
+run status
+run wdt 30
+run get 0x28
+
+# The RTC is only set once its top byte is written
+run rtc
+run rtc 1234567890
+run rtc
+run set 0x20 0x00
+run rtc
+run rtc 4294967295
+run status
+
+# Bad arguments
+run get 0x100
+run set 0x10
+run set 0x10 256
+run rtc 4294967296
+run frob
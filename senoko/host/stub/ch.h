@@ -0,0 +1 @@
+/* Host stand-in for the kernel header, localtime.c needs nothing from it */
@@ -0,0 +1,21 @@
+/*
+ * Host stand-in for the HAL header, with just the RTC timestamp that
+ * localtime.c converts to and from, laid out as in os/hal/include/rtc.h.
+ */
+#ifndef __SENOKO_HOST_HAL_H__
+#define __SENOKO_HOST_HAL_H__
+
+#include <stdint.h>
+
+#define HAL_USE_RTC     1
+
+typedef struct {
+  uint32_t      year: 8;            /* Years since 1980 */
+  uint32_t      month: 4;           /* Months 1..12 */
+  uint32_t      dstflag: 1;         /* DST correction flag */
+  uint32_t      dayofweek: 3;       /* Day of week 1..7 */
+  uint32_t      day: 5;             /* Day of the month 1..31 */
+  uint32_t      millisecond: 27;    /* Milliseconds since midnight */
+} RTCDateTime;
+
+#endif /* __SENOKO_HOST_HAL_H__ */
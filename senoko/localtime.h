@@ -0,0 +1,14 @@
+#ifndef __SENOKO_LOCALTIME_H__
+#define __SENOKO_LOCALTIME_H__
+
+#include <time.h>
+
+#if HAL_USE_RTC
+/* Seconds since 1970 of an RTC timestamp, dropping its milliseconds */
+time_t epochFromDateTime(const RTCDateTime *ts);
+
+/* RTC timestamp of t seconds since 1970 plus msec milliseconds */
+void epochToDateTime(time_t t, uint32_t msec, RTCDateTime *ts);
+#endif /* HAL_USE_RTC */
+
+#endif /* __SENOKO_LOCALTIME_H__ */
@@ -34,7 +34,45 @@
 #include "power.h"
 #include "gg.h"
 
-uint32_t senoko_uptime = 0; /* Incremented every time TIM2 overflows */
+#if CH_CFG_ST_FREQUENCY != 1000
+#error "Uptime accounting assumes a 1 kHz system time"
+#endif
+
+/*
+ * The system runs tickless, and the 16-bit system time wraps every
+ * 65 seconds.  Fold it into a 32-bit millisecond counter often enough
+ * that no wrap is ever missed.
+ */
+#define UPTIME_FOLD_MS 30000
+
+static uint32_t uptime_base;
+static systime_t uptime_last;
+static virtual_timer_t uptime_vt;
+
+static void uptime_fold(void *arg) {
+  (void)arg;
+
+  chSysLockFromISR();
+  senokoUptimeI();
+  chSysUnlockFromISR();
+}
+
+uint32_t senokoUptimeI(void) {
+  systime_t now = chVTGetSystemTimeX();
+
+  uptime_base += (systime_t)(now - uptime_last);
+  uptime_last = now;
+  return uptime_base;
+}
+
+uint32_t senokoUptime(void) {
+  uint32_t uptime;
+
+  chSysLock();
+  uptime = senokoUptimeI();
+  chSysUnlock();
+  return uptime;
+}
 
 static void shell_termination_handler(eventid_t id) {
   static int i = 1;
@@ -112,6 +150,29 @@ static void powered_on_handler(eventid_t id) {
   chprintf(stream, " [Powered on] ");
 }
 
+static event_listener_t power_state_listener;
+
+static void power_state_changed_handler(eventid_t id) {
+  static uint32_t shutdowns_logged;
+  eventflags_t flags = chEvtGetAndClearFlags(&power_state_listener);
+  struct power_shutdown_stats sd;
+  enum power_state state;
+  (void)id;
+
+  for (state = 0; state < __power_state_last; state++)
+    if (flags & POWER_STATE_FLAG(state))
+      chprintf(stream, " [Power: %s] ", powerStateName(state));
+
+  /* Log how each low battery shutdown went, once it's over.*/
+  powerShutdownStats(&sd);
+  if ((sd.requests != shutdowns_logged) &&
+      (powerState() != power_state_low_battery)) {
+    chprintf(stream, " [Low battery shutdown: %lu ms, %lu of %lu unacked] ",
+        ST2MS(sd.last_ticks), sd.timeouts, sd.requests);
+    shutdowns_logged = sd.requests;
+  }
+}
+
 static evhandler_t event_handlers[] = {
   shell_termination_handler,
   power_button_pressed_handler,
@@ -120,6 +181,7 @@ static evhandler_t event_handlers[] = {
   ac_plugged_handler,
   powered_off_handler,
   powered_on_handler,
+  power_state_changed_handler,
 };
 
 static event_listener_t event_listeners[ARRAY_SIZE(event_handlers)];
@@ -139,6 +201,9 @@ int main(void) {
   halInit();
   chSysInit();
 
+  /* Start keeping track of uptime.*/
+  chVTSetPeriodic(&uptime_vt, MS2ST(UPTIME_FOLD_MS), uptime_fold, NULL);
+
   /* Set up I2C early, to prevent conflicting with the RAM DDC.*/
   senokoI2cInit();
 
@@ -158,6 +223,7 @@ int main(void) {
   chEvtRegister(&ac_plugged, &event_listeners[4], 4);
   chEvtRegister(&powered_off, &event_listeners[5], 5);
   chEvtRegister(&powered_on, &event_listeners[6], 6);
+  chEvtRegister(&power_state_changed, &power_state_listener, 7);
 
   chprintf(stream, "\r\nStarting Senoko (Ver %d.%d, git version %s)\r\n", 
       SENOKO_OS_VERSION_MAJOR,
@@ -0,0 +1,152 @@
+#include <stddef.h>
+#include <stdint.h>
+
+#include "membench.h"
+
+/*
+ * The baselines are the routines bionic.c had before it copied, filled
+ * and scanned a word at a time, less strlen()'s off by one.  GCC must
+ * not turn their byte loops into calls to the very routines they are
+ * compared with.
+ */
+#if defined(__GNUC__) && !defined(__clang__)
+#define BASELINE __attribute__((noinline, \
+                               optimize("no-tree-loop-distribute-patterns")))
+#else
+#define BASELINE __attribute__((noinline))
+#endif
+
+/* Rounds of each measurement, the fastest one is kept */
+#define MEMBENCH_ROUNDS 3
+
+typedef long word;
+
+#define wsize   sizeof(word)
+#define wmask   (wsize - 1)
+
+enum membench_routine {
+  ROUTINE_MEMCPY,
+  ROUTINE_MEMCPY_UNALIGNED,
+  ROUTINE_MEMSET,
+  ROUTINE_STRLEN,
+  __routine_last,
+};
+
+static const char *routine_names[] = {
+  "memcpy",
+  "memcpy+1",
+  "memset",
+  "strlen",
+};
+
+static const size_t sizes[] = { 4, 16, 64, MEMBENCH_MAX_SIZE };
+#define NSIZES (sizeof(sizes) / sizeof(sizes[0]))
+
+static volatile size_t sink;
+
+/* A word per iteration, and only if both pointers share their alignment */
+BASELINE static void *baseline_memcpy(void *dst0, const void *src0,
+                                      size_t length) {
+  char *dst = dst0;
+  const char *src = src0;
+  size_t t;
+
+  if ((((uintptr_t)src ^ (uintptr_t)dst) & wmask) || length < wsize)
+    t = length;
+  else
+    t = -(uintptr_t)src & wmask;
+  length -= t;
+  while (t--)
+    *dst++ = *src++;
+
+  t = length / wsize;
+  while (t--) {
+    *(word *)dst = *(const word *)src;
+    src += wsize;
+    dst += wsize;
+  }
+  t = length & wmask;
+  while (t--)
+    *dst++ = *src++;
+  return dst0;
+}
+
+BASELINE static void *baseline_memset(void *dst0, int val, size_t length) {
+  uint8_t *ptr = dst0;
+
+  while (length--)
+    *ptr++ = val;
+  return dst0;
+}
+
+BASELINE static size_t baseline_strlen(const char *s) {
+  size_t i = 0;
+
+  while (s[i])
+    i++;
+  return i;
+}
+
+static const struct membench_impl baseline = {
+  baseline_memcpy,
+  baseline_memset,
+  baseline_strlen,
+};
+
+static uint32_t time_calls(const struct membench_impl *impl,
+                           enum membench_routine routine,
+                           uint8_t *dst, const uint8_t *src, size_t size,
+                           unsigned iterations, uint32_t (*now)(void)) {
+  uint32_t best = UINT32_MAX, start, t;
+  unsigned round, i;
+
+  for (round = 0; round < MEMBENCH_ROUNDS; round++) {
+    start = now();
+    switch (routine) {
+    case ROUTINE_MEMCPY:
+    case ROUTINE_MEMCPY_UNALIGNED:
+      for (i = 0; i < iterations; i++)
+        impl->memcpy(dst, src, size);
+      break;
+    case ROUTINE_MEMSET:
+      for (i = 0; i < iterations; i++)
+        impl->memset(dst, i, size);
+      break;
+    default:
+      for (i = 0; i < iterations; i++)
+        sink += impl->strlen((const char *)src);
+      break;
+    }
+    t = now() - start;
+    if (t < best)
+      best = t;
+  }
+  return best;
+}
+
+int membench_run(int test, const struct membench_impl *impl, uint8_t *buf,
+                 unsigned iterations, uint32_t (*now)(void),
+                 struct membench_result *result) {
+  enum membench_routine routine = test / NSIZES;
+  uint8_t *dst = buf;
+  uint8_t *src = buf + MEMBENCH_BUFFER_SIZE / 2;
+  size_t size, i;
+
+  if (test < 0 || routine >= __routine_last)
+    return 0;
+  size = sizes[test % NSIZES];
+
+  if (routine == ROUTINE_MEMCPY_UNALIGNED)
+    src++;
+  for (i = 0; i < size; i++)
+    src[i] = 'a' + (i % 26);
+  src[size] = '\0';
+
+  result->name = routine_names[routine];
+  result->size = size;
+  result->baseline = time_calls(&baseline, routine, dst, src, size,
+                                iterations, now);
+  result->current = time_calls(impl, routine, dst, src, size,
+                               iterations, now);
+  return 1;
+}
@@ -0,0 +1,42 @@
+#ifndef __SENOKO_MEMBENCH_H__
+#define __SENOKO_MEMBENCH_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Microbenchmark of the bionic.c memory routines, shared by the "bench"
+ * shell command and the host build in host/.  Each test times the
+ * routines in use against the byte and single word loops bionic.c had
+ * before it was tuned, over a set of sizes.
+ */
+
+/* Largest size tested */
+#define MEMBENCH_MAX_SIZE       256
+
+/* Scratch memory needed by membench_run() */
+#define MEMBENCH_BUFFER_SIZE    (2 * (MEMBENCH_MAX_SIZE + 8))
+
+struct membench_impl {
+  void *(*memcpy)(void *dst, const void *src, size_t length);
+  void *(*memset)(void *dst, int val, size_t length);
+  size_t (*strlen)(const char *s);
+};
+
+struct membench_result {
+  const char *name;         /* Routine, with the alignment case */
+  size_t size;              /* Bytes per call */
+  uint32_t baseline;        /* Time of the calls to the old routine */
+  uint32_t current;         /* Time of the calls to the routine in use */
+};
+
+/*
+ * Runs test number test, timing iterations calls of each version with
+ * now(), whose unit is up to the caller.  The best of a few rounds is
+ * kept, to filter out interrupts.  Returns 0 past the last test.
+ */
+int membench_run(int test, const struct membench_impl *impl, uint8_t *buf,
+                 unsigned iterations, uint32_t (*now)(void),
+                 struct membench_result *result);
+
+#endif /* __SENOKO_MEMBENCH_H__ */
@@ -17,14 +17,13 @@
 #include "ch.h"
 #include "uart.h"
 #include "hal.h"
+#include "chprintf.h"
 
 #include "senoko.h"
 
 #include "serial_lld.h"
 #include "bionic.h"
 
-extern int emerg_printf(const char *fmt, ...);
-
 static void emerg_putc(uint8_t c) {
   USART_TypeDef *u = serialDriver->usart;
   uint16_t sr = u->SR;
@@ -45,9 +44,57 @@ void emerg_puts(const char *str) {
   }
 }
 
+/*
+ * A polled stream straight onto the UART, so chprintf can be used once
+ * the system has halted and the serial driver can no longer be trusted.
+ */
+static size_t emerg_write(void *ip, const uint8_t *bp, size_t n) {
+  size_t i;
+  (void)ip;
+
+  for (i = 0; i < n; i++) {
+    if (bp[i] == '\n')
+      emerg_putc('\r');
+    emerg_putc(bp[i]);
+  }
+  return n;
+}
+
+static size_t emerg_read(void *ip, uint8_t *bp, size_t n) {
+  (void)ip;
+  (void)bp;
+  (void)n;
+  return 0;
+}
+
+static msg_t emerg_put(void *ip, uint8_t b) {
+  emerg_write(ip, &b, 1);
+  return MSG_OK;
+}
+
+static msg_t emerg_get(void *ip) {
+  (void)ip;
+  return MSG_RESET;
+}
+
+static const struct BaseSequentialStreamVMT emerg_vmt = {
+  emerg_write, emerg_read, emerg_put, emerg_get
+};
+
+static BaseSequentialStream emerg_stream = {&emerg_vmt};
+
+CHPRINTF_FORMAT(1, 2)
+static void emerg_printf(const char *fmt, ...) {
+  va_list ap;
+
+  va_start(ap, fmt);
+  chvprintf(&emerg_stream, fmt, ap);
+  va_end(ap);
+}
+
 static inline int list_registers(void)
 {
-  int var;
+  uint32_t var;
 
   emerg_printf("Registers:\n");
 
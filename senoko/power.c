@@ -2,6 +2,8 @@
 #include "hal.h"
 
 #include "chg.h"
+#include "power.h"
+#include "senoko.h"
 #include "senoko-wdt.h"
 #include "senoko-events.h"
 
@@ -11,12 +13,14 @@
 /* When powered off, wait this long before allowing a powerup */
 #define COOL_OFF_MS 500
 
-static int cooling_off;
+/* After enabling the mainboard rail, give it this long to settle */
+#define POWER_ON_SETTLE_MS 20
 
-enum power_state {
-  power_off = 0,
-  power_on = 1,
-};
+/* Default time the host gets to shut down cleanly when the battery is low */
+#define SHUTDOWN_GRACE_DEFAULT_S 10
+
+/* Longest grace period that still fits in a 16-bit systime_t */
+#define SHUTDOWN_GRACE_MAX_S 60
 
 #define POWER_STATE_SIGNATURE_MASK 0x00f0
 #define POWER_STATE_SIGNATURE 0x0050
@@ -27,123 +31,242 @@ enum power_state {
 /* Save power state across boots.  Shared with senoko-slave module. */
 static uint32_t *power_state = ((uint32_t *)(0x40006c00 + 0x18));
 
-static void power_set_state_x(enum power_state state) {
+struct power_state_desc {
+  const char *name;
+  uint8_t rail;             /* Whether the mainboard rail is on */
+  uint16_t timeout_ms;      /* Leave the state after this long (0 = never) */
+  enum power_state timeout; /* Where to go when the timeout expires */
+};
+
+static const struct power_state_desc states[__power_state_last] = {
+  [power_state_off] = {
+    "off",         0, 0,                  power_state_off,
+  },
+  [power_state_cooling] = {
+    "cooling",     0, COOL_OFF_MS,        power_state_off,
+  },
+  [power_state_powering_on] = {
+    "powering-on", 1, POWER_ON_SETTLE_MS, power_state_on,
+  },
+  [power_state_on] = {
+    "on",          1, 0,                  power_state_on,
+  },
+  [power_state_rebooting] = {
+    "rebooting",   0, REBOOT_QUIESCE_MS,  power_state_powering_on,
+  },
+  [power_state_low_battery] = {
+    "low-battery", 1, 0,                  power_state_cooling,
+  },
+};
+
+/*
+ * Every permitted state change.  Anything not listed here is refused,
+ * which is what keeps e.g. a power-on request from cutting a cool-off
+ * period short.
+ */
+static const struct power_transition {
+  enum power_state from;
+  enum power_state to;
+} transitions[] = {
+  { power_state_off,         power_state_powering_on },
+  { power_state_off,         power_state_rebooting   },
+  { power_state_cooling,     power_state_off         },
+  { power_state_cooling,     power_state_rebooting   },
+  { power_state_powering_on, power_state_on          },
+  { power_state_powering_on, power_state_cooling     },
+  { power_state_powering_on, power_state_rebooting   },
+  { power_state_powering_on, power_state_low_battery },
+  { power_state_on,          power_state_cooling     },
+  { power_state_on,          power_state_rebooting   },
+  { power_state_on,          power_state_low_battery },
+  { power_state_rebooting,   power_state_powering_on },
+  { power_state_rebooting,   power_state_cooling     },
+  { power_state_low_battery, power_state_cooling     },
+};
+
+static struct power_transition_stats transition_stats[ARRAY_SIZE(transitions)];
+static struct power_state_stats state_stats[__power_state_last];
+
+static struct power_shutdown_stats shutdown_stats;
+static unsigned int shutdown_grace_s = SHUTDOWN_GRACE_DEFAULT_S;
+
+static enum power_state current_state;
+static virtual_timer_t power_vt;
+
+static void power_set_rail(int on) {
   uint32_t new_power_state;
 #ifdef TESTING_POWER
 #warning "Testing power: Won't turn off"
-  palWritePad(GPIOB, PB15, power_on);
+  palWritePad(GPIOB, PB15, 1);
 #else
-  palWritePad(GPIOB, PB15, state);
+  palWritePad(GPIOB, PB15, on);
 #endif
 
   /* Save the value in a persistent register, in case we crash */
   new_power_state = (*power_state);
   new_power_state &= ~POWER_STATE_MASK;
   new_power_state &= ~POWER_STATE_SIGNATURE_MASK;
-  new_power_state |= state;
+  new_power_state |= !!on;
   new_power_state |= POWER_STATE_SIGNATURE;
 
   *power_state = new_power_state;
   return;
 }
 
-static enum power_state power_state_x(void) {
-  return ((*power_state) & POWER_STATE_MASK);
+static int find_transition(enum power_state from, enum power_state to) {
+  unsigned int i;
+
+  for (i = 0; i < ARRAY_SIZE(transitions); i++)
+    if ((transitions[i].from == from) && (transitions[i].to == to))
+      return i;
+  return -1;
 }
 
-static void power_set_state_i(enum power_state state) {
-  if (state != power_state_x()) {
-    power_set_state_x(state);
+static systime_t power_state_timeout(enum power_state state) {
 
-    if (state == power_on)
-      chEvtBroadcastI(&powered_on);
-    else if (state == power_off)
-      chEvtBroadcastI(&powered_off);
-  }
+  /* The low battery grace period is the only runtime-configurable one.*/
+  if (state == power_state_low_battery)
+    return S2ST(shutdown_grace_s);
+  return MS2ST(states[state].timeout_ms);
 }
 
-static void power_set_state(enum power_state state) {
-  if (state != power_state_x()) {
-    chSysLock();
-    power_set_state_x(state);
+static void power_timeout(void *arg);
 
-    if (state == power_on)
+/* Must be called with the system locked.*/
+static bool power_transition_i(enum power_state next) {
+  enum power_state prev = current_state;
+  systime_t now = chVTGetSystemTimeX();
+  systime_t spent;
+  int t;
+
+  t = find_transition(prev, next);
+  if (t < 0)
+    return false;
+
+  /* Account for the time spent in the state we're leaving.*/
+  spent = now - state_stats[prev].entered;
+  state_stats[prev].last_ticks = spent;
+  if (spent > state_stats[prev].max_ticks)
+    state_stats[prev].max_ticks = spent;
+
+  transition_stats[t].count++;
+  transition_stats[t].last = now;
+
+  state_stats[next].entries++;
+  state_stats[next].entered = now;
+
+  if (next == power_state_low_battery)
+    shutdown_stats.requests++;
+  else if (prev == power_state_low_battery)
+    shutdown_stats.last_ticks = spent;
+
+  current_state = next;
+
+  chVTResetI(&power_vt);
+  if (power_state_timeout(next))
+    chVTDoSetI(&power_vt, power_state_timeout(next), power_timeout, NULL);
+
+  if (states[next].rail != states[prev].rail) {
+    power_set_rail(states[next].rail);
+
+    if (states[next].rail)
       chEvtBroadcastI(&powered_on);
-    else if (state == power_off)
+    else {
       chEvtBroadcastI(&powered_off);
-
-    chSchRescheduleS();
-    chSysUnlock();
+      senokoWatchdogDisable();
+    }
   }
+
+  chEvtBroadcastFlagsI(&power_state_changed, POWER_STATE_FLAG(next));
+  return true;
 }
 
-static virtual_timer_t power_on_vt;
-static void call_power_on(void *arg) {
+static void power_timeout(void *arg) {
   (void)arg;
+
   chSysLockFromISR();
-  power_set_state_i(power_on);
+  if (current_state == power_state_low_battery)
+    shutdown_stats.timeouts++;
+  power_transition_i(states[current_state].timeout);
   chSysUnlockFromISR();
 }
 
-/* To prevent flap, make sure the board is off for a certain amount of time.*/
-static virtual_timer_t cool_off_vt;
-static void stop_cool_off(void *arg) {
-  (void)arg;
-  cooling_off = 0;
+static void power_transition(enum power_state next) {
+  chSysLock();
+  power_transition_i(next);
+  chSchRescheduleS();
+  chSysUnlock();
+}
+
+static void power_transition_from_isr(enum power_state next) {
+  chSysLockFromISR();
+  power_transition_i(next);
+  chSysUnlockFromISR();
 }
 
 void powerOff(void) {
-  power_set_state(power_off);
-  cooling_off = 1;
-  chVTSet(&cool_off_vt, MS2ST(COOL_OFF_MS), stop_cool_off, NULL);
-  senokoWatchdogDisable();
+  power_transition(power_state_cooling);
   return;
 }
 
 void powerOffI(void) {
-  chSysLockFromISR();
-  power_set_state_i(power_off);
-  cooling_off = 1;
-  chVTSetI(&cool_off_vt, MS2ST(COOL_OFF_MS), stop_cool_off, NULL);
-  chSysUnlockFromISR();
-  senokoWatchdogDisable();
+  power_transition_from_isr(power_state_cooling);
   return;
 }
 
 void powerOn(void) {
-  if (cooling_off)
-    return;
-  power_set_state(power_on);
+  power_transition(power_state_powering_on);
   return;
 }
 
 void powerOnI(void) {
-  if (cooling_off)
-    return;
-  chSysLockFromISR();
-  power_set_state_i(power_on);
-  chSysUnlockFromISR();
+  power_transition_from_isr(power_state_powering_on);
   return;
 }
 
 void powerRebootI(void) {
-  powerOffI();
-  chSysLockFromISR();
-  chVTSetI(&power_on_vt, MS2ST(REBOOT_QUIESCE_MS), call_power_on, NULL);
-  chSysUnlockFromISR();
+  power_transition_from_isr(power_state_rebooting);
 }
 
 void powerReboot(void) {
-  powerOff();
-  chVTSet(&power_on_vt, MS2ST(REBOOT_QUIESCE_MS), call_power_on, NULL);
+  power_transition(power_state_rebooting);
+}
+
+/*
+ * Ask the host to shut down.  It has shutdown_grace_s seconds to
+ * acknowledge by writing "off" to REG_POWER, after which the rail is
+ * cut regardless.
+ */
+void powerLowBattery(void) {
+  chSysLock();
+  if (power_transition_i(power_state_low_battery) && !shutdown_grace_s)
+    power_transition_i(power_state_cooling);
+  chSchRescheduleS();
+  chSysUnlock();
+}
+
+void powerSetShutdownGrace(unsigned int seconds) {
+  if (seconds > SHUTDOWN_GRACE_MAX_S)
+    seconds = SHUTDOWN_GRACE_MAX_S;
+  shutdown_grace_s = seconds;
+}
+
+unsigned int powerShutdownGrace(void) {
+  return shutdown_grace_s;
+}
+
+void powerShutdownStats(struct power_shutdown_stats *stats) {
+  chSysLock();
+  *stats = shutdown_stats;
+  chSysUnlock();
 }
 
 int powerIsOn(void) {
-  return power_state_x() == power_on;
+  return states[current_state].rail;
 }
 
 int powerIsOff(void) {
-  return power_state_x() == power_off;
+  return !states[current_state].rail;
 }
 
 void powerToggleI(void) {
@@ -154,17 +277,48 @@ void powerToggleI(void) {
   return;
 }
 
+enum power_state powerState(void) {
+  return current_state;
+}
+
+const char *powerStateName(enum power_state state) {
+  if (state >= __power_state_last)
+    return "unknown";
+  return states[state].name;
+}
+
+void powerStateStats(enum power_state state, struct power_state_stats *stats) {
+  chSysLock();
+  *stats = state_stats[state];
+  chSysUnlock();
+}
+
+int powerTransitionStats(int idx, enum power_state *from,
+                         enum power_state *to,
+                         struct power_transition_stats *stats) {
+  if ((idx < 0) || (idx >= (int)ARRAY_SIZE(transitions)))
+    return -1;
+
+  *from = transitions[idx].from;
+  *to = transitions[idx].to;
+  chSysLock();
+  *stats = transition_stats[idx];
+  chSysUnlock();
+  return 0;
+}
+
 void powerInit(void) {
 
-  cooling_off = 0;
+  chVTObjectInit(&power_vt);
+  current_state = power_state_off;
+  state_stats[current_state].entries = 1;
+  state_stats[current_state].entered = chVTGetSystemTime();
 
   /* If the signature is not valid, assume fresh STM32, and power on.*/
-  if (((*power_state) & POWER_STATE_SIGNATURE_MASK) != POWER_STATE_SIGNATURE)
-    powerOn();
-
-  if (powerIsOn())
+  if ((((*power_state) & POWER_STATE_SIGNATURE_MASK) != POWER_STATE_SIGNATURE)
+      || ((*power_state) & POWER_STATE_MASK))
     powerOn();
   else
-    powerOff();
+    power_set_rail(0);
   return;
 }
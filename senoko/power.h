@@ -1,6 +1,37 @@
 #ifndef __SENOKO_POWER_H__
 #define __SENOKO_POWER_H__
 
+enum power_state {
+  power_state_off,          /* Mainboard off, may be powered on */
+  power_state_cooling,      /* Mainboard off, refusing power-on for a while */
+  power_state_powering_on,  /* Mainboard rail on, waiting for it to settle */
+  power_state_on,           /* Mainboard on */
+  power_state_rebooting,    /* Mainboard off, will power on after quiesce */
+  power_state_low_battery,  /* Mainboard being shut down, battery too low */
+  __power_state_last,
+};
+
+/* Event flag broadcast on power_state_changed when entering a state */
+#define POWER_STATE_FLAG(state) ((eventflags_t)1 << (state))
+
+struct power_state_stats {
+  uint32_t entries;         /* Number of times the state was entered */
+  systime_t entered;        /* Time of the most recent entry */
+  systime_t last_ticks;     /* Duration of the most recent completed visit */
+  systime_t max_ticks;      /* Longest completed visit */
+};
+
+struct power_transition_stats {
+  uint32_t count;           /* Number of times the transition was taken */
+  systime_t last;           /* Time it was last taken */
+};
+
+struct power_shutdown_stats {
+  uint32_t requests;        /* Number of low battery shutdowns started */
+  uint32_t timeouts;        /* How many of them the host failed to ack */
+  systime_t last_ticks;     /* Duration of the most recent one */
+};
+
 void powerOff(void);
 void powerOn(void);
 void powerOffI(void);
@@ -11,5 +42,16 @@ void powerToggle(void);
 void powerInit(void);
 void powerReboot(void);
 void powerRebootI(void);
+void powerLowBattery(void);
+void powerSetShutdownGrace(unsigned int seconds);
+unsigned int powerShutdownGrace(void);
+void powerShutdownStats(struct power_shutdown_stats *stats);
+
+enum power_state powerState(void);
+const char *powerStateName(enum power_state state);
+void powerStateStats(enum power_state state, struct power_state_stats *stats);
+int powerTransitionStats(int idx, enum power_state *from,
+                         enum power_state *to,
+                         struct power_transition_stats *stats);
 
 #endif /* __SENOKO_POWER_H__ */
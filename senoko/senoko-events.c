@@ -13,6 +13,8 @@ event_source_t ac_plugged;
 event_source_t ac_unplugged;
 event_source_t powered_off;
 event_source_t powered_on;
+event_source_t power_state_changed;
+event_source_t i2c_bus_stuck;
 
 enum gpio_pin_names {
   pin_power,
@@ -102,6 +104,7 @@ void senokoEventsInit(void) {
   chEvtObjectInit(&ac_unplugged);
   chEvtObjectInit(&powered_off);
   chEvtObjectInit(&powered_on);
+  chEvtObjectInit(&power_state_changed);
 
   refresh_gpios(gpio_states);
 
@@ -7,6 +7,8 @@ extern event_source_t ac_unplugged;
 extern event_source_t ac_plugged;
 extern event_source_t powered_off;
 extern event_source_t powered_on;
+extern event_source_t power_state_changed;
+extern event_source_t i2c_bus_stuck;
 
 void senokoEventsInit(void);
 
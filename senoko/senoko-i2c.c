@@ -5,6 +5,7 @@
 #include "senoko.h"
 #include "power.h"
 #include "bionic.h"
+#include "senoko-events.h"
 #include "senoko-slave.h"
 #include "senoko-i2c.h"
 
@@ -29,6 +30,21 @@ static binary_semaphore_t i2c_bus_sem;
 
 static const systime_t timeout = MS2ST(25);
 
+/* A slave transaction still running after this long has wedged the bus */
+#define I2C_TRANSACTION_TIMEOUT_MS 25
+
+/* Half of a 100 kHz SCL period, used when clocking the bus free */
+#define I2C_RECOVERY_HALF_CLOCK_US 5
+
+/* A slave stuck mid-byte needs at most this many clocks to let go of SDA */
+#define I2C_RECOVERY_CLOCKS 9
+
+#define I2C_SCL_PAD PB10
+#define I2C_SDA_PAD PB11
+
+static virtual_timer_t transaction_vt;
+static bool slave_transaction_active;
+
 struct i2c_registers registers;
 static uint8_t i2c_buffer[sizeof(registers) + 1];
 
@@ -62,26 +78,61 @@ static void senokoI2cLogAppend(struct i2clog *log, int type,
 #define senokoI2cLogAppend(log, type, buffer, bytes)
 #endif /* ! I2C_LOGGING */
 
+/* Must be called with the system locked.*/
+static void i2c_bus_stuck_i(void)
+{
+  chVTResetI(&transaction_vt);
+  chEvtBroadcastI(&i2c_bus_stuck);
+}
+
+static void i2c_transaction_timeout(void *arg)
+{
+  (void)arg;
+  chSysLockFromISR();
+  if (slave_transaction_active)
+    i2c_bus_stuck_i();
+  chSysUnlockFromISR();
+}
+
+/* Must be called with the system locked.*/
+static void i2c_transaction_finished_i(void)
+{
+  chVTResetI(&transaction_vt);
+  if (slave_transaction_active) {
+    slave_transaction_active = false;
+    chBSemSignalI(&master_slave_sem);
+  }
+}
+
 static void i2c_transaction_start(I2CDriver *i2cp)
 {
   (void)i2cp;
   senokoI2cLogAppend(&i2clog, I2C_ENTRY_TYPE_START, NULL, 0);
   chSysLockFromISR();
   chBSemResetI(&master_slave_sem, 1);
+  slave_transaction_active = true;
+  chVTSetI(&transaction_vt, MS2ST(I2C_TRANSACTION_TIMEOUT_MS),
+           i2c_transaction_timeout, NULL);
   senokoSlavePrepTransaction();
   chSysUnlockFromISR();
 }
 
+static void i2c_slave_error(I2CDriver *i2cp, i2cflags_t errors)
+{
+  (void)i2cp;
+  (void)errors;
+  chSysLockFromISR();
+  i2c_bus_stuck_i();
+  chSysUnlockFromISR();
+}
+
 static void i2c_rx_finished(I2CDriver *i2cp, size_t bytes)
 {
   (void)i2cp;
 
   senokoI2cLogAppend(&i2clog, I2C_ENTRY_TYPE_READ, i2c_buffer, bytes);
 
-  /* Shouldn't ever happen.*/
-  if (!bytes)
-    return;
-
+  /* An address-only write (e.g. a bus probe) still ends the transaction.*/
   if (bytes) {
     uint8_t addr = i2c_buffer[0];
 
@@ -92,7 +143,7 @@ static void i2c_rx_finished(I2CDriver *i2cp, size_t bytes)
   }
 
   chSysLockFromISR();
-  chBSemSignalI(&master_slave_sem);
+  i2c_transaction_finished_i();
   senokoSlavePrepTransaction();
   chSysUnlockFromISR();
 }
@@ -102,7 +153,7 @@ static void i2c_tx_finished(I2CDriver *i2cp, size_t bytes)
   (void)i2cp;
   (void)bytes;
   chSysLockFromISR();
-  chBSemSignalI(&master_slave_sem);
+  i2c_transaction_finished_i();
 
   senokoI2cLogAppend(&i2clog, I2C_ENTRY_TYPE_WRITE, i2c_buffer, bytes);
 
@@ -138,42 +189,94 @@ static void senoko_i2c_mode_slave(void)
   }
 }
 
-static THD_WORKING_AREA(waI2cUnstickThread, 128);
-static msg_t i2c_unstick_thread(void *arg) {
-  (void)arg;
-  int stuck_count = 0;
-  I2C_TypeDef *dp = i2cBus->i2c;
+static void i2c_recovery_delay(void)
+{
+  chSysPolledDelayX(US2RTC(STM32_HCLK, I2C_RECOVERY_HALF_CLOCK_US));
+}
 
-  chRegSetThreadName("unstick i2c");
+/*
+ * Clock the bus free.  A device that lost track part way through a byte
+ * keeps SDA low waiting for clocks that will never come.  Feed it up to
+ * nine of them until it lets go, then finish with a STOP so everyone on
+ * the bus agrees it's idle.  The I2C block must be stopped beforehand.
+ */
+static void i2c_bus_clear(void)
+{
+  int i;
 
-  do {
-    if (dp->SR2 & I2C_SR2_BUSY)
-      stuck_count++;
-    else
-      stuck_count = 0;
+  if (palReadPad(GPIOB, I2C_SDA_PAD))
+    return;
 
-    if (stuck_count > 4) {
-      senoko_i2c_mode_slave();
-      stuck_count = 0;
-    }
+  palSetPad(GPIOB, I2C_SCL_PAD);
+  palSetPad(GPIOB, I2C_SDA_PAD);
+  palSetPadMode(GPIOB, I2C_SCL_PAD, PAL_MODE_OUTPUT_OPENDRAIN);
+  palSetPadMode(GPIOB, I2C_SDA_PAD, PAL_MODE_OUTPUT_OPENDRAIN);
 
-    chThdSleepMilliseconds(20);
-  } while(1);
+  for (i = 0; i < I2C_RECOVERY_CLOCKS; i++) {
+    if (palReadPad(GPIOB, I2C_SDA_PAD))
+      break;
+    palClearPad(GPIOB, I2C_SCL_PAD);
+    i2c_recovery_delay();
+    palSetPad(GPIOB, I2C_SCL_PAD);
+    i2c_recovery_delay();
+  }
 
-  return MSG_OK;
+  /* STOP condition: SDA rises while SCL is high.*/
+  palClearPad(GPIOB, I2C_SCL_PAD);
+  i2c_recovery_delay();
+  palClearPad(GPIOB, I2C_SDA_PAD);
+  i2c_recovery_delay();
+  palSetPad(GPIOB, I2C_SCL_PAD);
+  i2c_recovery_delay();
+  palSetPad(GPIOB, I2C_SDA_PAD);
+  i2c_recovery_delay();
+
+  palSetPadMode(GPIOB, I2C_SCL_PAD, PAL_MODE_STM32_ALTERNATE_OPENDRAIN);
+  palSetPadMode(GPIOB, I2C_SDA_PAD, PAL_MODE_STM32_ALTERNATE_OPENDRAIN);
 }
 
+/*
+ * Called from thread context once i2c_bus_stuck has been broadcast,
+ * either because of an error interrupt in slave mode or because a slave
+ * transaction ran past its deadline.
+ */
+void senokoI2cRecoverBus(void)
+{
+  bool hung;
+
+  /*
+   * A hung slave transaction still holds master_slave_sem on behalf of
+   * nobody.  Inherit its claim, otherwise wait our turn like a master.
+   */
+  chSysLock();
+  chVTResetI(&transaction_vt);
+  hung = slave_transaction_active;
+  slave_transaction_active = false;
+  chSysUnlock();
+
+  if (!hung)
+    chBSemWait(&master_slave_sem);
+
+  i2cStop(i2cBus);
+  i2c_bus_clear();
+  chBSemSignal(&master_slave_sem);
+
+  senoko_i2c_mode_slave();
+}
 
 void senokoI2cInit(void)
 {
   chBSemObjectInit(&master_slave_sem, 0);
   chBSemObjectInit(&i2c_bus_sem, 0);
+  chVTObjectInit(&transaction_vt);
+
+  /* The error callback and transaction_vt broadcast it as soon as the
+     slave is started, and senokoSlaveInit() registers on it.*/
+  chEvtObjectInit(&i2c_bus_stuck);
+  i2cSlaveSetErrorCallback(i2cBus, i2c_slave_error);
   i2cStart(i2cBus, &senokoI2cMode);
   senoko_i2c_mode_slave();
 
-  chThdCreateStatic(waI2cUnstickThread, sizeof(waI2cUnstickThread),
-                    HIGHPRIO - 15, i2c_unstick_thread, NULL);
-
   return;
 }
 
@@ -238,10 +341,17 @@ msg_t senokoI2cMasterTransmitTimeout(i2caddr_t addr,
                                    txbuf, txbytes,
                                    rxbuf, rxbytes,
                                    timeout);
-    chBSemSignal(&master_slave_sem);
-    if (ret == MSG_OK)
+    if (ret == MSG_OK) {
+      chBSemSignal(&master_slave_sem);
       break;
+    }
 
+    /* Someone may be sitting on the bus, try to shake them loose.*/
+    if (ret == MSG_TIMEOUT) {
+      i2cStop(i2cBus);
+      i2c_bus_clear();
+    }
+    chBSemSignal(&master_slave_sem);
   }
 
   /* Fixup one-byte copies (if necessary).*/
@@ -27,6 +27,7 @@ extern struct i2clog i2clog;
 #endif /* I2C_LOGGING */
 
 void senokoI2cInit(void);
+void senokoI2cRecoverBus(void);
 msg_t senokoI2cMasterTransmitTimeout(i2caddr_t addr,
                                      const uint8_t *txbuf, size_t txbytes,
                                      uint8_t *rxbuf, size_t rxbytes);
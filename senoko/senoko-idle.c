@@ -0,0 +1,42 @@
+#include "ch.h"
+#include "hal.h"
+
+#include "senoko-idle.h"
+
+/*
+ * Idle accounting.  The system runs tickless, so the CPU only leaves
+ * WFI when an interrupt or a timer alarm is actually due.  These hooks
+ * measure how often that happens and how much time is spent asleep.
+ *
+ * STOP mode is not used: it halts the timer that keeps system time, and
+ * neither the console USART nor the I2C slave can wake the part from it.
+ */
+
+static struct idle_stats stats;
+static rtcnt_t idle_start;
+static bool idle_active;
+
+/* Invoked with the system locked, when switching to the idle thread.*/
+void senokoIdleEnter(void) {
+  idle_start = chSysGetRealtimeCounterX();
+  idle_active = true;
+}
+
+/* Invoked with the system locked, when the idle thread is preempted.*/
+void senokoIdleLeave(void) {
+  if (idle_active) {
+    stats.idle_cycles += (rtcnt_t)(chSysGetRealtimeCounterX() - idle_start);
+    idle_active = false;
+  }
+}
+
+/* Invoked by the idle thread every time WFI returns.*/
+void senokoIdleLoop(void) {
+  stats.wakeups++;
+}
+
+void senokoIdleStats(struct idle_stats *s) {
+  chSysLock();
+  *s = stats;
+  chSysUnlock();
+}
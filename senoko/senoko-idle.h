@@ -0,0 +1,16 @@
+#ifndef __SENOKO_IDLE_H__
+#define __SENOKO_IDLE_H__
+
+struct idle_stats {
+  uint32_t wakeups;         /* Number of times the CPU left WFI */
+  uint64_t idle_cycles;     /* CPU cycles spent in the idle thread */
+};
+
+/* Called from the kernel idle hooks, see chconf.h */
+void senokoIdleEnter(void);
+void senokoIdleLeave(void);
+void senokoIdleLoop(void);
+
+void senokoIdleStats(struct idle_stats *stats);
+
+#endif /* __SENOKO_IDLE_H__ */
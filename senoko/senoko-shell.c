@@ -19,10 +19,12 @@
 #include "shell.h"
 #include "chprintf.h"
 #include "senoko.h"
+#include "senoko-wdt.h"
 
 /* Global stream variable, lets modules use chprintf().*/
 void *stream;
 
+void cmd_bench(BaseSequentialStream *chp, int argc, char *argv[]);
 void cmd_chg(BaseSequentialStream *chp, int argc, char *argv[]);
 void cmd_date(BaseSequentialStream *chp, int argc, char *argv[]);
 void cmd_gg(BaseSequentialStream *chp, int argc, char *argv[]);
@@ -35,8 +37,11 @@ void cmd_stats(BaseSequentialStream *chp, int argc, char *argv[]);
 void cmd_reboot(BaseSequentialStream *chp, int argc, char *argv[]);
 void cmd_threads(BaseSequentialStream *chp, int argc, char *argv[]);
 void cmd_uptime(BaseSequentialStream *chp, int argc, char *argv[]);
+void cmd_wdt(BaseSequentialStream *chp, int argc, char *argv[]);
 
+/* Kept sorted by name, the shell looks commands up by bisection.*/
 static const ShellCommand shellCommands[] = {
+  {"bench", cmd_bench},
   {"chg", cmd_chg},
   {"date", cmd_date},
   {"gg", cmd_gg},
@@ -45,16 +50,31 @@ static const ShellCommand shellCommands[] = {
   {"leds", cmd_leds},
   {"mem", cmd_mem},
   {"power", cmd_power},
-  {"stats", cmd_stats},
   {"reboot", cmd_reboot},
+  {"stats", cmd_stats},
   {"threads", cmd_threads},
   {"uptime", cmd_uptime},
+  {"wdt", cmd_wdt},
   {NULL, NULL}
 };
 
+/* Longest a single shell command may run before the watchdog fires.*/
+#define SHELL_COMMAND_TIMEOUT_MS 60000
+
+static int shell_wdt_id = -1;
+
+/* The shell is only supervised while a command runs, not at the prompt.*/
+static void shell_busy(bool busy) {
+  if (busy)
+    senokoWatchdogCheckin(shell_wdt_id);
+  else
+    senokoWatchdogPause(shell_wdt_id);
+}
+
 static const ShellConfig shellConfig = {
   stream_driver,
-  shellCommands
+  shellCommands,
+  shell_busy,
 };
 
 static const SerialConfig serialConfig = {
@@ -65,13 +85,18 @@ static const SerialConfig serialConfig = {
 };
 
 static thread_t *shell_tp = NULL;
-static THD_WORKING_AREA(waShellThread, 1024);
+/* The line buffer and the history live on the shell stack.*/
+static THD_WORKING_AREA(waShellThread, 960 + SHELL_MAX_LINE_LENGTH +
+                                       SHELL_HISTORY_SIZE);
 
 void senokoShellInit(void) {
   sdStart(serialDriver, &serialConfig);
   stream = stream_driver;
 
   shellInit();
+
+  shell_wdt_id = senokoWatchdogRegister("shell", SHELL_COMMAND_TIMEOUT_MS);
+  senokoWatchdogPause(shell_wdt_id);
 }
 
 void senokoShellRestart(void) {
@@ -8,6 +8,7 @@
 #include "uart.h"
 #include "senoko.h"
 #include "senoko-events.h"
+#include "senoko-i2c.h"
 #include "senoko-slave.h"
 #include "senoko-wdt.h"
 
@@ -21,6 +22,13 @@ static uint32_t *power_state = ((uint32_t *)(0x40006c00 + 0x18));
 #define AC_CONNETED_ID 3
 #define POWERED_OFF_ID 4
 #define POWERED_ON_ID 5
+#define POWER_STATE_CHANGED_ID 6
+#define I2C_BUS_STUCK_ID 7
+
+#if HAL_USE_RTC
+/* RTC seconds written so far, set on the RTC once the top byte arrives.*/
+static uint8_t rtc_seconds[4];
+#endif
 
 static void update_irq(void) {
   if (registers.irq_status)
@@ -67,6 +75,32 @@ static void power_event(eventid_t id) {
   update_irq();
 }
 
+static event_listener_t event_listener[8];
+
+/*
+ * Entering the low battery state means we're about to cut power.  Let
+ * the host know, so it can shut down and acknowledge by writing "off"
+ * to REG_POWER before the grace period runs out.
+ */
+static void shutdown_event(eventid_t id) {
+  eventflags_t flags = chEvtGetAndClearFlags(&event_listener[id]);
+
+  if (flags & POWER_STATE_FLAG(power_state_low_battery)) {
+    registers.power |= REG_POWER_SHUTDOWN_MASK;
+    if (registers.irq_enable & REG_IRQ_POWER_MASK)
+      registers.irq_status |= REG_IRQ_POWER_MASK;
+  }
+  else
+    registers.power &= ~REG_POWER_SHUTDOWN_MASK;
+
+  update_irq();
+}
+
+static void bus_stuck_event(eventid_t id) {
+  (void)id;
+  senokoI2cRecoverBus();
+}
+
 static evhandler_t evthandler[] = { 
   button_event, /* Power button pressed */
   button_event, /* Power button released */
@@ -74,10 +108,10 @@ static evhandler_t evthandler[] = {
   ac_event, /* AC unplugged */
   power_event,  /* Powered off */
   power_event,  /* Powered on */
+  shutdown_event, /* Power state changed */
+  bus_stuck_event, /* I2C bus stuck */
 };
 
-static event_listener_t event_listener[6];
-
 void senokoSlaveDispatch(void *bfr, uint32_t size) {
   uint32_t offset;
   uint32_t count;
@@ -132,6 +166,11 @@ void senokoSlaveDispatch(void *bfr, uint32_t size) {
       /* IRQ status values (allow user to clear status) */
       ((uint8_t *)&registers)[offset] = b[count];
     }
+    else if (offset == REG_SHUTDOWN_GRACE) {
+      /* Low battery shutdown grace period, in seconds */
+      powerSetShutdownGrace(b[count]);
+      registers.shutdown_grace = powerShutdownGrace();
+    }
     else if (offset == REG_WATCHDOG_SECONDS) {
       /* Watchdog */
       senokoWatchdogSet(b[count]);
@@ -154,6 +193,19 @@ void senokoSlaveDispatch(void *bfr, uint32_t size) {
         break;
       }
     }
+#if HAL_USE_RTC
+    else if (offset >= REG_RTC_SECONDS && offset < REG_RTC_SECONDS + 4) {
+      /* Staged so the counter is set with one backup domain write */
+      rtc_seconds[offset - REG_RTC_SECONDS] = b[count];
+      if (offset == REG_RTC_SECONDS + 3) {
+        uint32_t seconds;
+
+        memcpy(&seconds, rtc_seconds, sizeof(seconds));
+        rtcSTM32SetSec(&RTCD1, seconds);
+        memcpy(registers.seconds, rtc_seconds, sizeof(registers.seconds));
+      }
+    }
+#endif /* HAL_USE_RTC */
     else if ( (offset >= 0x10 && offset < 0x11) || 
          (offset >= 0x14 && offset < 0x1b)) {
       /* GPIO registers */
@@ -167,19 +219,35 @@ void senokoSlaveDispatch(void *bfr, uint32_t size) {
 }
 
 void senokoSlavePrepTransaction(void) {
-  memcpy(registers.uptime, &senoko_uptime, sizeof(registers.uptime));
+  uint32_t uptime = senokoUptimeI();
+
+  memcpy(registers.uptime, &uptime, sizeof(registers.uptime));
+#if HAL_USE_RTC
+  {
+    uint32_t seconds;
+
+    rtcSTM32GetSecMsec(&RTCD1, &seconds, NULL);
+    memcpy(registers.seconds, &seconds, sizeof(registers.seconds));
+  }
+#endif
   registers.wdt_seconds = senokoWatchdogTimeToReset();
+  registers.shutdown_grace = powerShutdownGrace();
   if (senokoWatchdogEnabled())
     registers.power |= REG_POWER_WDT_ENABLE;
   else
     registers.power &= ~REG_POWER_WDT_ENABLE;
 }
 
+/* The slave thread wakes at least this often to check in with the watchdog.*/
+#define I2C_SLAVE_WDT_PERIOD_MS 4000
+
 static THD_WORKING_AREA(waI2cSlaveThread, 256);
 static msg_t i2c_slave_thread(void *arg) {
+  int wdt_id;
   (void)arg;
 
   chRegSetThreadName("i2c slave thread");
+  wdt_id = senokoWatchdogRegister("i2c slave", 2 * I2C_SLAVE_WDT_PERIOD_MS);
   chThdSleepMilliseconds(300);
 
   chEvtRegister(&power_button_pressed, &event_listener[0], POWER_BUTTON_PRESSED_ID);
@@ -188,9 +256,15 @@ static msg_t i2c_slave_thread(void *arg) {
   chEvtRegister(&ac_plugged, &event_listener[3], AC_CONNETED_ID);
   chEvtRegister(&powered_off, &event_listener[4], POWERED_OFF_ID);
   chEvtRegister(&powered_on, &event_listener[5], POWERED_ON_ID);
-
-  while (TRUE)
-    chEvtDispatch(evthandler, chEvtWaitOne(ALL_EVENTS));
+  chEvtRegister(&power_state_changed, &event_listener[6], POWER_STATE_CHANGED_ID);
+  chEvtRegister(&i2c_bus_stuck, &event_listener[7], I2C_BUS_STUCK_ID);
+
+  while (TRUE) {
+    chEvtDispatch(evthandler,
+                  chEvtWaitOneTimeout(ALL_EVENTS,
+                                      MS2ST(I2C_SLAVE_WDT_PERIOD_MS)));
+    senokoWatchdogCheckin(wdt_id);
+  }
 
   return MSG_OK;
 }
@@ -211,6 +285,7 @@ void senokoSlaveInit(void) {
                   | REG_POWER_KEY_READ;
 
   registers.irq_enable = (*power_state) >> 8;
+  registers.shutdown_grace = powerShutdownGrace();
 
   chThdCreateStatic(waI2cSlaveThread, sizeof(waI2cSlaveThread),
                           70, i2c_slave_thread, NULL);
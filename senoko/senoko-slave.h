@@ -9,7 +9,8 @@ struct i2c_registers {
   uint8_t uptime[4];        /* 0x04 - 0x07 */
   uint8_t irq_enable;       /* 0x08 */
   uint8_t irq_status;       /* 0x09 */
-  uint8_t padding0[5];      /* 0x0a - 0x0e */
+  uint8_t padding0[4];      /* 0x0a - 0x0d */
+  uint8_t shutdown_grace;   /* 0x0e */
   uint8_t power;            /* 0x0f */
 
   /* -- GPIO block -- */
@@ -47,6 +48,8 @@ struct i2c_registers {
 #define REG_IRQ_POWER_MASK        (1 << 2)
 #define REG_IRQ_ALARM_MASK        (1 << 3)
 
+#define REG_SHUTDOWN_GRACE 0x0e
+
 #define REG_POWER 0x0f
 #define REG_POWER_STATE_MASK      (3 << 0)
 #define REG_POWER_STATE_ON        (0 << 0)
@@ -60,6 +63,7 @@ struct i2c_registers {
 #define REG_POWER_AC_STATUS_SHIFT (3)
 #define REG_POWER_PB_STATUS_MASK  (1 << 4)
 #define REG_POWER_PB_STATUS_SHIFT (4)
+#define REG_POWER_SHUTDOWN_MASK   (1 << 5)
 #define REG_POWER_KEY_MASK        (3 << 6)
 #define REG_POWER_KEY_READ        (1 << 6)
 #define REG_POWER_KEY_WRITE       (2 << 6)
@@ -69,6 +73,8 @@ struct i2c_registers {
 #define REG_UART_STATE_ON         (0 << 0)
 #define REG_UART_STATE_OFF        (1 << 0)
 
+#define REG_RTC_SECONDS 0x20   /* Little endian, set when 0x23 is written */
+
 #define REG_WATCHDOG_SECONDS 0x28
 
 extern struct i2c_registers registers;
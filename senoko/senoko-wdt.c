@@ -1,7 +1,9 @@
 #include "ch.h"
 #include "hal.h"
 #include "iwdg.h"
+#include "chprintf.h"
 #include "power.h"
+#include "senoko.h"
 #include "senoko-wdt.h"
 
 static const IWDGConfig watchdogConfig = {
@@ -12,6 +14,9 @@ static const IWDGConfig watchdogConfig = {
 static int enabled = 0;
 static int seconds;
 
+static struct wdt_client clients[SENOKO_WATCHDOG_CLIENTS];
+static int client_count;
+
 int senokoWatchdogEnabled(void) {
   return enabled;
 }
@@ -32,15 +37,101 @@ void senokoWatchdogDisable(void) {
   enabled = 0;
 }
 
-static THD_WORKING_AREA(waWdtThread, 32);
+/*
+ * Each critical thread registers with a deadline and must check in at
+ * least that often.  The hardware IWDG is only kicked while every
+ * registered thread is live, so a hung thread resets the board.
+ */
+int senokoWatchdogRegister(const char *name, uint32_t timeout_ms) {
+  int id = -1;
+
+  chSysLock();
+  if (client_count < SENOKO_WATCHDOG_CLIENTS) {
+    id = client_count++;
+    clients[id].name = name;
+    clients[id].timeout_ms = timeout_ms;
+    clients[id].remaining_ms = timeout_ms;
+    clients[id].last_checkin = senokoUptimeI();
+    clients[id].paused = false;
+  }
+  chSysUnlock();
+
+  return id;
+}
+
+void senokoWatchdogCheckin(int id) {
+  if ((id < 0) || (id >= client_count))
+    return;
+
+  chSysLock();
+  clients[id].remaining_ms = clients[id].timeout_ms;
+  clients[id].last_checkin = senokoUptimeI();
+  clients[id].paused = false;
+  chSysUnlock();
+}
+
+/* Stop supervising a thread until its next check-in.*/
+void senokoWatchdogPause(int id) {
+  if ((id < 0) || (id >= client_count))
+    return;
+
+  chSysLock();
+  clients[id].last_checkin = senokoUptimeI();
+  clients[id].paused = true;
+  chSysUnlock();
+}
+
+int senokoWatchdogClient(int id, struct wdt_client *client) {
+  if ((id < 0) || (id >= client_count))
+    return -1;
+
+  chSysLock();
+  *client = clients[id];
+  chSysUnlock();
+  return 0;
+}
+
+/* Returns the first client that missed its deadline, or NULL.*/
+static const char *wdt_update_clients(void) {
+  const char *hung = NULL;
+  int i;
+
+  chSysLock();
+  for (i = 0; i < client_count; i++) {
+    if (clients[i].paused)
+      continue;
+    if (clients[i].remaining_ms < SENOKO_WATCHDOG_THREAD_MS) {
+      clients[i].remaining_ms = 0;
+      if (!hung)
+        hung = clients[i].name;
+    }
+    else
+      clients[i].remaining_ms -= SENOKO_WATCHDOG_THREAD_MS;
+  }
+  chSysUnlock();
+
+  return hung;
+}
+
+static THD_WORKING_AREA(waWdtThread, 192);
 static msg_t wdt_thread(void *arg) {
   (void)arg;
 
+  const char *hung;
+  bool reported = false;
+  systime_t deadline = chVTGetSystemTime();
+
   chRegSetThreadName("senoko watchdog");
 
   while (1) {
-    iwdgReset(&IWDGD);
-    chThdSleepMilliseconds(SENOKO_WATCHDOG_THREAD_MS);
+    hung = wdt_update_clients();
+    if (!hung)
+      iwdgReset(&IWDGD);
+    else if (!reported) {
+      chprintf(stream, "\r\nWatchdog: \"%s\" missed its deadline\r\n", hung);
+      reported = true;
+    }
+    chThdSleepPeriod(&deadline, MS2ST(SENOKO_WATCHDOG_THREAD_MS));
 
     if (enabled && seconds)
       seconds--;
@@ -12,6 +12,19 @@
  */
 #define SENOKO_WATCHDOG_THREAD_MS   500
 
+/*
+ * @brief   Maximum number of threads the watchdog can supervise.
+ */
+#define SENOKO_WATCHDOG_CLIENTS     6
+
+struct wdt_client {
+  const char *name;
+  uint32_t timeout_ms;      /* Longest allowed gap between check-ins */
+  uint32_t remaining_ms;    /* Time left before the deadline is missed */
+  uint32_t last_checkin;    /* Uptime (ms) of the most recent check-in */
+  bool paused;              /* Blocked on external input, not supervised */
+};
+
 void senokoWatchdogInit(void);
 int senokoWatchdogEnabled(void);
 int senokoWatchdogTimeToReset(void);
@@ -19,4 +32,9 @@ void senokoWatchdogEnable(void);
 void senokoWatchdogDisable(void);
 void senokoWatchdogSet(int new_seconds);
 
+int senokoWatchdogRegister(const char *name, uint32_t timeout_ms);
+void senokoWatchdogCheckin(int id);
+void senokoWatchdogPause(int id);
+int senokoWatchdogClient(int id, struct wdt_client *client);
+
 #endif /* __SENOKO_WDT_H__ */
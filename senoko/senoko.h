@@ -16,6 +16,8 @@ extern void *stream;
 #define ARRAY_SIZE(x) (sizeof(x) / sizeof(*x))
 #endif
 
-extern uint32_t senoko_uptime;
+/* Milliseconds since boot.  The I variant must be called with the system locked. */
+uint32_t senokoUptime(void);
+uint32_t senokoUptimeI(void);
 
 #endif /* __SENOKO_H__ */
@@ -49,6 +49,12 @@
  * - @subpage test_benchmarks_011
  * - @subpage test_benchmarks_012
  * - @subpage test_benchmarks_013
+ * - @subpage test_benchmarks_014
+ * - @subpage test_benchmarks_015
+ * - @subpage test_benchmarks_016
+ * - @subpage test_benchmarks_017
+ * - @subpage test_benchmarks_018
+ * - @subpage test_benchmarks_019
  * .
  * @file testbmk.c Kernel Benchmarks
  * @brief Kernel Benchmarks source file
@@ -56,11 +62,19 @@
  * @brief Kernel Benchmarks header file
  */
 
-static semaphore_t sem1;
+static semaphore_t sem1, sem2;
 #if CH_CFG_USE_MUTEXES || defined(__DOXYGEN__)
 static mutex_t mtx1;
 #endif
 
+/* Shortest virtual timer period, in tick-less mode the alarm cannot be
+   programmed closer than CH_CFG_ST_TIMEDELTA.*/
+#if CH_CFG_ST_TIMEDELTA > 0
+#define BMK_VT_PERIOD   CH_CFG_ST_TIMEDELTA
+#else
+#define BMK_VT_PERIOD   1
+#endif
+
 static msg_t thread1(void *p) {
   thread_t *tp;
   msg_t msg;
@@ -688,6 +702,581 @@ ROMCONST struct testcase testbmk13 = {
   bmk13_execute
 };
 
+#if CH_CFG_USE_HEAP || defined(__DOXYGEN__)
+/**
+ * @page test_benchmarks_014 Ready list performance
+ *
+ * <h2>Description</h2>
+ * Placeholder threads, never started, are inserted in the ready list with
+ * priorities lower than the tester thread. A further placeholder with the
+ * lowest priority is then made ready behind all of them and removed again
+ * into a continuous loop, this is repeated with 4, 16 and 64 threads in
+ * the ready list.<br>
+ * The reschedule cost is then measured with 4, 16 and 64 real threads of
+ * the same priority, each one yielding to the next into a continuous loop,
+ * every yield puts a thread at the end of its priority level.<br>
+ * The performance is calculated by measuring the number of iterations after
+ * a second of continuous operations.
+ */
+
+static uint32_t rlist_loop_test(thread_t *tp, unsigned nthds) {
+  thread_t *xtp = &tp[nthds];
+  tprio_t prio = chThdGetPriorityX();
+  uint32_t n = 0;
+  unsigned i;
+
+  for (i = 0; i < nthds; i++) {
+    tp[i].p_prio = LOWPRIO + 1 + (i % (prio - LOWPRIO - 1));
+    tp[i].p_state = CH_STATE_SUSPENDED;
+  }
+  xtp->p_prio = LOWPRIO;
+  xtp->p_state = CH_STATE_SUSPENDED;
+
+  /* From here on the tester must not sleep or a placeholder would be
+     scheduled.*/
+  test_wait_tick();
+  chSysLock();
+  for (i = 0; i < nthds; i++)
+    chSchReadyI(&tp[i]);
+  chSysUnlock();
+
+  test_start_timer(1000);
+  do {
+    chSysLock();
+    chSchReadyI(xtp);
+    rlist_dequeue(xtp)->p_state = CH_STATE_SUSPENDED;
+    chSchReadyI(xtp);
+    rlist_dequeue(xtp)->p_state = CH_STATE_SUSPENDED;
+    chSysUnlock();
+    n += 2;
+#if defined(SIMULATOR)
+    ChkIntSources();
+#endif
+  } while (!test_timer_done);
+
+  chSysLock();
+  for (i = 0; i < nthds; i++)
+    rlist_dequeue(&tp[i]);
+  chSysUnlock();
+  return n;
+}
+
+#if CH_CFG_USE_DYNAMIC || defined(__DOXYGEN__)
+static msg_t yielder(void *p) {
+  uint32_t n = 0;
+
+  (void)p;
+  while (!test_timer_done) {
+    chThdYield();
+    n++;
+  }
+  return (msg_t)n;
+}
+
+/* Yields per second of nthds threads, zero if they do not fit the heap.*/
+static uint32_t yield_loop_test(unsigned nthds) {
+  thread_t **tpp = chHeapAlloc(NULL, nthds * sizeof(thread_t *));
+  uint32_t n = 0;
+  unsigned i, created;
+
+  if (tpp == NULL)
+    return 0;
+  for (created = 0; created < nthds; created++) {
+    tpp[created] = chThdCreateFromHeap(NULL, WA_SIZE,
+                                       chThdGetPriorityX() - 1,
+                                       yielder, NULL);
+    if (tpp[created] == NULL)
+      break;
+  }
+
+  /* The yielders only run once the tester waits for them.*/
+  if (created == nthds) {
+    test_wait_tick();
+    test_start_timer(1000);
+  }
+  else
+    test_timer_done = TRUE;
+  for (i = 0; i < created; i++)
+    n += (uint32_t)chThdWait(tpp[i]);
+  chHeapFree(tpp);
+  return (created == nthds) ? n : 0;
+}
+#endif /* CH_CFG_USE_DYNAMIC */
+
+static void bmk14_execute(void) {
+  static const unsigned nthds[] = {4, 16, 64};
+  unsigned i;
+
+  for (i = 0; i < sizeof(nthds) / sizeof(nthds[0]); i++) {
+    thread_t *tp = chHeapAlloc(NULL, (nthds[i] + 1) * sizeof(thread_t));
+    uint32_t n;
+
+    if (tp == NULL) {
+      test_print("--- Score : not enough heap for ");
+      test_printn(nthds[i]);
+      test_println(" threads");
+      return;
+    }
+    n = rlist_loop_test(tp, nthds[i]);
+    chHeapFree(tp);
+    test_print("--- Score : ");
+    test_printn(n);
+    test_print(" ready/S, ");
+    test_printn(nthds[i]);
+    test_println(" threads ready");
+  }
+
+#if CH_CFG_USE_DYNAMIC
+  for (i = 0; i < sizeof(nthds) / sizeof(nthds[0]); i++) {
+    uint32_t n = yield_loop_test(nthds[i]);
+
+    if (n == 0) {
+      test_print("--- Score : not enough heap for ");
+      test_printn(nthds[i]);
+      test_println(" threads");
+      return;
+    }
+    test_print("--- Score : ");
+    test_printn(n);
+    test_print(" yields/S, ");
+    test_printn(nthds[i]);
+    test_println(" threads yielding");
+  }
+#endif
+}
+
+ROMCONST struct testcase testbmk14 = {
+  "Benchmark, ready list insertion",
+  NULL,
+  NULL,
+  bmk14_execute
+};
+
+/**
+ * @page test_benchmarks_015 Virtual Timers with many timers armed
+ *
+ * <h2>Description</h2>
+ * Placeholder timers are armed with delays spread over two seconds, then
+ * one of them after the other is reset and armed again into a continuous
+ * loop, this is repeated with 256, 1024 and 4096 timers armed.<br>
+ * The performance is calculated by measuring the number of iterations after
+ * a second of continuous operations.
+ */
+
+static systime_t vt_loop_delay(unsigned i, uint32_t n) {
+
+  return S2ST(2) + (systime_t)((i * 7919U + n) % S2ST(2));
+}
+
+static uint32_t vt_loop_test(virtual_timer_t *vtp, unsigned ntmrs) {
+  uint32_t n = 0;
+  unsigned i;
+
+  chSysLock();
+  for (i = 0; i < ntmrs; i++)
+    chVTDoSetI(&vtp[i], vt_loop_delay(i, 0), tmo, NULL);
+  chSysUnlock();
+
+  test_wait_tick();
+  test_start_timer(1000);
+  i = 0;
+  do {
+    chSysLock();
+    chVTDoResetI(&vtp[i]);
+    chVTDoSetI(&vtp[i], vt_loop_delay(i, n), tmo, NULL);
+    chSysUnlock();
+    if (++i >= ntmrs)
+      i = 0;
+    n++;
+#if defined(SIMULATOR)
+    ChkIntSources();
+#endif
+  } while (!test_timer_done);
+
+  chSysLock();
+  for (i = 0; i < ntmrs; i++)
+    chVTResetI(&vtp[i]);
+  chSysUnlock();
+  return n;
+}
+
+static void bmk15_execute(void) {
+  static const unsigned ntmrs[] = {256, 1024, 4096};
+  unsigned i;
+
+  for (i = 0; i < sizeof(ntmrs) / sizeof(ntmrs[0]); i++) {
+    virtual_timer_t *vtp = chHeapAlloc(NULL,
+                                       ntmrs[i] * sizeof(virtual_timer_t));
+    uint32_t n;
+
+    if (vtp == NULL) {
+      test_print("--- Score : not enough heap for ");
+      test_printn(ntmrs[i]);
+      test_println(" timers");
+      return;
+    }
+    n = vt_loop_test(vtp, ntmrs[i]);
+    chHeapFree(vtp);
+    test_print("--- Score : ");
+    test_printn(n);
+    test_print(" timers/S, ");
+    test_printn(ntmrs[i]);
+    test_println(" timers armed");
+  }
+}
+
+ROMCONST struct testcase testbmk15 = {
+  "Benchmark, virtual timers insertion",
+  NULL,
+  NULL,
+  bmk15_execute
+};
+#endif /* CH_CFG_USE_HEAP */
+
+/**
+ * @page test_benchmarks_016 Semaphores wait with timeout ping-pong
+ *
+ * <h2>Description</h2>
+ * A server thread with a lower priority than the tester thread waits on a
+ * semaphore with a timeout and signals back on a second semaphore where
+ * the tester waits with a timeout. Both threads are always woken before
+ * their timeout so this measures the cost of arming and disarming the
+ * timeout of a blocking call.<br>
+ * The performance is calculated by measuring the number of iterations after
+ * a second of continuous operations.
+ */
+
+static msg_t thread16(void *p) {
+
+  (void)p;
+  while (chSemWaitTimeout(&sem1, MS2ST(100)) == MSG_OK)
+    chSemSignal(&sem2);
+  return 0;
+}
+
+static void bmk16_setup(void) {
+
+  chSemObjectInit(&sem1, 0);
+  chSemObjectInit(&sem2, 0);
+}
+
+static void bmk16_execute(void) {
+  uint32_t n = 0;
+
+  threads[0] = chThdCreateStatic(wa[0], WA_SIZE, chThdGetPriorityX()-1, thread16, NULL);
+
+  test_wait_tick();
+  test_start_timer(1000);
+  do {
+    chSemSignal(&sem1);
+    chSemWaitTimeout(&sem2, MS2ST(100));
+    n++;
+#if defined(SIMULATOR)
+    ChkIntSources();
+#endif
+  } while (!test_timer_done);
+  chSemReset(&sem1, 0);
+  test_wait_threads();
+
+  test_print("--- Score : ");
+  test_printn(n);
+  test_print(" round trips/S, ");
+  test_printn(n << 1);
+  test_println(" ctxswc/S");
+}
+
+ROMCONST struct testcase testbmk16 = {
+  "Benchmark, semaphores wait with timeout",
+  bmk16_setup,
+  NULL,
+  bmk16_execute
+};
+
+#if CH_CFG_USE_HEAP || defined(__DOXYGEN__)
+/**
+ * @page test_benchmarks_017 Heap allocation and fragmentation
+ *
+ * <h2>Description</h2>
+ * A heap is created over the test buffer, sixteen slots are visited in a
+ * scrambled order and a block of pseudo-random size is allocated in an
+ * empty slot or the block in a busy slot released, into a continuous loop.
+ * <br>
+ * The performance is calculated by measuring the number of operations after
+ * a second of continuous operations, the fragments left while the slots are
+ * still busy and the failed allocations are printed too. The worst
+ * operation time is printed if @p CH_CFG_USE_TM is enabled.
+ */
+
+#define BMK17_SLOTS     16
+
+static memory_heap_t bmk17_heap;
+
+static void bmk17_setup(void) {
+
+  chHeapObjectInit(&bmk17_heap, test.buffer, sizeof(union test_buffers));
+}
+
+static void bmk17_execute(void) {
+  void *slots[BMK17_SLOTS] = {NULL};
+  uint32_t n = 0, fails = 0, seed = 1;
+  size_t frags, sz;
+  unsigned i;
+#if CH_CFG_USE_TM
+  time_measurement_t tm;
+
+  chTMObjectInit(&tm);
+#endif
+
+  test_wait_tick();
+  test_start_timer(1000);
+  do {
+    i = (unsigned)(n * 7U) % BMK17_SLOTS;
+    seed = seed * 1103515245U + 12345U;
+#if CH_CFG_USE_TM
+    chTMStartMeasurementX(&tm);
+#endif
+    if (slots[i] != NULL) {
+      chHeapFree(slots[i]);
+      slots[i] = NULL;
+    }
+    else {
+      slots[i] = chHeapAlloc(&bmk17_heap,
+                             8U + (size_t)((seed >> 16) %
+                                           (sizeof(union test_buffers) / 32U)));
+      if (slots[i] == NULL)
+        fails++;
+    }
+#if CH_CFG_USE_TM
+    chTMStopMeasurementX(&tm);
+#endif
+    n++;
+#if defined(SIMULATOR)
+    ChkIntSources();
+#endif
+  } while (!test_timer_done);
+
+  frags = chHeapStatus(&bmk17_heap, &sz);
+  for (i = 0; i < BMK17_SLOTS; i++) {
+    if (slots[i] != NULL)
+      chHeapFree(slots[i]);
+  }
+
+  test_print("--- Score : ");
+  test_printn(n);
+  test_println(" allocs+frees/S");
+  test_print("--- Score : ");
+  test_printn((uint32_t)frags);
+  test_print(" fragments, ");
+  test_printn((uint32_t)sz);
+  test_print(" bytes free, ");
+  test_printn(fails);
+  test_println(" failed allocs");
+#if CH_CFG_USE_TM
+  test_print("--- Score : ");
+  test_printn(tm.worst);
+  test_println(" cycles worst operation");
+#endif
+}
+
+ROMCONST struct testcase testbmk17 = {
+  "Benchmark, heap allocation",
+  bmk17_setup,
+  NULL,
+  bmk17_execute
+};
+#endif /* CH_CFG_USE_HEAP */
+
+#if CH_CFG_USE_MEMPOOLS || defined(__DOXYGEN__)
+/**
+ * @page test_benchmarks_018 Memory pools allocation under contention
+ *
+ * <h2>Description</h2>
+ * Two objects are allocated from a memory pool and released back into a
+ * continuous loop while a periodic virtual timer allocates and releases
+ * an object of the same pool from the timer interrupt, at the shortest
+ * period a virtual timer supports.<br>
+ * The performance is calculated by measuring the number of iterations after
+ * a second of continuous operations. If @p CH_DBG_STATISTICS is enabled the
+ * number and the worst duration of the threads critical zones entered
+ * during the loop are printed too, compare the results with
+ * @p CH_CFG_USE_MEMPOOLS_LOCKFREE enabled and disabled.
+ */
+
+#define BMK18_OBJECTS   4
+#define BMK18_SIZE      16
+
+static memory_pool_t bmk18_pool;
+static virtual_timer_t bmk18_vt;
+
+static void bmk18_tick(void *p) {
+  void *objp;
+
+  (void)p;
+  chSysLockFromISR();
+  if ((objp = chPoolAllocI(&bmk18_pool)) != NULL)
+    chPoolFreeI(&bmk18_pool, objp);
+  chSysUnlockFromISR();
+}
+
+static void bmk18_setup(void) {
+
+  chPoolObjectInit(&bmk18_pool, BMK18_SIZE, NULL);
+  chPoolLoadArray(&bmk18_pool, test.buffer, BMK18_OBJECTS);
+}
+
+static void bmk18_execute(void) {
+  uint32_t n = 0;
+  void *p1, *p2;
+
+  test_wait_tick();
+  chVTSetPeriodic(&bmk18_vt, BMK_VT_PERIOD, bmk18_tick, NULL);
+#if CH_DBG_STATISTICS
+  chTMObjectInit(&ch.kernel_stats.m_crit_thd);
+#endif
+  test_start_timer(1000);
+  do {
+    p1 = chPoolAlloc(&bmk18_pool);
+    p2 = chPoolAlloc(&bmk18_pool);
+    chPoolFree(&bmk18_pool, p2);
+    chPoolFree(&bmk18_pool, p1);
+    n++;
+#if defined(SIMULATOR)
+    ChkIntSources();
+#endif
+  } while (!test_timer_done);
+  chVTReset(&bmk18_vt);
+
+  test_print("--- Score : ");
+  test_printn(n * 2);
+  test_println(" allocs+frees/S");
+#if CH_DBG_STATISTICS
+  test_print("--- Score : ");
+  test_printn(ch.kernel_stats.m_crit_thd.n);
+  test_print(" critical zones, ");
+  test_printn(ch.kernel_stats.m_crit_thd.worst);
+  test_println(" cycles worst");
+#endif
+}
+
+ROMCONST struct testcase testbmk18 = {
+  "Benchmark, memory pools under contention",
+  bmk18_setup,
+  NULL,
+  bmk18_execute
+};
+#endif /* CH_CFG_USE_MEMPOOLS */
+
+#if CH_CFG_USE_QUEUES || defined(__DOXYGEN__)
+/**
+ * @page test_benchmarks_019 I/O Queues bulk reception
+ *
+ * <h2>Description</h2>
+ * A periodic virtual timer simulates a DMA driven receiver, at each period
+ * the data received since the previous one is appended to an input queue
+ * in place using the span APIs. The tester thread reads the queue in blocks
+ * of 64 bytes while a lower priority thread counts loops in the spare CPU
+ * time. The test is performed at 115200 and 4000000 baud, ten bits per
+ * byte.<br>
+ * The bytes received in a second, the bytes dropped because the queue was
+ * full and the CPU load, compared to a second without traffic, are
+ * printed.
+ */
+
+#define BMK19_BYTES(baud)                                                   \
+  (((baud) / 10U * BMK_VT_PERIOD + CH_CFG_ST_FREQUENCY - 1U) /              \
+   CH_CFG_ST_FREQUENCY)
+
+static input_queue_t bmk19_iq;
+static virtual_timer_t bmk19_vt;
+static size_t bmk19_rate;
+static uint32_t bmk19_dropped;
+static volatile uint32_t bmk19_spare;
+static volatile bool bmk19_stop;
+
+static void bmk19_tick(void *p) {
+  size_t n, k;
+  uint8_t *bp;
+
+  (void)p;
+  chSysLockFromISR();
+  n = bmk19_rate;
+  while ((n > 0) && ((k = chIQGetWriteSpanI(&bmk19_iq, &bp)) > 0)) {
+    /* The data is already in place, written by the simulated DMA.*/
+    if (k > n)
+      k = n;
+    chIQCommitI(&bmk19_iq, k);
+    n -= k;
+  }
+  bmk19_dropped += n;
+  chSysUnlockFromISR();
+}
+
+static msg_t thread19(void *p) {
+
+  (void)p;
+  while (!bmk19_stop)
+    bmk19_spare++;
+  return 0;
+}
+
+static uint32_t bmk19_run(size_t rate) {
+  uint8_t buf[64];
+  uint32_t n = 0;
+
+  bmk19_rate = rate;
+  bmk19_dropped = 0;
+  bmk19_spare = 0;
+  bmk19_stop = false;
+  chIQObjectInit(&bmk19_iq, (uint8_t *)wa[1], WA_SIZE * 4, NULL, NULL);
+  threads[0] = chThdCreateStatic(wa[0], WA_SIZE, chThdGetPriorityX()-1, thread19, NULL);
+
+  test_wait_tick();
+  if (rate > 0)
+    chVTSetPeriodic(&bmk19_vt, BMK_VT_PERIOD, bmk19_tick, NULL);
+  test_start_timer(1000);
+  do {
+    n += chIQReadTimeout(&bmk19_iq, buf, sizeof(buf), MS2ST(10));
+#if defined(SIMULATOR)
+    ChkIntSources();
+#endif
+  } while (!test_timer_done);
+  chVTReset(&bmk19_vt);
+  bmk19_stop = true;
+  test_wait_threads();
+  return n;
+}
+
+static void bmk19_execute(void) {
+  static const uint32_t bauds[] = {115200, 4000000};
+  uint32_t idle, n, load;
+  unsigned i;
+
+  (void)bmk19_run(0);
+  idle = bmk19_spare / 100U + 1U;
+  for (i = 0; i < sizeof(bauds) / sizeof(bauds[0]); i++) {
+    n = bmk19_run(BMK19_BYTES(bauds[i]));
+    load = bmk19_spare / idle;
+    load = load < 100U ? 100U - load : 0U;
+    test_print("--- Score : ");
+    test_printn(n);
+    test_print(" bytes/S, ");
+    test_printn(bmk19_dropped);
+    test_print(" dropped, ");
+    test_printn(load);
+    test_print("% CPU at ");
+    test_printn(bauds[i]);
+    test_println(" baud");
+  }
+}
+
+ROMCONST struct testcase testbmk19 = {
+  "Benchmark, I/O Queues bulk reception",
+  NULL,
+  NULL,
+  bmk19_execute
+};
+#endif /* CH_CFG_USE_QUEUES */
+
 /**
  * @brief   Test sequence for benchmarks.
  */
@@ -710,6 +1299,20 @@ ROMCONST struct testcase * ROMCONST patternbmk[] = {
   &testbmk12,
 #endif
   &testbmk13,
+#if CH_CFG_USE_HEAP || defined(__DOXYGEN__)
+  &testbmk14,
+  &testbmk15,
+#endif
+  &testbmk16,
+#if CH_CFG_USE_HEAP || defined(__DOXYGEN__)
+  &testbmk17,
+#endif
+#if CH_CFG_USE_MEMPOOLS || defined(__DOXYGEN__)
+  &testbmk18,
+#endif
+#if CH_CFG_USE_QUEUES || defined(__DOXYGEN__)
+  &testbmk19,
+#endif
 #endif
   NULL
 };
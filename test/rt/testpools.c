@@ -31,12 +31,14 @@
  * <h2>Preconditions</h2>
  * The module requires the following kernel options:
  * - @p CH_CFG_USE_MEMPOOLS
+ * - @p CH_CFG_USE_SLABS
  * .
  * In case some of the required options are not enabled then some or all tests
  * may be skipped.
  *
  * <h2>Test Cases</h2>
  * - @subpage test_pools_001
+ * - @subpage test_pools_002
  * .
  * @file testpools.c
  * @brief Memory Pools test source file
@@ -104,6 +106,81 @@ ROMCONST struct testcase testpools1 = {
   pools1_execute
 };
 
+#if CH_CFG_USE_SLABS || defined(__DOXYGEN__)
+/**
+ * @page test_pools_002 Slab caches
+ *
+ * <h2>Description</h2>
+ * Objects are allocated from a slab cache until a second slab is needed
+ * then all of them are released.<br>
+ * The test expects the cache to keep one empty slab until it is shrunk,
+ * the released slabs to become idle and an idle slab to be reused by the
+ * next allocation.
+ */
+
+#define POOLS2_SIZE     64
+#define POOLS2_MAX      (CH_CFG_SLAB_SIZE / POOLS2_SIZE + 1)
+
+static slab_cache_t sc1;
+
+static void pools2_setup(void) {
+
+  chSlabCacheObjectInit(&sc1, "test", POOLS2_SIZE);
+}
+
+static void pools2_execute(void) {
+  void *objs[POOLS2_MAX];
+  slab_stats_t st;
+  size_t i, n, idle;
+
+  idle = chSlabStatus();
+
+  /* The first object takes a slab.*/
+  objs[0] = chSlabAlloc(&sc1);
+  test_assert(1, objs[0] != NULL, "allocation failed");
+  chSlabCacheGetStats(&sc1, &st);
+  test_assert(2, (st.ss_slabs == 1) && (st.ss_used == 1), "wrong stats");
+  n = st.ss_capacity;
+  test_assert(3, (n > 0) && (n < POOLS2_MAX), "wrong capacity");
+
+  /* Filling the slab, one more object takes a second slab.*/
+  for (i = 1; i <= n; i++) {
+    objs[i] = chSlabAlloc(&sc1);
+    test_assert(4, objs[i] != NULL, "allocation failed");
+  }
+  chSlabCacheGetStats(&sc1, &st);
+  test_assert(5, (st.ss_slabs == 2) && (st.ss_used == n + 1) &&
+                 (st.ss_capacity == 2 * n) && (st.ss_peak == n + 1),
+              "wrong stats");
+
+  /* Releasing everything, the last empty slab is kept.*/
+  for (i = 0; i <= n; i++)
+    chSlabFree(&sc1, objs[i]);
+  chSlabCacheGetStats(&sc1, &st);
+  test_assert(6, (st.ss_slabs == 1) && (st.ss_used == 0), "wrong stats");
+
+  /* Shrinking returns it.*/
+  chSlabCacheShrink(&sc1);
+  chSlabCacheGetStats(&sc1, &st);
+  test_assert(7, st.ss_slabs == 0, "slabs not returned");
+  test_assert(8, chSlabStatus() == idle + 2, "slabs not idle");
+
+  /* An idle slab is reused.*/
+  objs[0] = chSlabAlloc(&sc1);
+  test_assert(9, chSlabStatus() == idle + 1, "idle slab not reused");
+  chSlabFree(&sc1, objs[0]);
+  chSlabCacheShrink(&sc1);
+  test_assert(10, chSlabStatus() == idle + 2, "slab not returned");
+}
+
+ROMCONST struct testcase testpools2 = {
+  "Memory Pools, slab caches",
+  pools2_setup,
+  NULL,
+  pools2_execute
+};
+#endif /* CH_CFG_USE_SLABS */
+
 #endif /* CH_CFG_USE_MEMPOOLS */
 
 /*
@@ -112,6 +189,9 @@ ROMCONST struct testcase testpools1 = {
 ROMCONST struct testcase * ROMCONST patternpools[] = {
 #if CH_CFG_USE_MEMPOOLS || defined(__DOXYGEN__)
   &testpools1,
+#endif
+#if CH_CFG_USE_SLABS || defined(__DOXYGEN__)
+  &testpools2,
 #endif
   NULL
 };
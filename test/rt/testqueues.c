@@ -43,6 +43,7 @@
  * <h2>Test Cases</h2>
  * - @subpage test_queues_001
  * - @subpage test_queues_002
+ * - @subpage test_queues_003
  * .
  * @file testqueues.c
  * @brief I/O Queues test source file
@@ -230,6 +231,98 @@ ROMCONST struct testcase testqueues2 = {
   NULL,
   queues2_execute
 };
+
+/**
+ * @page test_queues_003 Queues contiguous spans
+ *
+ * <h2>Description</h2>
+ * Data is written and read in place on an @p InputQueue and an
+ * @p OutputQueue using the span APIs, the spans must stop at the buffer
+ * end and the block copies of the read and write functions must handle
+ * data wrapping around it.
+ */
+
+static void queues3_execute(void) {
+  uint8_t *bp;
+  size_t i, n;
+
+  /* Input queue, writing three bytes in place and consuming two.*/
+  chIQObjectInit(&iq, wa[0], TEST_QUEUES_SIZE, notify, NULL);
+  chSysLock();
+  n = chIQGetWriteSpanI(&iq, &bp);
+  chSysUnlock();
+  test_assert(1, n == TEST_QUEUES_SIZE, "wrong write span");
+  bp[0] = 'A';
+  bp[1] = 'B';
+  bp[2] = 'C';
+  chSysLock();
+  chIQCommitI(&iq, 3);
+  n = chIQGetReadSpanI(&iq, &bp);
+  chIQConsumeI(&iq, 2);
+  chSysUnlock();
+  test_assert(2, (n == 3) && (bp[0] == 'A'), "wrong read span");
+
+  /* The free space wraps, the first span ends at the buffer end.*/
+  chSysLock();
+  n = chIQGetWriteSpanI(&iq, &bp);
+  bp[0] = 'D';
+  chIQCommitI(&iq, 1);
+  i = chIQGetWriteSpanI(&iq, &bp);
+  bp[0] = 'E';
+  bp[1] = 'F';
+  chIQCommitI(&iq, 2);
+  chSysUnlock();
+  test_assert(3, (n == 1) && (i == 2), "wrong write span");
+  test_assert_lock(4, chIQIsFullI(&iq), "not full");
+
+  /* Reading across the buffer end.*/
+  n = chIQReadTimeout(&iq, wa[1], TEST_QUEUES_SIZE, TIME_IMMEDIATE);
+  test_assert(5, n == TEST_QUEUES_SIZE, "wrong returned size");
+  for (i = 0; i < n; i++)
+    test_emit_token(((uint8_t *)wa[1])[i]);
+  test_assert_sequence(6, "CDEF");
+
+  /* Output queue, writing across the buffer end.*/
+  chOQObjectInit(&oq, wa[0], TEST_QUEUES_SIZE, notify, NULL);
+  chSysLock();
+  n = chOQGetWriteSpanI(&oq, &bp);
+  bp[0] = 'A';
+  bp[1] = 'B';
+  bp[2] = 'C';
+  chOQCommitI(&oq, 3);
+  chOQConsumeI(&oq, 2);
+  chSysUnlock();
+  test_assert(7, n == TEST_QUEUES_SIZE, "wrong write span");
+  n = chOQWriteTimeout(&oq, (const uint8_t *)"DEF", 3, TIME_IMMEDIATE);
+  test_assert(8, n == 3, "wrong returned size");
+
+  /* Reading it back in place, two spans.*/
+  chSysLock();
+  n = chOQGetReadSpanI(&oq, &bp);
+  chSysUnlock();
+  test_assert(9, n == 2, "wrong read span");
+  for (i = 0; i < n; i++)
+    test_emit_token(bp[i]);
+  chSysLock();
+  chOQConsumeI(&oq, n);
+  n = chOQGetReadSpanI(&oq, &bp);
+  chSysUnlock();
+  test_assert(10, n == 2, "wrong read span");
+  for (i = 0; i < n; i++)
+    test_emit_token(bp[i]);
+  chSysLock();
+  chOQConsumeI(&oq, n);
+  chSysUnlock();
+  test_assert_sequence(11, "CDEF");
+  test_assert_lock(12, chOQGetFullI(&oq) == 0, "not empty");
+}
+
+ROMCONST struct testcase testqueues3 = {
+  "Queues, contiguous spans",
+  NULL,
+  NULL,
+  queues3_execute
+};
 #endif /* CH_CFG_USE_QUEUES */
 
 /**
@@ -239,6 +332,7 @@ ROMCONST struct testcase * ROMCONST patternqueues[] = {
 #if CH_CFG_USE_QUEUES || defined(__DOXYGEN__)
   &testqueues1,
   &testqueues2,
+  &testqueues3,
 #endif
   NULL
 };
@@ -40,6 +40,7 @@
  * - @subpage test_threads_002
  * - @subpage test_threads_003
  * - @subpage test_threads_004
+ * - @subpage test_threads_005
  * .
  * @file testthd.c
  * @brief Threads and Scheduler test source file
@@ -219,6 +220,69 @@ ROMCONST struct testcase testthd4 = {
   thd4_execute
 };
 
+/**
+ * @page test_threads_005 Periodic timers test
+ *
+ * <h2>Description</h2>
+ * A periodic virtual timer with a two ticks period is left running for
+ * five hundred periods, its last deadline is verified to be exactly a
+ * thousand ticks after the start. A thread loop using @p chThdSleepPeriod() and
+ * doing some work in each period is then verified to wake up at the exact
+ * expected time.
+ */
+
+#define THD5_PERIOD     2
+#define THD5_PERIODS    500
+
+static virtual_timer_t vt5;
+static unsigned thd5_count;
+static systime_t thd5_last;
+
+static void thd5_tick(void *p) {
+
+  (void)p;
+  chSysLockFromISR();
+  thd5_last = chVTGetSystemTimeX();
+  if (++thd5_count == THD5_PERIODS)
+    chVTDoResetI(&vt5);
+  chSysUnlockFromISR();
+}
+
+static void thd5_execute(void) {
+  systime_t time;
+  unsigned i;
+
+  /* Periodic timer, in tickless mode it can run late by the minimum
+     alarm delta but the deadlines must not drift.*/
+  thd5_count = 0;
+  test_wait_tick();
+  chSysLock();
+  time = chVTGetSystemTimeX() + THD5_PERIOD * THD5_PERIODS;
+  chVTSetPeriodicI(&vt5, THD5_PERIOD, thd5_tick, NULL);
+  chSysUnlock();
+  chThdSleepUntil(time + 10);
+  test_assert(1, thd5_count == THD5_PERIODS, "wrong number of periods");
+  test_assert(2, chVTIsTimeWithinX(thd5_last, time,
+                                   time + CH_CFG_ST_TIMEDELTA + 1),
+              "periodic timer drifted");
+
+  /* Periodic thread loop.*/
+  time = chVTGetSystemTime();
+  for (i = 0; i < 10; i++) {
+    chThdSleepPeriod(&time, MS2ST(10));
+    chThdSleepMilliseconds(3);
+  }
+  chThdSleepPeriod(&time, MS2ST(10));
+  test_assert_time_window(3, time, time + 1);
+}
+
+ROMCONST struct testcase testthd5 = {
+  "Threads, periodic timers",
+  NULL,
+  NULL,
+  thd5_execute
+};
+
 /**
  * @brief   Test sequence for threads.
  */
@@ -227,5 +291,6 @@ ROMCONST struct testcase * ROMCONST patternthd[] = {
   &testthd2,
   &testthd3,
   &testthd4,
+  &testthd5,
   NULL
 };